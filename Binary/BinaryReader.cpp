@@ -0,0 +1,130 @@
+﻿#include "BinaryReader.h"
+#include <cstring>
+
+/**
+ * @brief Constructor for a reader of a binary stream.
+ * @param in Source stream.
+ * @param capacity Size of the buffer.
+ */
+BinaryReader::BinaryReader(std::istream& in, std::size_t capacity) : in(in), buffer(new char[capacity]),
+    capacity(capacity), pos(0), end(0), consumed(0), failed(false) {  }
+
+/**
+ * @brief Reads the next buffer-full from the stream.
+ * @return True if at least one byte was read, otherwise false.
+ */
+bool BinaryReader::refill() {
+    in.read(buffer.get(), static_cast<std::streamsize>(capacity));
+    pos = 0;
+    end = static_cast<std::size_t>(in.gcount());
+    return end > 0;
+}
+
+/**
+ * @brief Reads raw bytes; large blocks bypass the buffer.
+ *
+ * Whatever is left in the buffer is used first; a remainder at least as large as the buffer
+ * is read from the stream directly, a smaller one after a refill.
+ *
+ * @param data Receives the bytes.
+ * @param size Number of bytes.
+ * @return True if all bytes were read, otherwise false.
+ */
+bool BinaryReader::readBytes(void* data, std::size_t size) {
+    if (failed) {
+        return false;
+    }
+    char* dest = static_cast<char*>(data);
+    while (size > 0) {
+        if (pos == end) {
+            if (size >= capacity) {
+                in.read(dest, static_cast<std::streamsize>(size));
+                std::size_t got = static_cast<std::size_t>(in.gcount());
+                consumed += got;
+                failed = got != size;
+                return !failed;
+            }
+            if (!refill()) {
+                failed = true;
+                return false;
+            }
+        }
+        std::size_t chunk = end - pos < size ? end - pos : size;
+        std::memcpy(dest, buffer.get() + pos, chunk);
+        pos += chunk;
+        dest += chunk;
+        size -= chunk;
+        consumed += chunk;
+    }
+    return true;
+}
+
+/**
+ * @brief Skips bytes without decoding them.
+ * @param size Number of bytes.
+ * @return True if all bytes were skipped, otherwise false.
+ */
+bool BinaryReader::skipBytes(std::uint64_t size) {
+    if (failed) {
+        return false;
+    }
+    while (size > 0) {
+        if (pos == end && !refill()) {
+            failed = true;
+            return false;
+        }
+        std::size_t chunk = end - pos < size ? end - pos : static_cast<std::size_t>(size);
+        pos += chunk;
+        size -= chunk;
+        consumed += chunk;
+    }
+    return true;
+}
+
+/**
+ * @brief Reads a string prefixed with its size as a 32-bit unsigned integer.
+ * @param value Receives the string.
+ * @return True if the string was read, otherwise false.
+ */
+bool BinaryReader::readString(std::string& value) {
+    unsigned int size = 0;
+    if (!read(size)) {
+        return false;
+    }
+    value.resize(size);
+    return size == 0 || readBytes(&value[0], size);
+}
+
+/**
+ * @brief Reads a string field.
+ * @param value Receives the string.
+ */
+void BinaryReader::readField(std::string& value) {
+    readString(value);
+}
+
+/**
+ * @brief Reads a text field into owned storage.
+ * @param value Receives the text.
+ */
+void BinaryReader::readField(Text& value) {
+    std::string text;
+    readString(text);
+    value = text;
+}
+
+/**
+ * @brief Checks whether every read so far succeeded.
+ * @return True if no read failed, otherwise false.
+ */
+bool BinaryReader::good() const {
+    return !failed;
+}
+
+/**
+ * @brief Returns the number of bytes read so far.
+ * @return Number of bytes.
+ */
+std::uint64_t BinaryReader::getBytesRead() const {
+    return consumed;
+}
@@ -0,0 +1,158 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <istream>
+#include <memory>
+#include <string>
+#include <type_traits>
+#include "Text.h"
+
+/**
+ * @class BinaryReader
+ * @brief Buffered reader of binary values, shared by the legacy file readers of all entities.
+ *
+ * The stream is read one buffer-full at a time and values are decoded from memory.
+ * Runs of plain values such as ID arrays are copied in bulk. Once a read runs past the end
+ * of the stream the reader fails and every later read fails too.
+ *
+ * Entities describe their stored fields once, in a static schema template; calling the reader
+ * with fields decodes them in order. Files are only written as snapshots, so there is no writer.
+ */
+class BinaryReader {
+private:
+    std::istream& in; /**< Source stream. */
+    std::unique_ptr<char[]> buffer; /**< Bytes read ahead from the stream. */
+    std::size_t capacity; /**< Size of the buffer. */
+    std::size_t pos; /**< Position of the next byte to decode. */
+    std::size_t end; /**< Number of valid bytes in the buffer. */
+    std::uint64_t consumed; /**< Number of bytes decoded so far. */
+    bool failed; /**< Whether a read ran past the end of the stream. */
+
+    /**
+     * @brief Reads the next buffer-full from the stream.
+     * @return True if at least one byte was read, otherwise false.
+     */
+    bool refill();
+
+public:
+    static const std::size_t DEFAULT_CAPACITY = 1u << 20; /**< Default buffer size, 1 MiB. */
+
+    /**
+     * @brief Constructor for a reader of a binary stream.
+     * @param in Source stream.
+     * @param capacity Size of the buffer.
+     */
+    explicit BinaryReader(std::istream& in, std::size_t capacity = DEFAULT_CAPACITY);
+
+    BinaryReader(const BinaryReader& other) = delete;
+    BinaryReader& operator=(const BinaryReader& other) = delete;
+
+    /**
+     * @brief Reads raw bytes; large blocks bypass the buffer.
+     * @param data Receives the bytes.
+     * @param size Number of bytes.
+     * @return True if all bytes were read, otherwise false.
+     */
+    bool readBytes(void* data, std::size_t size);
+
+    /**
+     * @brief Skips bytes without decoding them.
+     * @param size Number of bytes.
+     * @return True if all bytes were skipped, otherwise false.
+     */
+    bool skipBytes(std::uint64_t size);
+
+    /**
+     * @brief Reads a plain value stored in its in-memory representation.
+     * @param value Receives the value.
+     * @return True if the value was read, otherwise false.
+     */
+    template <typename T>
+    bool read(T& value) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read directly");
+        return readBytes(&value, sizeof(T));
+    }
+
+    /**
+     * @brief Reads a run of plain values with a single copy.
+     * @param values Receives the values.
+     * @param count Number of values.
+     * @return True if all values were read, otherwise false.
+     */
+    template <typename T>
+    bool readArray(T* values, std::size_t count) {
+        static_assert(std::is_trivially_copyable<T>::value, "only plain values can be read directly");
+        return readBytes(values, sizeof(T) * count);
+    }
+
+    /**
+     * @brief Reads a string prefixed with its size as a 32-bit unsigned integer.
+     * @param value Receives the string.
+     * @return True if the string was read, otherwise false.
+     */
+    bool readString(std::string& value);
+
+    /**
+     * @brief Reads fields in order, each decoded according to its type.
+     * @param fields Receive the fields.
+     */
+    template <typename... Fields>
+    void operator()(Fields&... fields) {
+        (readField(fields), ...);
+    }
+
+    /**
+     * @brief Reads one field: plain values are copied, entities are read by their schema.
+     * @param value Receives the field.
+     */
+    template <typename T>
+    void readField(T& value) {
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            read(value);
+        }
+        else {
+            T::schema(*this, value);
+        }
+    }
+
+    /**
+     * @brief Reads a string field.
+     * @param value Receives the string.
+     */
+    void readField(std::string& value);
+
+    /**
+     * @brief Reads a text field into owned storage.
+     * @param value Receives the text.
+     */
+    void readField(Text& value);
+
+    /**
+     * @brief Reads a run of fields; plain values are copied with a single call.
+     * @param values Receive the fields.
+     * @param count Number of fields.
+     */
+    template <typename T>
+    void elements(T* values, std::size_t count) {
+        if constexpr (std::is_trivially_copyable<T>::value) {
+            readArray(values, count);
+        }
+        else {
+            for (std::size_t i = 0; i < count && !failed; i++) {
+                readField(values[i]);
+            }
+        }
+    }
+
+    /**
+     * @brief Checks whether every read so far succeeded.
+     * @return True if no read failed, otherwise false.
+     */
+    bool good() const;
+
+    /**
+     * @brief Returns the number of bytes read so far.
+     * @return Number of bytes.
+     */
+    std::uint64_t getBytesRead() const;
+};
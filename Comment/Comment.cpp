@@ -1,66 +1,18 @@
 ﻿#include "Comment.h"
 
-/**
- * @brief Increases the capacity of the array of voted users.
- */
-void Comment::resizeVotedUsers() {
-    votedUsersCapacity *= 2;
-    unsigned int* newArr = new unsigned int[votedUsersCapacity];
-    for (size_t i = 0; i < votedUsersNum; i++) {
-        newArr[i] = votedUsers[i];
-    }
-    delete[] votedUsers;
-    votedUsers = newArr;
-}
-
-/**
- * @brief Sorts the array of voted users using insertion method.
- */
-void Comment::sortVotedUsers() {
-    int key;
-    int j;
-    for (int i = 1; i < votedUsersNum; i++) {
-        key = votedUsers[i];
-        j = i - 1;
-        while (j >= 0 && votedUsers[j] > key) {
-            votedUsers[j + 1] = votedUsers[j];
-            j--;
-        }
-        votedUsers[j + 1] = key;
-    }
-}
-
 /**
  * @brief Constructor with parameters.
- * @param comment Comment text.
- * @param authorId Comment author ID.
- * @param commentId Unique comment identifier.
+ * @param table The comment table.
+ * @param slot Slot of the comment in the table.
  */
-Comment::Comment(const std::string& comment, unsigned int authorId, unsigned int commentId) : votedUsersCapacity(2) {
-    setCommentText(comment);
-    setAuthorId(authorId);
-    id = commentId;
-    commentRating = 0;
-
-    votedUsers = new unsigned int[votedUsersCapacity];
-    votedUsersNum = 0;
-
-    replyNum = 0;
-}
-
-/**
- * @brief Default constructor.
- */
-Comment::Comment() : commentText(""), authorId(0), id(0), commentRating(0), votedUsersCapacity(2), votedUsersNum(0), replyNum(0) {
-    votedUsers = new unsigned int[votedUsersCapacity];
-}
+Comment::Comment(CommentTable& table, unsigned int slot) : table(&table), slot(slot) {  }
 
 /**
  * @brief Sets the comment text.
  * @param text The new comment text.
  */
 void Comment::setCommentText(const std::string& text) {
-    commentText = text;
+    table->setText(slot, text);
 }
 
 /**
@@ -68,24 +20,23 @@ void Comment::setCommentText(const std::string& text) {
  * @param authorId Author ID.
  */
 void Comment::setAuthorId(unsigned int authorId) {
-    this->authorId = authorId;
+    table->setAuthorId(slot, authorId);
 }
 
 /**
- * @brief Adds a reply to the comment.
- * @param replyText Reply text.
- * @param authorId Reply author ID.
+ * @brief Sets the unique comment identifier.
+ * @param commentId Comment ID.
  */
-void Comment::addReply(const std::string& replyText, unsigned int authorId) {
-    replies.emplace_back(replyText, authorId, replyNum++);
+void Comment::setCommentId(unsigned int commentId) {
+    table->setId(slot, commentId);
 }
 
 /**
  * @brief Returns the comment text.
- * @return Comment text.
+ * @return View of the text of the comment, valid until the text is changed or comments are removed.
  */
-std::string Comment::getCommentText() const {
-    return commentText;
+std::string_view Comment::getCommentText() const {
+    return table->getText(slot);
 }
 
 /**
@@ -93,7 +44,7 @@ std::string Comment::getCommentText() const {
  * @return Author ID.
  */
 unsigned int Comment::getAuthorId() const {
-    return authorId;
+    return table->getAuthorId(slot);
 }
 
 /**
@@ -101,7 +52,7 @@ unsigned int Comment::getAuthorId() const {
  * @return Unique comment identifier.
  */
 unsigned int Comment::getCommentId() const {
-    return id;
+    return table->getId(slot);
 }
 
 /**
@@ -109,7 +60,7 @@ unsigned int Comment::getCommentId() const {
  * @return Comment rating.
  */
 int Comment::getCommentRating() const {
-    return commentRating;
+    return table->getRating(slot);
 }
 
 /**
@@ -117,93 +68,22 @@ int Comment::getCommentRating() const {
  * @return Number of users who voted.
  */
 unsigned int Comment::getVotedUsersNum() const {
-    return votedUsersNum;
-}
-
-/**
- * @brief Returns a pointer to the array of voted users.
- * @return Pointer to the array of voted users.
- */
-const unsigned int* Comment::getVotedUsers() const {
-    return votedUsers;
-}
-
-/**
- * @brief Returns the number of replies.
- * @return Number of replies.
- */
-unsigned int Comment::getReplyNum() const {
-    return replyNum;
-}
-
-/**
- * @brief Saves replies to a file.
- * @param of Output file stream.
- */
-void Comment::writeRepliesToFile(std::ofstream& of) const {
-    of.write(reinterpret_cast<const char*>(&replies[0]), replies.size() * sizeof(replies));
-    /* read from file
-        const size_t count = filesize / sizeof(T);
-        std::vector<T> vec(count);
-        strm.read(reinterpret_cast<char*>(&vec[0]), count*sizeof(T));
-    */
-}
-
-/**
- * @brief Prints the comment and replies.
- */
-void Comment::printCommentAndReplies() const {
-    std::cout << "From user " << authorId << ": " << commentText << ", rating: " << commentRating << "{id: " << id << "}\n";
-    for (const Comment& reply : replies) {
-        std::cout << "   ";
-        reply.printCommentAndReplies();
-    }
+    return table->getVoters(slot).size();
 }
 
 /**
- * @brief Saves the comment to a file.
- * @param of Output file stream.
+ * @brief Prints the comment on one line.
  */
-void Comment::writeToFile(std::ofstream& of) {
-    unsigned int size = commentText.size();
-    of.write(reinterpret_cast<const char*>(&size), sizeof(size));
-    of.write((const char*)&commentText[0], size);
-
-    of.write(reinterpret_cast<const char*>(&authorId), sizeof(authorId));
-    of.write(reinterpret_cast<const char*>(&id), sizeof(id));
-    of.write(reinterpret_cast<const char*>(&commentRating), sizeof(commentRating));
-
-    // information about users who have already voted on the comment
-    of.write(reinterpret_cast<const char*>(&votedUsersNum), sizeof(votedUsersNum));
-    of.write(reinterpret_cast<const char*>(votedUsers), sizeof(unsigned int) * votedUsersNum);
-
-    of.write(reinterpret_cast<const char*>(&replyNum), sizeof(replyNum));
-    writeRepliesToFile(of);
+void Comment::printComment() const {
+    std::cout << "From user " << table->getAuthorId(slot) << ": " << table->getText(slot) << ", rating: " << table->getRating(slot) << "{id: " << table->getId(slot) << "}\n";
 }
 
 /**
  * @brief Reads the comment from a file.
- * @param iff Input file stream.
+ * @param reader Binary reader.
  */
-void Comment::readFromFile(std::ifstream& iff) {
-    unsigned int size = 0;
-    iff.read(reinterpret_cast<char*>(&size), sizeof(size));
-    commentText.resize(size);
-    iff.read((char*)&commentText[0], size);
-
-    iff.read(reinterpret_cast<char*>(&authorId), sizeof(authorId));
-    iff.read(reinterpret_cast<char*>(&id), sizeof(id));
-    iff.read(reinterpret_cast<char*>(&commentRating), sizeof(commentRating));
-
-    iff.read(reinterpret_cast<char*>(&votedUsersNum), sizeof(votedUsersNum));
-    while (votedUsersCapacity <= votedUsersNum) {
-        resizeVotedUsers();
-    }
-    iff.read(reinterpret_cast<char*>(votedUsers), sizeof(unsigned int) * votedUsersNum);
-
-    iff.read(reinterpret_cast<char*>(&replyNum), sizeof(replyNum));
-    replies.resize(replyNum);
-    iff.read(reinterpret_cast<char*>(&replies[0]), sizeof(replies) * replyNum);
+void Comment::readFromFile(BinaryReader& reader) {
+    schema(reader, *this);
 }
 
 /**
@@ -211,14 +91,7 @@ void Comment::readFromFile(std::ifstream& iff) {
  * @param currUserId Current user ID.
  */
 void Comment::commentRatingIncrement(unsigned int currUserId) {
-    commentRating++;
-
-    votedUsers[votedUsersNum] = currUserId;
-    votedUsersNum++;
-    sortVotedUsers();
-    if (votedUsersNum >= votedUsersCapacity) {
-        resizeVotedUsers();
-    }
+    table->vote(slot, currUserId, true);
 }
 
 /**
@@ -226,14 +99,7 @@ void Comment::commentRatingIncrement(unsigned int currUserId) {
  * @param currUserId Current user ID.
  */
 void Comment::commentRatingDecrement(unsigned int currUserId) {
-    commentRating--;
-
-    votedUsers[votedUsersNum] = currUserId;
-    votedUsersNum++;
-    sortVotedUsers();
-    if (votedUsersNum >= votedUsersCapacity) {
-        resizeVotedUsers();
-    }
+    table->vote(slot, currUserId, false);
 }
 
 /**
@@ -241,11 +107,53 @@ void Comment::commentRatingDecrement(unsigned int currUserId) {
  * @param userId User ID.
  * @return Returns true if the user has already voted, otherwise false.
  */
-bool Comment::DidUserAlreadyVote(unsigned int userId) {
-    for (size_t i = 0; i < votedUsersNum; i++) {
-        if (votedUsers[i] == userId) {
-            return true;
-        }
+bool Comment::DidUserAlreadyVote(unsigned int userId) const {
+    return table->getVoters(slot).contains(userId);
+}
+
+/**
+ * @brief Fills a reserved comment record of a snapshot.
+ * @param writer Snapshot writer.
+ * @param index Index of the reserved comment record.
+ * @param firstReply Index of the block reserved for the replies.
+ * @param replyNum Number of replies.
+ */
+void Comment::writeToSnapshot(SnapshotWriter& writer, std::uint32_t index, std::uint32_t firstReply, std::uint32_t replyNum) const {
+    SnapshotCommentRecord record{};
+    const VoterSet& voters = table->getVoters(slot);
+    record.text = writer.addString(table->getText(slot));
+    record.authorId = table->getAuthorId(slot);
+    record.id = table->getId(slot);
+    record.rating = table->getRating(slot);
+    std::vector<std::uint32_t> votedUsers(voters.size());
+    voters.copyTo(votedUsers.data());
+    record.votedUsersNum = voters.size();
+    record.firstVoter = writer.addVoters(votedUsers.data(), voters.size());
+    record.firstReply = firstReply;
+    record.replyNum = replyNum;
+    writer.commentAt(index) = record;
+}
+
+/**
+ * @brief Reads the comment from a snapshot record, the discussion reads the replies.
+ * @param reader Snapshot reader.
+ * @param record The comment record.
+ * @return True if the record is valid, otherwise false.
+ */
+bool Comment::readFromSnapshot(const SnapshotReader& reader, const SnapshotCommentRecord& record) {
+    std::string_view text;
+    if (!reader.getString(record.text, text) || record.votedUsersNum > reader.getHeader().voterCount) {
+        return false;
+    }
+    table->borrowText(slot, text);
+    table->setAuthorId(slot, record.authorId);
+    table->setId(slot, record.id);
+    table->setRating(slot, record.rating);
+
+    std::vector<std::uint32_t> votedUsers(record.votedUsersNum);
+    if (!reader.getVoters(record.firstVoter, record.votedUsersNum, votedUsers.data())) {
+        return false;
     }
-    return false;
+    table->setVoters(slot, votedUsers.data(), votedUsers.size());
+    return true;
 }
@@ -1,48 +1,28 @@
 ﻿#pragma once
 #include <vector>
 #include "User.h"
+#include "Text.h"
+#include "CommentTable.h"
 
 /**
  * @class Comment
- * @brief Class that represents a comment with replies and rating.
+ * @brief View of one comment or reply with its rating in the comment table of a discussion.
+ *
+ * Replies are comments too; the discussion keeps them all in one table and links
+ * every reply to the comment it answers. A view is only valid until the table changes size.
  */
 class Comment {
 private:
-    std::string commentText;  /**< Comment text. */
-    unsigned int authorId;  /**< Comment author ID. */
-    unsigned int id;  /**< Unique comment identifier. */
-    int commentRating;  /**< Comment rating. */
-
-    unsigned int* votedUsers;  /**< Array of users who voted on the comment. */
-    unsigned int votedUsersCapacity;  /**< Capacity of the array of voting users. */
-    unsigned int votedUsersNum;  /**< Number of users who voted. */
-
-    std::vector<Comment> replies;  /**< Vector of replies to the comment. */
-    unsigned int replyNum;  /**< Number of replies. */
-
-    /**
-     * @brief Increases the capacity of the array of voting users.
-     */
-    void resizeVotedUsers();
-
-    /**
-     * @brief Sorts the array of voted users.
-     */
-    void sortVotedUsers();
+    CommentTable* table;  /**< The comment table. */
+    unsigned int slot;  /**< Slot of the comment in the table. */
 
 public:
     /**
      * @brief Constructor with parameters.
-     * @param comment Comment text.
-     * @param authorId Comment author ID.
-     * @param commentId Unique comment identifier.
+     * @param table The comment table.
+     * @param slot Slot of the comment in the table.
      */
-    Comment(const std::string& comment, const unsigned int authorId, const unsigned int commentId);
-
-    /**
-     * @brief Default constructor.
-     */
-    Comment();
+    Comment(CommentTable& table, unsigned int slot);
 
     /**
      * @brief Sets the comment text.
@@ -57,17 +37,16 @@ public:
     void setAuthorId(unsigned int authorId);
 
     /**
-     * @brief Adds a reply to the comment.
-     * @param replyText Reply text.
-     * @param authorId Reply author ID.
+     * @brief Sets the unique comment identifier.
+     * @param commentId Comment ID.
      */
-    void addReply(const std::string& replyText, unsigned int authorId);
+    void setCommentId(unsigned int commentId);
 
     /**
      * @brief Returns the comment text.
-     * @return The text of the comment.
+     * @return View of the text of the comment, valid until the text is changed or comments are removed.
      */
-    std::string getCommentText() const;
+    std::string_view getCommentText() const;
 
     /**
      * @brief Returns the comment author ID.
@@ -94,39 +73,46 @@ public:
     unsigned int getVotedUsersNum() const;
 
     /**
-     * @brief Returns a pointer to array of voted users.
-     * @return Pointer of the array of voted users.
-     */
-    const unsigned int* getVotedUsers() const;
-
-    /**
-     * @brief Returns the number of replies.
-     * @return Number of replies.
-     */
-    unsigned int getReplyNum() const;
-
-    /**
-     * @brief Saves replies to a file.
-     * @param of Output file stream.
-     */
-    void writeRepliesToFile(std::ofstream& of) const;
-
-    /**
-     * @brief Prints the comment and replies.
-     */
-    void printCommentAndReplies() const;
-
-    /**
-     * @brief Saves the comment to a file.
-     * @param of Output file stream.
-     */
-    void writeToFile(std::ofstream& of);
+     * @brief Prints the comment on one line.
+     */
+    void printComment() const;
+
+    /**
+     * @brief Lists the fields of a comment stored in old-format files.
+     *
+     * Instantiated with BinaryReader to load a comment; files are only written as snapshots.
+     * The number of replies and the replies follow, read by the discussion. A loaded text
+     * is copied into the arena of the table.
+     *
+     * @param archive Binary reader.
+     * @param self The comment.
+     */
+    template <typename Archive, typename Self>
+    static void schema(Archive& archive, Self& self) {
+        Text commentText;
+        unsigned int authorId = 0;
+        unsigned int id = 0;
+        int commentRating = 0;
+        // voters are stored as their number followed by the IDs in ascending order
+        unsigned int votedUsersNum = 0;
+        archive(commentText, authorId, id, commentRating, votedUsersNum);
+        if (!archive.good()) {
+            return;
+        }
+        std::vector<std::uint32_t> votedUsers(votedUsersNum);
+        archive.elements(votedUsers.data(), votedUsers.size());
+        self.table->setText(self.slot, commentText.view());
+        self.setAuthorId(authorId);
+        self.setCommentId(id);
+        self.table->setRating(self.slot, commentRating);
+        self.table->setVoters(self.slot, votedUsers.data(), votedUsers.size());
+    }
 
     /**
      * @brief Reads the comment from a file.
-     * @param iff Input file stream.
+     * @param reader Binary reader.
      */
-    void readFromFile(std::ifstream& iff);
+    void readFromFile(BinaryReader& reader);
 
     /**
      * @brief Increases the rating of the comment from the current user.
@@ -145,5 +131,22 @@ public:
      * @param userId User ID.
      * @return Returns true if the user has already voted, otherwise false.
      */
-    bool DidUserAlreadyVote(unsigned int userId);
-};
+    bool DidUserAlreadyVote(unsigned int userId) const;
+
+    /**
+     * @brief Fills a reserved comment record of a snapshot.
+     * @param writer Snapshot writer.
+     * @param index Index of the reserved comment record.
+     * @param firstReply Index of the block reserved for the replies.
+     * @param replyNum Number of replies.
+     */
+    void writeToSnapshot(SnapshotWriter& writer, std::uint32_t index, std::uint32_t firstReply, std::uint32_t replyNum) const;
+
+    /**
+     * @brief Reads the comment from a snapshot record, the discussion reads the replies.
+     * @param reader Snapshot reader.
+     * @param record The comment record.
+     * @return True if the record is valid, otherwise false.
+     */
+    bool readFromSnapshot(const SnapshotReader& reader, const SnapshotCommentRecord& record);
+};
\ No newline at end of file
@@ -0,0 +1,319 @@
+﻿#include "CommentTable.h"
+
+/**
+ * @brief Default constructor, creates an empty table.
+ */
+CommentTable::CommentTable() {  }
+
+/**
+ * @brief Copy constructor; texts stored in the arena of the other table are copied into the own arena.
+ * @param other The table to be copied.
+ */
+CommentTable::CommentTable(const CommentTable& other) {
+    *this = other;
+}
+
+/**
+ * @brief Move constructor, takes over the columns and the arena.
+ * @param other The table whose data will be taken over; it is left empty.
+ */
+CommentTable::CommentTable(CommentTable&& other) noexcept {
+    *this = std::move(other);
+}
+
+/**
+ * @brief Assignment operator; texts stored in the arena of the other table are copied into the own arena.
+ *
+ * Texts borrowed from a snapshot stay borrowed, the copy needs the mapping as much as the original.
+ *
+ * @param other The table to be copied.
+ * @return Reference to this table.
+ */
+CommentTable& CommentTable::operator=(const CommentTable& other) {
+    if (this == &other) {
+        return *this;
+    }
+    ids = other.ids;
+    authorIds = other.authorIds;
+    ratings = other.ratings;
+    texts = other.texts;
+    voters = other.voters;
+    arena.clear();
+    for (std::string_view& text : texts) {
+        if (!text.empty() && other.arena.owns(text.data())) {
+            text = arena.store(text);
+        }
+    }
+    return *this;
+}
+
+/**
+ * @brief Move assignment operator, takes over the columns and the arena.
+ * @param other The table whose data will be taken over; it is left empty.
+ * @return Reference to this table.
+ */
+CommentTable& CommentTable::operator=(CommentTable&& other) noexcept {
+    if (this != &other) {
+        ids = std::move(other.ids);
+        authorIds = std::move(other.authorIds);
+        ratings = std::move(other.ratings);
+        texts = std::move(other.texts);
+        voters = std::move(other.voters);
+        arena = std::move(other.arena);
+        other.clear();
+    }
+    return *this;
+}
+
+/**
+ * @brief Returns the number of slots.
+ * @return Number of comments and replies.
+ */
+unsigned int CommentTable::size() const {
+    return static_cast<unsigned int>(ids.size());
+}
+
+/**
+ * @brief Reserves room for a number of slots.
+ * @param capacity Number of slots.
+ */
+void CommentTable::reserve(unsigned int capacity) {
+    ids.reserve(capacity);
+    authorIds.reserve(capacity);
+    ratings.reserve(capacity);
+    texts.reserve(capacity);
+    voters.reserve(capacity);
+}
+
+/**
+ * @brief Removes all slots and frees the arena.
+ */
+void CommentTable::clear() {
+    ids.clear();
+    authorIds.clear();
+    ratings.clear();
+    texts.clear();
+    voters.clear();
+    arena.clear();
+}
+
+/**
+ * @brief Appends a slot with no rating and no voters; the text is copied into the arena.
+ * @param text Comment text.
+ * @param authorId Comment author ID.
+ * @param commentId Unique comment identifier.
+ * @return The new slot.
+ */
+unsigned int CommentTable::append(std::string_view text, unsigned int authorId, unsigned int commentId) {
+    ids.push_back(commentId);
+    authorIds.push_back(authorId);
+    ratings.push_back(0);
+    texts.push_back(arena.store(text));
+    voters.emplace_back();
+    return size() - 1;
+}
+
+/**
+ * @brief Moves the data of one slot into an earlier one, as the table closes a gap.
+ * @param from Slot whose data is moved.
+ * @param to Slot that receives it.
+ */
+void CommentTable::moveSlot(unsigned int from, unsigned int to) {
+    ids[to] = ids[from];
+    authorIds[to] = authorIds[from];
+    ratings[to] = ratings[from];
+    texts[to] = texts[from];
+    voters[to] = std::move(voters[from]);
+}
+
+/**
+ * @brief Drops all slots from the given one on.
+ * @param newSize Number of slots that remain.
+ */
+void CommentTable::truncate(unsigned int newSize) {
+    ids.resize(newSize);
+    authorIds.resize(newSize);
+    ratings.resize(newSize);
+    texts.resize(newSize);
+    voters.resize(newSize);
+}
+
+/**
+ * @brief Frees the text and voters of a removed slot and resets its rating.
+ *
+ * The rating becomes 0, so passes over the rating column need not skip the slot.
+ * The text stays in the arena until the next compaction of the texts.
+ *
+ * @param slot The slot, reclaimed when the owner of the table closes the gap.
+ */
+void CommentTable::clearSlot(unsigned int slot) {
+    ratings[slot] = 0;
+    texts[slot] = std::string_view();
+    voters[slot].clear();
+}
+
+/**
+ * @brief Returns the ID of a slot.
+ * @param slot The slot.
+ * @return Unique comment identifier.
+ */
+unsigned int CommentTable::getId(unsigned int slot) const {
+    return ids[slot];
+}
+
+/**
+ * @brief Returns the author of a slot.
+ * @param slot The slot.
+ * @return Author ID.
+ */
+unsigned int CommentTable::getAuthorId(unsigned int slot) const {
+    return authorIds[slot];
+}
+
+/**
+ * @brief Returns the rating of a slot.
+ * @param slot The slot.
+ * @return Rating.
+ */
+int CommentTable::getRating(unsigned int slot) const {
+    return ratings[slot];
+}
+
+/**
+ * @brief Returns the text of a slot.
+ * @param slot The slot.
+ * @return View of the text, valid until the text is replaced or the table is changed.
+ */
+std::string_view CommentTable::getText(unsigned int slot) const {
+    return texts[slot];
+}
+
+/**
+ * @brief Returns the voters of a slot.
+ * @param slot The slot.
+ * @return Set of the voters.
+ */
+const VoterSet& CommentTable::getVoters(unsigned int slot) const {
+    return voters[slot];
+}
+
+/**
+ * @brief Returns the author column.
+ * @return Pointer to the author of every slot.
+ */
+const unsigned int* CommentTable::getAuthorIds() const {
+    return authorIds.data();
+}
+
+/**
+ * @brief Returns the rating column.
+ * @return Pointer to the rating of every slot.
+ */
+const int* CommentTable::getRatings() const {
+    return ratings.data();
+}
+
+/**
+ * @brief Sets the ID of a slot.
+ * @param slot The slot.
+ * @param commentId Unique comment identifier.
+ */
+void CommentTable::setId(unsigned int slot, unsigned int commentId) {
+    ids[slot] = commentId;
+}
+
+/**
+ * @brief Sets the author of a slot.
+ * @param slot The slot.
+ * @param authorId Author ID.
+ */
+void CommentTable::setAuthorId(unsigned int slot, unsigned int authorId) {
+    authorIds[slot] = authorId;
+}
+
+/**
+ * @brief Sets the rating of a slot.
+ * @param slot The slot.
+ * @param rating Rating.
+ */
+void CommentTable::setRating(unsigned int slot, int rating) {
+    ratings[slot] = rating;
+}
+
+/**
+ * @brief Copies a text into the arena and gives it to a slot.
+ * @param slot The slot.
+ * @param text The text.
+ */
+void CommentTable::setText(unsigned int slot, std::string_view text) {
+    texts[slot] = arena.store(text);
+}
+
+/**
+ * @brief Gives a slot a text borrowed from a snapshot, without copying it.
+ * @param slot The slot.
+ * @param text The text, it must outlive the table or be stored by storeTexts first.
+ */
+void CommentTable::borrowText(unsigned int slot, std::string_view text) {
+    texts[slot] = text;
+}
+
+/**
+ * @brief Replaces the voters of a slot.
+ * @param slot The slot.
+ * @param ids The voter IDs.
+ * @param count Number of voters.
+ */
+void CommentTable::setVoters(unsigned int slot, const std::uint32_t* ids, std::size_t count) {
+    voters[slot].assign(ids, count);
+}
+
+/**
+ * @brief Records a vote on a slot.
+ * @param slot The slot.
+ * @param userId ID of the voting user.
+ * @param upvote True for an upvote, false for a downvote.
+ * @return True if the vote was counted, false if the user had already voted.
+ */
+bool CommentTable::vote(unsigned int slot, unsigned int userId, bool upvote) {
+    if (!voters[slot].insert(userId)) {
+        return false;
+    }
+    ratings[slot] += upvote ? 1 : -1;
+    return true;
+}
+
+/**
+ * @brief Copies the texts that are not in the arena into it, so the table no longer needs a snapshot.
+ */
+void CommentTable::storeTexts() {
+    for (std::string_view& text : texts) {
+        if (!text.empty() && !arena.owns(text.data())) {
+            text = arena.store(text);
+        }
+    }
+}
+
+/**
+ * @brief Copies the texts still in use into a fresh arena once most of the old one belongs to removed slots.
+ *
+ * The arena only grows, so this runs after removals; it does nothing until removed texts
+ * take up more than half of at least MIN_COMPACT_BYTES stored bytes.
+ */
+void CommentTable::compactTexts() {
+    const std::size_t MIN_COMPACT_BYTES = 4096;
+    std::size_t liveBytes = 0;
+    for (std::string_view text : texts) {
+        liveBytes += text.size();
+    }
+    if (arena.getBytesStored() < MIN_COMPACT_BYTES || arena.getBytesStored() <= 2 * liveBytes) {
+        return;
+    }
+    TextArena compacted;
+    for (std::string_view& text : texts) {
+        if (!text.empty() && arena.owns(text.data())) {
+            text = compacted.store(text);
+        }
+    }
+    arena = std::move(compacted);
+}
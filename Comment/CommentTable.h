@@ -0,0 +1,212 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <vector>
+#include "TextArena.h"
+#include "VoterSet.h"
+
+/**
+ * @class CommentTable
+ * @brief Comments and replies of a discussion, stored column by column.
+ *
+ * Every field has its own contiguous array indexed by slot, so a pass that only needs authors
+ * and ratings reads eight bytes per comment instead of whole comments with their texts and voters.
+ * Texts are views into the text arena of the table or into a memory-mapped snapshot.
+ * Comment is a view of one slot.
+ */
+class CommentTable {
+private:
+    std::vector<unsigned int> ids; /**< Unique comment identifier of every slot. */
+    std::vector<unsigned int> authorIds; /**< Author ID of every slot. */
+    std::vector<int> ratings; /**< Rating of every slot. */
+    std::vector<std::string_view> texts; /**< Text of every slot, in the arena or in a snapshot. */
+    std::vector<VoterSet> voters; /**< Users who voted on every slot. */
+    TextArena arena; /**< Owns the texts that are not borrowed from a snapshot. */
+
+public:
+    /**
+     * @brief Default constructor, creates an empty table.
+     */
+    CommentTable();
+
+    /**
+     * @brief Copy constructor; texts stored in the arena of the other table are copied into the own arena.
+     * @param other The table to be copied.
+     */
+    CommentTable(const CommentTable& other);
+
+    /**
+     * @brief Move constructor, takes over the columns and the arena.
+     * @param other The table whose data will be taken over; it is left empty.
+     */
+    CommentTable(CommentTable&& other) noexcept;
+
+    /**
+     * @brief Assignment operator; texts stored in the arena of the other table are copied into the own arena.
+     * @param other The table to be copied.
+     * @return Reference to this table.
+     */
+    CommentTable& operator=(const CommentTable& other);
+
+    /**
+     * @brief Move assignment operator, takes over the columns and the arena.
+     * @param other The table whose data will be taken over; it is left empty.
+     * @return Reference to this table.
+     */
+    CommentTable& operator=(CommentTable&& other) noexcept;
+
+    /**
+     * @brief Returns the number of slots.
+     * @return Number of comments and replies.
+     */
+    unsigned int size() const;
+
+    /**
+     * @brief Reserves room for a number of slots.
+     * @param capacity Number of slots.
+     */
+    void reserve(unsigned int capacity);
+
+    /**
+     * @brief Removes all slots and frees the arena.
+     */
+    void clear();
+
+    /**
+     * @brief Appends a slot with no rating and no voters; the text is copied into the arena.
+     * @param text Comment text.
+     * @param authorId Comment author ID.
+     * @param commentId Unique comment identifier.
+     * @return The new slot.
+     */
+    unsigned int append(std::string_view text, unsigned int authorId, unsigned int commentId);
+
+    /**
+     * @brief Moves the data of one slot into an earlier one, as the table closes a gap.
+     * @param from Slot whose data is moved.
+     * @param to Slot that receives it.
+     */
+    void moveSlot(unsigned int from, unsigned int to);
+
+    /**
+     * @brief Drops all slots from the given one on.
+     * @param newSize Number of slots that remain.
+     */
+    void truncate(unsigned int newSize);
+
+    /**
+     * @brief Frees the text and voters of a removed slot and resets its rating.
+     * @param slot The slot, reclaimed when the owner of the table closes the gap.
+     */
+    void clearSlot(unsigned int slot);
+
+    /**
+     * @brief Returns the ID of a slot.
+     * @param slot The slot.
+     * @return Unique comment identifier.
+     */
+    unsigned int getId(unsigned int slot) const;
+
+    /**
+     * @brief Returns the author of a slot.
+     * @param slot The slot.
+     * @return Author ID.
+     */
+    unsigned int getAuthorId(unsigned int slot) const;
+
+    /**
+     * @brief Returns the rating of a slot.
+     * @param slot The slot.
+     * @return Rating.
+     */
+    int getRating(unsigned int slot) const;
+
+    /**
+     * @brief Returns the text of a slot.
+     * @param slot The slot.
+     * @return View of the text, valid until the text is replaced or the table is changed.
+     */
+    std::string_view getText(unsigned int slot) const;
+
+    /**
+     * @brief Returns the voters of a slot.
+     * @param slot The slot.
+     * @return Set of the voters.
+     */
+    const VoterSet& getVoters(unsigned int slot) const;
+
+    /**
+     * @brief Returns the author column.
+     * @return Pointer to the author of every slot.
+     */
+    const unsigned int* getAuthorIds() const;
+
+    /**
+     * @brief Returns the rating column.
+     * @return Pointer to the rating of every slot.
+     */
+    const int* getRatings() const;
+
+    /**
+     * @brief Sets the ID of a slot.
+     * @param slot The slot.
+     * @param commentId Unique comment identifier.
+     */
+    void setId(unsigned int slot, unsigned int commentId);
+
+    /**
+     * @brief Sets the author of a slot.
+     * @param slot The slot.
+     * @param authorId Author ID.
+     */
+    void setAuthorId(unsigned int slot, unsigned int authorId);
+
+    /**
+     * @brief Sets the rating of a slot.
+     * @param slot The slot.
+     * @param rating Rating.
+     */
+    void setRating(unsigned int slot, int rating);
+
+    /**
+     * @brief Copies a text into the arena and gives it to a slot.
+     * @param slot The slot.
+     * @param text The text.
+     */
+    void setText(unsigned int slot, std::string_view text);
+
+    /**
+     * @brief Gives a slot a text borrowed from a snapshot, without copying it.
+     * @param slot The slot.
+     * @param text The text, it must outlive the table or be stored by storeTexts first.
+     */
+    void borrowText(unsigned int slot, std::string_view text);
+
+    /**
+     * @brief Replaces the voters of a slot.
+     * @param slot The slot.
+     * @param ids The voter IDs.
+     * @param count Number of voters.
+     */
+    void setVoters(unsigned int slot, const std::uint32_t* ids, std::size_t count);
+
+    /**
+     * @brief Records a vote on a slot.
+     * @param slot The slot.
+     * @param userId ID of the voting user.
+     * @param upvote True for an upvote, false for a downvote.
+     * @return True if the vote was counted, false if the user had already voted.
+     */
+    bool vote(unsigned int slot, unsigned int userId, bool upvote);
+
+    /**
+     * @brief Copies the texts that are not in the arena into it, so the table no longer needs a snapshot.
+     */
+    void storeTexts();
+
+    /**
+     * @brief Copies the texts still in use into a fresh arena once most of the old one belongs to removed slots.
+     */
+    void compactTexts();
+};
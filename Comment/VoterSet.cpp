@@ -0,0 +1,268 @@
+﻿#include "VoterSet.h"
+#include <algorithm>
+
+static const std::size_t BITMAP_WORDS = 65536 / 16; /**< 16-bit words of a bitmap container. */
+
+/**
+ * @brief Returns the position of the lowest set bit of a word.
+ * @param word A word with at least one bit set.
+ * @return Position of the bit.
+ */
+static unsigned int lowestBit(unsigned int word) {
+#if defined(__GNUC__)
+    return static_cast<unsigned int>(__builtin_ctz(word));
+#else
+    unsigned int bit = 0;
+    while ((word & 1u) == 0) {
+        word >>= 1;
+        bit++;
+    }
+    return bit;
+#endif
+}
+
+/**
+ * @brief Default constructor, creates an empty set.
+ */
+VoterSet::VoterSet() : count(0), small{} {  }
+
+/**
+ * @brief Returns the first container whose key is not less than the given key.
+ * @param key High 16 bits of an ID.
+ * @return Index of the container, or the number of containers.
+ */
+std::size_t VoterSet::lowerBound(std::uint16_t key) const {
+    std::size_t low = 0, high = containers.size();
+    while (low < high) {
+        std::size_t middle = (low + high) / 2;
+        if (containers[middle].key < key) {
+            low = middle + 1;
+        }
+        else {
+            high = middle;
+        }
+    }
+    return low;
+}
+
+/**
+ * @brief Checks whether a container holds a low half.
+ * @param container The container.
+ * @param low Low 16 bits of an ID.
+ * @return True if the ID is in the container, otherwise false.
+ */
+bool VoterSet::containerContains(const Container& container, std::uint16_t low) {
+    if (container.bitmap) {
+        return (container.values[low >> 4] >> (low & 15)) & 1;
+    }
+    return std::binary_search(container.values.begin(), container.values.end(), low);
+}
+
+/**
+ * @brief Adds a low half to a container, turning it into a bitmap when it grows past ARRAY_LIMIT.
+ * @param container The container.
+ * @param low Low 16 bits of an ID.
+ * @return True if the ID was added, false if it was already there.
+ */
+bool VoterSet::containerInsert(Container& container, std::uint16_t low) {
+    if (!container.bitmap) {
+        auto position = std::lower_bound(container.values.begin(), container.values.end(), low);
+        if (position != container.values.end() && *position == low) {
+            return false;
+        }
+        if (container.cardinality < ARRAY_LIMIT) {
+            container.values.insert(position, low);
+            container.cardinality++;
+            return true;
+        }
+        toBitmap(container);
+    }
+    std::uint16_t& word = container.values[low >> 4];
+    std::uint16_t bit = static_cast<std::uint16_t>(1u << (low & 15));
+    if (word & bit) {
+        return false;
+    }
+    word |= bit;
+    container.cardinality++;
+    return true;
+}
+
+/**
+ * @brief Turns a container of sorted low halves into a bitmap.
+ * @param container The container.
+ */
+void VoterSet::toBitmap(Container& container) {
+    std::vector<std::uint16_t> bits(BITMAP_WORDS, 0);
+    for (std::uint16_t low : container.values) {
+        bits[low >> 4] |= static_cast<std::uint16_t>(1u << (low & 15));
+    }
+    container.values.swap(bits);
+    container.bitmap = true;
+}
+
+/**
+ * @brief Adds an ID to the containers.
+ * @param id The ID.
+ * @return True if the ID was added, false if it was already there.
+ */
+bool VoterSet::containersInsert(std::uint32_t id) {
+    std::uint16_t key = static_cast<std::uint16_t>(id >> 16);
+    std::size_t i = lowerBound(key);
+    if (i == containers.size() || containers[i].key != key) {
+        containers.insert(containers.begin() + i, Container{ key, false, 0, {} });
+    }
+    return containerInsert(containers[i], static_cast<std::uint16_t>(id & 0xFFFF));
+}
+
+/**
+ * @brief Returns the number of voters.
+ * @return Number of voters.
+ */
+std::uint32_t VoterSet::size() const {
+    return count;
+}
+
+/**
+ * @brief Checks whether a user voted.
+ * @param id User ID.
+ * @return True if the user is in the set, otherwise false.
+ */
+bool VoterSet::contains(std::uint32_t id) const {
+    if (containers.empty()) {
+        for (std::uint32_t i = 0; i < count; i++) {
+            if (small[i] == id) {
+                return true;
+            }
+        }
+        return false;
+    }
+    std::uint16_t key = static_cast<std::uint16_t>(id >> 16);
+    std::size_t i = lowerBound(key);
+    return i < containers.size() && containers[i].key == key && containerContains(containers[i], static_cast<std::uint16_t>(id & 0xFFFF));
+}
+
+/**
+ * @brief Adds a voter.
+ *
+ * The inline voters move into containers when one more would not fit.
+ *
+ * @param id User ID.
+ * @return True if the user was added, false if the user already voted.
+ */
+bool VoterSet::insert(std::uint32_t id) {
+    if (containers.empty()) {
+        std::uint32_t position = 0;
+        while (position < count && small[position] < id) {
+            position++;
+        }
+        if (position < count && small[position] == id) {
+            return false;
+        }
+        if (count < INLINE_CAPACITY) {
+            for (std::uint32_t i = count; i > position; i--) {
+                small[i] = small[i - 1];
+            }
+            small[position] = id;
+            count++;
+            return true;
+        }
+        for (std::uint32_t i = 0; i < count; i++) {
+            containersInsert(small[i]);
+        }
+    }
+    if (!containersInsert(id)) {
+        return false;
+    }
+    count++;
+    return true;
+}
+
+/**
+ * @brief Removes all voters and frees the containers.
+ */
+void VoterSet::clear() {
+    count = 0;
+    std::vector<Container>().swap(containers);
+}
+
+/**
+ * @brief Replaces the voters with the given IDs.
+ *
+ * Ascending IDs, as stored in files and snapshots, fill the containers directly;
+ * any other order is inserted one ID at a time, dropping repeated IDs.
+ *
+ * @param ids The IDs.
+ * @param idCount Number of IDs.
+ */
+void VoterSet::assign(const std::uint32_t* ids, std::size_t idCount) {
+    clear();
+    bool ascending = true;
+    for (std::size_t i = 1; i < idCount && ascending; i++) {
+        ascending = ids[i - 1] < ids[i];
+    }
+    if (!ascending) {
+        for (std::size_t i = 0; i < idCount; i++) {
+            insert(ids[i]);
+        }
+        return;
+    }
+    if (idCount <= INLINE_CAPACITY) {
+        std::copy(ids, ids + idCount, small);
+        count = static_cast<std::uint32_t>(idCount);
+        return;
+    }
+
+    std::size_t begin = 0;
+    while (begin < idCount) {
+        std::uint16_t key = static_cast<std::uint16_t>(ids[begin] >> 16);
+        std::size_t end = begin;
+        while (end < idCount && (ids[end] >> 16) == key) {
+            end++;
+        }
+        Container container{ key, false, static_cast<std::uint32_t>(end - begin), {} };
+        if (container.cardinality <= ARRAY_LIMIT) {
+            container.values.reserve(container.cardinality);
+            for (std::size_t i = begin; i < end; i++) {
+                container.values.push_back(static_cast<std::uint16_t>(ids[i] & 0xFFFF));
+            }
+        }
+        else {
+            container.bitmap = true;
+            container.values.assign(BITMAP_WORDS, 0);
+            for (std::size_t i = begin; i < end; i++) {
+                std::uint16_t low = static_cast<std::uint16_t>(ids[i] & 0xFFFF);
+                container.values[low >> 4] |= static_cast<std::uint16_t>(1u << (low & 15));
+            }
+        }
+        containers.push_back(std::move(container));
+        begin = end;
+    }
+    count = static_cast<std::uint32_t>(idCount);
+}
+
+/**
+ * @brief Writes the voters in ascending order.
+ * @param ids Receives the IDs, must hold size() of them.
+ */
+void VoterSet::copyTo(std::uint32_t* ids) const {
+    if (containers.empty()) {
+        std::copy(small, small + count, ids);
+        return;
+    }
+    for (const Container& container : containers) {
+        std::uint32_t high = static_cast<std::uint32_t>(container.key) << 16;
+        if (!container.bitmap) {
+            for (std::uint16_t low : container.values) {
+                *ids++ = high | low;
+            }
+            continue;
+        }
+        for (std::size_t word = 0; word < BITMAP_WORDS; word++) {
+            unsigned int bits = container.values[word];
+            while (bits != 0) {
+                *ids++ = high | static_cast<std::uint32_t>(word * 16 + lowestBit(bits));
+                bits &= bits - 1;
+            }
+        }
+    }
+}
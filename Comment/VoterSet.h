@@ -0,0 +1,121 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class VoterSet
+ * @brief Set of the IDs of users who voted on a comment, sized to the number of voters.
+ *
+ * Up to INLINE_CAPACITY voters are kept sorted inside the object itself, so the many comments
+ * with few votes allocate nothing. Beyond that, the IDs are split by their high 16 bits into
+ * containers, as in a roaring bitmap: a container holds the sorted low halves of its IDs while
+ * there are at most ARRAY_LIMIT of them, and a bitmap of all 65536 low halves after that.
+ * Lookups and insertions search the container keys binarily and then the container, so a vote
+ * costs O(log n) however many users already voted, and dense voter ranges take one bit per user.
+ */
+class VoterSet {
+public:
+    static const std::uint32_t INLINE_CAPACITY = 4; /**< Most voters kept without containers. */
+    static const std::uint32_t ARRAY_LIMIT = 4096; /**< Most IDs in a container before it becomes a bitmap. */
+
+private:
+    /**
+     * @struct Container
+     * @brief The voters that share the high 16 bits of their IDs.
+     */
+    struct Container {
+        std::uint16_t key;                 /**< High 16 bits of the IDs. */
+        bool bitmap;                       /**< Whether values holds a bitmap instead of sorted low halves. */
+        std::uint32_t cardinality;         /**< Number of IDs in the container. */
+        std::vector<std::uint16_t> values; /**< Sorted low halves, or BITMAP_WORDS words of bits. */
+    };
+
+    std::uint32_t count;                  /**< Number of voters. */
+    std::uint32_t small[INLINE_CAPACITY]; /**< Sorted voters while there are no containers. */
+    std::vector<Container> containers;    /**< Containers sorted by key, empty while the voters fit inline. */
+
+    /**
+     * @brief Returns the first container whose key is not less than the given key.
+     * @param key High 16 bits of an ID.
+     * @return Index of the container, or the number of containers.
+     */
+    std::size_t lowerBound(std::uint16_t key) const;
+
+    /**
+     * @brief Checks whether a container holds a low half.
+     * @param container The container.
+     * @param low Low 16 bits of an ID.
+     * @return True if the ID is in the container, otherwise false.
+     */
+    static bool containerContains(const Container& container, std::uint16_t low);
+
+    /**
+     * @brief Adds a low half to a container, turning it into a bitmap when it grows past ARRAY_LIMIT.
+     * @param container The container.
+     * @param low Low 16 bits of an ID.
+     * @return True if the ID was added, false if it was already there.
+     */
+    static bool containerInsert(Container& container, std::uint16_t low);
+
+    /**
+     * @brief Turns a container of sorted low halves into a bitmap.
+     * @param container The container.
+     */
+    static void toBitmap(Container& container);
+
+    /**
+     * @brief Adds an ID to the containers.
+     * @param id The ID.
+     * @return True if the ID was added, false if it was already there.
+     */
+    bool containersInsert(std::uint32_t id);
+
+public:
+    /**
+     * @brief Default constructor, creates an empty set.
+     */
+    VoterSet();
+
+    /**
+     * @brief Returns the number of voters.
+     * @return Number of voters.
+     */
+    std::uint32_t size() const;
+
+    /**
+     * @brief Checks whether a user voted.
+     * @param id User ID.
+     * @return True if the user is in the set, otherwise false.
+     */
+    bool contains(std::uint32_t id) const;
+
+    /**
+     * @brief Adds a voter.
+     * @param id User ID.
+     * @return True if the user was added, false if the user already voted.
+     */
+    bool insert(std::uint32_t id);
+
+    /**
+     * @brief Removes all voters and frees the containers.
+     */
+    void clear();
+
+    /**
+     * @brief Replaces the voters with the given IDs.
+     *
+     * Ascending IDs, as stored in files and snapshots, fill the containers directly;
+     * any other order is inserted one ID at a time, dropping repeated IDs.
+     *
+     * @param ids The IDs.
+     * @param idCount Number of IDs.
+     */
+    void assign(const std::uint32_t* ids, std::size_t idCount);
+
+    /**
+     * @brief Writes the voters in ascending order.
+     * @param ids Receives the IDs, must hold size() of them.
+     */
+    void copyTo(std::uint32_t* ids) const;
+};
@@ -6,31 +6,150 @@
  * @param other The discussion from which data will be copied.
  */
 void Discussion::copyFrom(const Discussion& other) {
-    setDiscussionTitle(other.title);
-    setDiscussionContents(other.contents);
+    title = other.title;
+    contents = other.contents;
     setDiscussionCreatorId(other.creatorId);
     id = other.id;
 
-    commentCapacity = other.commentCapacity;
+    // the table copies the texts out of the arena of the original, which may be freed first
+    comments = other.comments;
+    nodes = other.nodes;
     commentNum = other.commentNum;
-    comments = new Comment[commentCapacity];
-    for (size_t i = 0; i < commentNum && i < commentCapacity; i++) {
-        comments[i] = other.comments[i];
-    }
+    removedNum = other.removedNum;
+    firstComment = other.firstComment;
+    lastComment = other.lastComment;
     commentID = other.commentID;
+    commentSlots = other.commentSlots;
+}
+
+/**
+ * @brief Takes over the data of another discussion, leaving it empty.
+ *
+ * @param other The discussion whose data will be taken over.
+ */
+void Discussion::moveFrom(Discussion& other) noexcept {
+    title = std::move(other.title);
+    contents = std::move(other.contents);
+    creatorId = other.creatorId;
+    id = other.id;
+
+    comments = std::move(other.comments);
+    nodes = std::move(other.nodes);
+    commentNum = other.commentNum;
+    removedNum = other.removedNum;
+    firstComment = other.firstComment;
+    lastComment = other.lastComment;
+    commentID = other.commentID;
+    commentSlots = std::move(other.commentSlots);
+    other.nodes.clear();
+    other.commentNum = 0;
+    other.removedNum = 0;
+    other.firstComment = other.lastComment = NO_COMMENT;
+}
+
+/**
+ * @brief Empties the comment table and allocates it at the given capacity.
+ *
+ * @param capacity The new capacity.
+ */
+void Discussion::resetComments(unsigned int capacity) {
+    comments.clear();
+    comments.reserve(capacity);
+    nodes.clear();
+    nodes.reserve(capacity);
+    commentNum = 0;
+    removedNum = 0;
+    firstComment = lastComment = NO_COMMENT;
+    commentSlots.clear();
+}
+
+/**
+ * @brief Appends a comment to the table as the last reply to another one.
+ *
+ * @param parent Slot of the comment replied to, NO_COMMENT for a top-level comment.
+ * @param text Comment text, copied into the arena of the table.
+ * @param authorId Comment author ID.
+ * @param commentId Unique comment identifier.
+ * @return Slot of the comment.
+ */
+unsigned int Discussion::appendComment(unsigned int parent, std::string_view text, unsigned int authorId, unsigned int commentId) {
+    unsigned int slot = comments.append(text, authorId, commentId);
+    unsigned int previous = parent == NO_COMMENT ? lastComment : nodes[parent].lastReply;
+    nodes.push_back(CommentNode{ parent, NO_COMMENT, NO_COMMENT, previous, NO_COMMENT, parent == NO_COMMENT ? 0 : nodes[parent].depth + 1, 0 });
+
+    if (parent == NO_COMMENT) {
+        if (lastComment == NO_COMMENT) {
+            firstComment = slot;
+        }
+        else {
+            nodes[lastComment].nextSibling = slot;
+        }
+        lastComment = slot;
+        commentNum++;
+        return slot;
+    }
+    CommentNode& parentNode = nodes[parent];
+    if (parentNode.lastReply == NO_COMMENT) {
+        parentNode.firstReply = slot;
+    }
+    else {
+        nodes[parentNode.lastReply].nextSibling = slot;
+    }
+    parentNode.lastReply = slot;
+    parentNode.replyNum++;
+    return slot;
 }
 
 /**
- * @brief Resizes the comments array to accommodate more comments.
+ * @brief Returns the comment after another one when the reply tree is read from top to bottom.
+ *
+ * The first reply comes next, otherwise the next sibling of the comment or of the closest
+ * comment above it, so a whole walk follows every link about once.
+ *
+ * @param slot Slot of the current comment.
+ * @param root Slot of the comment whose replies are being read, NO_COMMENT for the whole discussion.
+ * @return Slot of the next comment, or NO_COMMENT after the last one.
  */
-void Discussion::resizeComments() {
-    commentCapacity *= 2;
-    Comment* newArr = new Comment[commentCapacity];
-    for (size_t i = 0; i < commentNum; i++) {
-        newArr[i] = comments[i];
+unsigned int Discussion::nextInTree(unsigned int slot, unsigned int root) const {
+    if (nodes[slot].firstReply != NO_COMMENT) {
+        return nodes[slot].firstReply;
+    }
+    while (slot != root) {
+        if (nodes[slot].nextSibling != NO_COMMENT) {
+            return nodes[slot].nextSibling;
+        }
+        slot = nodes[slot].parent;
+    }
+    return NO_COMMENT;
+}
+
+/**
+ * @brief Rebuilds the comment index from the comment table.
+ *
+ * Files written before comment IDs were counted hold several comments with the same ID,
+ * and replies used to be numbered per comment. Top-level comments keep their IDs first,
+ * so journal records still find them; the other duplicates get fresh IDs.
+ */
+void Discussion::indexComments() {
+    unsigned int count = comments.size();
+    commentSlots.clear();
+    commentSlots.reserve(count);
+    for (unsigned int i = 0; i < count; i++) {
+        if (comments.getId(i) >= commentID) {
+            commentID = comments.getId(i) + 1;
+        }
+    }
+    for (int topLevel = 1; topLevel >= 0; topLevel--) {
+        for (unsigned int i = 0; i < count; i++) {
+            if ((nodes[i].parent == NO_COMMENT) != (topLevel == 1)) {
+                continue;
+            }
+            if (!commentSlots.insert(comments.getId(i), i)) {
+                comments.setId(i, commentID++);
+                commentSlots.insert(comments.getId(i), i);
+            }
+        }
     }
-    delete[] comments;
-    comments = newArr;
 }
 
 /**
@@ -41,14 +160,15 @@ void Discussion::resizeComments() {
  * @param creatorId Discussion creator ID.
  * @param discussionId Unique discussion ID.
  */
-Discussion::Discussion(const std::string& title, const std::string& contents, unsigned int creatorId, unsigned int discussionId) : commentCapacity(2) {
+Discussion::Discussion(const std::string& title, const std::string& contents, unsigned int creatorId, unsigned int discussionId) {
     setDiscussionTitle(title);
     setDiscussionContents(contents);
     setDiscussionCreatorId(creatorId);
     id = discussionId;
 
-    comments = new Comment[commentCapacity];
     commentNum = 0;
+    removedNum = 0;
+    firstComment = lastComment = NO_COMMENT;
     commentID = 0;
 }
 
@@ -66,6 +186,15 @@ Discussion::Discussion(const Discussion& other) {
     copyFrom(other);
 }
 
+/**
+ * @brief Move constructor for the Discussion class, takes over the comment table.
+ *
+ * @param other The discussion to be moved; it is left empty and may only be assigned to or destroyed.
+ */
+Discussion::Discussion(Discussion&& other) noexcept {
+    moveFrom(other);
+}
+
 /**
  * @brief Assignment operator for the Discussion class.
  *
@@ -74,19 +203,29 @@ Discussion::Discussion(const Discussion& other) {
  */
 Discussion& Discussion::operator=(const Discussion& other) {
     if (this != &other) {
-        delete[] comments;
         copyFrom(other);
     }
     return *this;
 }
 
 /**
- * @brief Destructor for the Discussion class.
+ * @brief Move assignment operator for the Discussion class.
+ *
+ * @param other The discussion to be moved; it is left empty and may only be assigned to or destroyed.
+ * @return Reference to the assigned discussion.
  */
-Discussion::~Discussion() {
-    delete[] comments;
+Discussion& Discussion::operator=(Discussion&& other) noexcept {
+    if (this != &other) {
+        moveFrom(other);
+    }
+    return *this;
 }
 
+/**
+ * @brief Destructor for the Discussion class.
+ */
+Discussion::~Discussion() = default;
+
 /**
  * @brief Sets the title of the discussion.
  *
@@ -114,22 +253,31 @@ void Discussion::setDiscussionCreatorId(unsigned int creatorId) {
     this->creatorId = creatorId;
 }
 
+/**
+ * @brief Sets the unique discussion ID.
+ *
+ * @param discussionId The new discussion ID.
+ */
+void Discussion::setDiscussionId(unsigned int discussionId) {
+    id = discussionId;
+}
+
 /**
  * @brief Returns the title of the discussion.
  *
- * @return The title of the discussion.
+ * @return View of the title of the discussion, valid until the title is changed.
  */
-std::string Discussion::getDiscussionTitle() const {
-    return title;
+std::string_view Discussion::getDiscussionTitle() const {
+    return title.view();
 }
 
 /**
  * @brief Returns the content of the discussion.
  *
- * @return The content of the discussion.
+ * @return View of the content of the discussion, valid until the content is changed.
  */
-std::string Discussion::getDiscussionContents() const {
-    return contents;
+std::string_view Discussion::getDiscussionContents() const {
+    return contents.view();
 }
 
 /**
@@ -151,14 +299,23 @@ unsigned int Discussion::getDiscussionId() const {
 }
 
 /**
- * @brief Returns the number of comments in the discussion.
+ * @brief Returns the number of top-level comments in the discussion.
  *
- * @return The number of comments in the discussion.
+ * @return The number of top-level comments in the discussion.
  */
 unsigned int Discussion::getCommentNum() const {
     return commentNum;
 }
 
+/**
+ * @brief Returns the number of replies in the discussion, at any depth.
+ *
+ * @return The number of replies in the discussion.
+ */
+unsigned int Discussion::getReplyNum() const {
+    return comments.size() - removedNum - commentNum;
+}
+
 /**
  * @brief Returns the unique ID for the comments in the discussion.
  *
@@ -169,44 +326,68 @@ unsigned int Discussion::getCommentID() const {
 }
 
 /**
- * @brief Returns the array of comments in the discussion.
+ * @brief Returns a comment or a reply of the discussion.
  *
- * @return Pointer to the comments array.
+ * @param slot Slot of the comment in the comment table, as returned by findComment.
+ * @return View of the comment, valid until a comment is added or removed.
  */
-Comment* Discussion::getDiscussionComments() const {
-    return comments;
+Comment Discussion::getComment(unsigned int slot) {
+    return Comment(comments, slot);
 }
 
 /**
- * @brief Adds a new comment to the discussion.
+ * @brief Returns a comment or a reply of the discussion for reading.
  *
- * @param authorId The ID of the author of the comment.
+ * The view is const, so it cannot change the table even though it points to it.
+ *
+ * @param slot Slot of the comment in the comment table, as returned by findComment.
+ * @return View of the comment, valid until a comment is added or removed.
  */
-void Discussion::addComment(unsigned int authorId) {
-    std::string buff;
-    std::cout << ">Enter a comment: ";
-    std::getline(std::cin, buff);
+const Comment Discussion::getComment(unsigned int slot) const {
+    return Comment(const_cast<CommentTable&>(comments), slot);
+}
 
-    Comment newComment(buff, authorId, commentID);
-    comments[commentNum] = newComment;
-    commentNum++;
+/**
+ * @brief Looks up a comment or a reply at any depth by ID.
+ *
+ * @param commentId Comment ID.
+ * @return Slot of the comment in the comment table, or -1 if there is no such comment.
+ */
+int Discussion::findComment(unsigned int commentId) const {
+    return commentSlots.find(commentId);
+}
 
-    if (commentNum >= commentCapacity) {
-        resizeComments();
-    }
+/**
+ * @brief Adds a new comment to the discussion.
+ *
+ * @param authorId The ID of the author of the comment.
+ * @param text Comment text.
+ */
+void Discussion::addComment(unsigned int authorId, const std::string& text) {
+    unsigned int slot = appendComment(NO_COMMENT, text, authorId, commentID);
+    commentSlots.insert(commentID, slot);
+    commentID++;
 }
 
 /**
- * @brief Adds a reply to an existing comment.
+ * @brief Adds a reply to an existing comment or reply.
+ *
+ * The reply gets the next comment ID of the discussion, so it can be answered, voted on and removed like a comment.
  *
  * @param authorId Reply author ID.
- * @param commentId The ID of the comment to which the reply is being added to.
+ * @param commentId The ID of the comment or reply to which the reply is being added to.
+ * @param text Reply text.
+ * @return True if the reply was added, false if there is no such comment.
  */
-void Discussion::commentReply(unsigned int authorId, unsigned int commentId) {
-    std::string buff;
-    std::cout << ">Enter the reply: ";
-    std::getline(std::cin, buff);
-    comments[commentId].addReply(buff, authorId);
+bool Discussion::commentReply(unsigned int authorId, unsigned int commentId, const std::string& text) {
+    int slot = findComment(commentId);
+    if (slot < 0) {
+        return false;
+    }
+    unsigned int replySlot = appendComment(slot, text, authorId, commentID);
+    commentSlots.insert(commentID, replySlot);
+    commentID++;
+    return true;
 }
 
 /**
@@ -214,113 +395,229 @@ void Discussion::commentReply(unsigned int authorId, unsigned int commentId) {
  *
  * @param curUserId Current user ID.
  * @param commentId Comment ID being voted on.
+ * @param upvote True for an upvote, false for a downvote.
+ * @return False if there is no such comment or the user has already voted, otherwise true.
  */
-void Discussion::commentVote(unsigned int curUserId, unsigned int commentId) {
-    if (comments[commentId].DidUserAlreadyVote(curUserId)) {
-        std::cout << ">You have already voted!\n";
-        return;
+bool Discussion::commentVote(unsigned int curUserId, unsigned int commentId, bool upvote) {
+    int slot = findComment(commentId);
+    if (slot < 0) {
+        return false;
     }
-    char vote;
-    std::cout << ">Upvote or downvote a comment(U/D): ";
-    std::cin >> vote;
+    // changing the user rating in main
+    return comments.vote(slot, curUserId, upvote);
+}
 
-    while (vote != 'U' && vote != 'u' && vote != 'D' && vote != 'd') {
-        std::cout << ">No such vote exists! Enter a new vote(U/D): ";
-        std::cin >> vote;
+/**
+ * @brief Moves the comments still in the reply tree over the slots of removed ones.
+ *
+ * Comments keep their order and IDs; every link and index entry is renumbered, and the
+ * texts of the removed comments are dropped from the arena once they take up most of it.
+ */
+void Discussion::compactComments() {
+    unsigned int count = comments.size();
+    std::vector<unsigned int> newSlots(count, NO_COMMENT);
+    for (unsigned int i = firstComment; i != NO_COMMENT; i = nextInTree(i, NO_COMMENT)) {
+        newSlots[i] = 0;
     }
-
-    if (vote == 'u') { vote = 'U'; }
-    if (vote == 'd') { vote = 'D'; }
-
-    if (vote == 'U') {
-        comments[commentId].commentRatingIncrement(curUserId);
-        // changing the user rating in main
-        return;
+    unsigned int kept = 0;
+    for (unsigned int i = 0; i < count; i++) {
+        if (newSlots[i] != NO_COMMENT) {
+            newSlots[i] = kept++;
+        }
     }
-    comments[commentId].commentRatingDecrement(curUserId);
-    // changing the user rating in main
+    auto renumber = [&newSlots](unsigned int& link) {
+        if (link != NO_COMMENT) {
+            link = newSlots[link];
+        }
+    };
+    for (unsigned int i = 0; i < count; i++) {
+        unsigned int slot = newSlots[i];
+        if (slot == NO_COMMENT) {
+            continue;
+        }
+        if (slot != i) {
+            comments.moveSlot(i, slot);
+            nodes[slot] = nodes[i];
+            commentSlots.update(comments.getId(slot), slot);
+        }
+        renumber(nodes[slot].parent);
+        renumber(nodes[slot].firstReply);
+        renumber(nodes[slot].lastReply);
+        renumber(nodes[slot].previousSibling);
+        renumber(nodes[slot].nextSibling);
+    }
+    renumber(firstComment);
+    renumber(lastComment);
+    comments.truncate(kept);
+    nodes.resize(kept);
+    removedNum = 0;
+    comments.compactTexts();
 }
 
 /**
- * @brief Removes comment from discussion.
+ * @brief Removes a comment or reply from the discussion, together with all replies to it.
+ *
+ * The comment is unlinked from its neighbours and every comment below it loses its ID, text
+ * and voters, so the cost follows the size of the removed subtree, not of the discussion.
+ * The slots are left empty and reclaimed once removed comments fill half of the table.
  *
- * @param curUserId Current user ID.
  * @param commentId The ID of the comment to be removed.
- * @param curUserPermission Current user permission.
+ * @return True if the comment was removed, false if there is no such comment.
  */
-void Discussion::removeComment(unsigned int curUserId, unsigned int commentId, Permission curUserPermission) {
-    if (comments[commentId].getAuthorId() != curUserId && curUserPermission != Permission::MOD) {
-        std::cout << ">Access denied!\n";
-        return;
+bool Discussion::removeComment(unsigned int commentId) {
+    int found = findComment(commentId);
+    if (found < 0) {
+        return false;
+    }
+    unsigned int root = found;
+    const CommentNode& node = nodes[root];
+    unsigned int& first = node.parent == NO_COMMENT ? firstComment : nodes[node.parent].firstReply;
+    unsigned int& last = node.parent == NO_COMMENT ? lastComment : nodes[node.parent].lastReply;
+    if (node.previousSibling == NO_COMMENT) {
+        first = node.nextSibling;
+    }
+    else {
+        nodes[node.previousSibling].nextSibling = node.nextSibling;
+    }
+    if (node.nextSibling == NO_COMMENT) {
+        last = node.previousSibling;
+    }
+    else {
+        nodes[node.nextSibling].previousSibling = node.previousSibling;
+    }
+    if (node.parent == NO_COMMENT) {
+        commentNum--;
+    }
+    else {
+        nodes[node.parent].replyNum--;
     }
 
-    for (size_t i = 0; i < commentNum; i++) {
-        if (comments[i].getCommentId() < commentId) {
-            continue;
-        }
-        comments[i] = comments[i + 1];
+    for (unsigned int i = root; i != NO_COMMENT; i = nextInTree(i, root)) {
+        commentSlots.erase(comments.getId(i));
+        comments.clearSlot(i);
+        removedNum++;
+    }
+    if (removedNum * 2 > comments.size()) {
+        compactComments();
     }
-    commentNum--;
     // changing the user rating in main
+    return true;
 }
 
 /**
- * @brief Lists all comments in the discussion.
+ * @brief Lists all comments in the discussion, every reply indented under the comment it answers.
  */
 void Discussion::listComments() const {
     std::cout << ">Comments: \n\t";
-    for (size_t i = 0; i < commentNum; i++) {
-        comments[i].printCommentAndReplies();
+    for (unsigned int slot = firstComment; slot != NO_COMMENT; slot = nextInTree(slot, NO_COMMENT)) {
+        for (unsigned int i = 0; i < nodes[slot].depth; i++) {
+            std::cout << "   ";
+        }
+        getComment(slot).printComment();
     }
 }
 
 /**
- * @brief Saves discussion data to a file.
+ * @brief Reads discussion data from a file, comments included.
  *
- * @param of The output file stream.
+ * @param reader Binary reader.
  */
-void Discussion::writeToFile(std::ofstream& of) {
-    unsigned int size = title.size();
-    of.write(reinterpret_cast<const char*>(&size), sizeof(size));
-    of.write((const char*)&title[0], size);
-
-    size = contents.size();
-    of.write(reinterpret_cast<const char*>(&size), sizeof(size));
-    of.write((const char*)&contents[0], size);
-
-    of.write(reinterpret_cast<const char*>(&creatorId), sizeof(creatorId));
-    of.write(reinterpret_cast<const char*>(&id), sizeof(id));
-
-    // starts recording comment data
-    of.write(reinterpret_cast<const char*>(&commentNum), sizeof(commentNum));
-    of.write(reinterpret_cast<const char*>(&commentID), sizeof(commentID));
-
-    // the comments continue...
+void Discussion::readFromFile(BinaryReader& reader) {
+    schema(reader, *this);
 }
 
 /**
- * @brief Reads discussion data from a file.
+ * @brief Fills a reserved discussion record of a snapshot, comments included.
  *
- * @param iff The input file stream.
+ * The top-level comments take one block of comment records and the replies to every comment
+ * another one, reserved before the comment record is filled.
+ *
+ * @param writer Snapshot writer.
+ * @param index Index of the reserved discussion record.
  */
-void Discussion::readFromFile(std::ifstream& iff) {
-    unsigned int size = 0;
-    iff.read(reinterpret_cast<char*>(&size), sizeof(size));
-    title.resize(size);
-    iff.read((char*)&title[0], size);
-
-    iff.read(reinterpret_cast<char*>(&size), sizeof(size));
-    contents.resize(size);
-    iff.read((char*)&contents[0], size);
-
-    iff.read(reinterpret_cast<char*>(&creatorId), sizeof(creatorId));
-    iff.read(reinterpret_cast<char*>(&id), sizeof(id));
-
-    iff.read(reinterpret_cast<char*>(&commentNum), sizeof(commentNum));
-    iff.read(reinterpret_cast<char*>(&commentID), sizeof(commentID));
+void Discussion::writeToSnapshot(SnapshotWriter& writer, std::uint32_t index) const {
+    SnapshotDiscussionRecord record{};
+    record.title = writer.addString(title.view());
+    record.contents = writer.addString(contents.view());
+    record.creatorId = creatorId;
+    record.id = id;
+    record.commentID = commentID;
+    record.commentNum = commentNum;
+    record.firstComment = writer.reserveComments(commentNum);
+    // comments whose record is still to be filled, with the index of that record
+    std::vector<std::pair<unsigned int, std::uint32_t>> pending;
+    std::uint32_t recordIndex = record.firstComment;
+    for (unsigned int slot = firstComment; slot != NO_COMMENT; slot = nodes[slot].nextSibling) {
+        pending.emplace_back(slot, recordIndex++);
+    }
+    while (!pending.empty()) {
+        std::pair<unsigned int, std::uint32_t> next = pending.back();
+        pending.pop_back();
+        const CommentNode& node = nodes[next.first];
+        std::uint32_t firstReply = writer.reserveComments(node.replyNum);
+        getComment(next.first).writeToSnapshot(writer, next.second, firstReply, node.replyNum);
+        for (unsigned int reply = node.firstReply; reply != NO_COMMENT; reply = nodes[reply].nextSibling) {
+            pending.emplace_back(reply, firstReply++);
+        }
+    }
+    writer.discussionAt(index) = record;
+}
 
-    while (commentCapacity <= commentNum) {
-        resizeComments();
+/**
+ * @brief Reads the discussion and its comments and replies from a snapshot record.
+ *
+ * Replies are read from a work list instead of by recursion, so deep reply chains cannot
+ * overflow the stack, and no more comments are read than the snapshot holds, so reply blocks
+ * that point back at their own comments cannot loop forever.
+ *
+ * @param reader Snapshot reader.
+ * @param record The discussion record.
+ * @return True if the record is valid, otherwise false.
+ */
+bool Discussion::readFromSnapshot(const SnapshotReader& reader, const SnapshotDiscussionRecord& record) {
+    std::string_view titleView, contentsView;
+    const SnapshotCommentRecord* commentRecords = reader.getComments(record.firstComment, record.commentNum);
+    if (!reader.getString(record.title, titleView) || !reader.getString(record.contents, contentsView) || commentRecords == nullptr) {
+        return false;
+    }
+    title = Text::borrow(titleView.data(), titleView.size());
+    contents = Text::borrow(contentsView.data(), contentsView.size());
+    creatorId = record.creatorId;
+    id = record.id;
+    commentID = record.commentID;
+
+    resetComments(record.commentNum < 2 ? 2 : record.commentNum + 1);
+    // records still to be read, with the slot of the comment they reply to
+    std::vector<std::pair<const SnapshotCommentRecord*, unsigned int>> pending;
+    for (unsigned int i = record.commentNum; i-- > 0;) {
+        pending.emplace_back(&commentRecords[i], NO_COMMENT);
+    }
+    while (!pending.empty()) {
+        std::pair<const SnapshotCommentRecord*, unsigned int> next = pending.back();
+        pending.pop_back();
+        const SnapshotCommentRecord* replyRecords = reader.getComments(next.first->firstReply, next.first->replyNum);
+        if (replyRecords == nullptr || comments.size() >= reader.getHeader().commentCount) {
+            return false;
+        }
+        unsigned int slot = appendComment(next.second, std::string_view(), 0, 0);
+        if (!getComment(slot).readFromSnapshot(reader, *next.first)) {
+            return false;
+        }
+        for (unsigned int i = next.first->replyNum; i-- > 0;) {
+            pending.emplace_back(&replyRecords[i], slot);
+        }
     }
-    // information about comments...
+    indexComments();
+    return true;
+}
+
+/**
+ * @brief Copies text borrowed from a snapshot into owned storage, comments included.
+ *
+ * The texts of comments and replies are copied into the arena of the comment table.
+ */
+void Discussion::detachText() {
+    title.detach();
+    contents.detach();
+    comments.storeTexts();
 }
@@ -1,6 +1,24 @@
 ﻿#pragma once
 #include "Comment.h"
+#include "IdIndex.h"
 #include <string>
+#include <utility>
+#include <vector>
+
+/**
+ * @brief Place of a comment or reply in the reply tree of a discussion.
+ *
+ * Links are slots of the comment table; Discussion::NO_COMMENT marks a missing link.
+ */
+struct CommentNode {
+    unsigned int parent; /**< Slot of the comment replied to, NO_COMMENT for a top-level comment. */
+    unsigned int firstReply; /**< Slot of the first reply. */
+    unsigned int lastReply; /**< Slot of the last reply, new replies are linked after it. */
+    unsigned int previousSibling; /**< Slot of the previous reply to the same comment, or of the previous top-level comment. */
+    unsigned int nextSibling; /**< Slot of the next reply to the same comment, or of the next top-level comment. */
+    unsigned int depth; /**< 0 for a top-level comment, 1 for a reply to it and so on. */
+    unsigned int replyNum; /**< Number of direct replies. */
+};
 
 /**
  * @class Discussion
@@ -8,15 +26,19 @@
  */
 class Discussion {
 private:
-    std::string title; /**< Discussion title. */
-    std::string contents; /**< Discussion content. */
+    Text title; /**< Discussion title. */
+    Text contents; /**< Discussion content. */
     unsigned int creatorId; /**< Discussion creator ID. */
     unsigned int id; /**< Unique discussion ID. */
 
-    Comment* comments; /**< An array of comments to the discussion. */
-    unsigned int commentCapacity; /**< Comment array capacity. */
-    unsigned int commentNum; /**< Number of comments in the discussion. */
-    unsigned int commentID; /**< Unique ID for comments within the discussion. */
+    CommentTable comments; /**< Columns of all comments and replies, in the order they were added. */
+    std::vector<CommentNode> nodes; /**< Place of every comment of the table in the reply tree. */
+    unsigned int commentNum; /**< Number of top-level comments. */
+    unsigned int removedNum; /**< Number of removed comments and replies whose slots are still in the table. */
+    unsigned int firstComment; /**< Slot of the first top-level comment. */
+    unsigned int lastComment; /**< Slot of the last top-level comment. */
+    unsigned int commentID; /**< Unique ID for comments and replies within the discussion. */
+    IdIndex commentSlots; /**< Slot of every comment and reply in the table by ID. */
 
     /**
      * @brief Copies data from another discussion.
@@ -26,11 +48,52 @@ private:
     void copyFrom(const Discussion& other);
 
     /**
-     * @brief Resizes the comments array to accommodate more comments.
+     * @brief Takes over the data of another discussion, leaving it empty.
+     *
+     * @param other The discussion whose data will be taken over.
      */
-    void resizeComments();
+    void moveFrom(Discussion& other) noexcept;
+
+    /**
+     * @brief Empties the comment table and allocates it at the given capacity.
+     *
+     * @param capacity The new capacity.
+     */
+    void resetComments(unsigned int capacity);
+
+    /**
+     * @brief Appends a comment to the table as the last reply to another one.
+     *
+     * @param parent Slot of the comment replied to, NO_COMMENT for a top-level comment.
+     * @param text Comment text, copied into the arena of the table.
+     * @param authorId Comment author ID.
+     * @param commentId Unique comment identifier.
+     * @return Slot of the comment.
+     */
+    unsigned int appendComment(unsigned int parent, std::string_view text, unsigned int authorId, unsigned int commentId);
+
+    /**
+     * @brief Returns the comment after another one when the reply tree is read from top to bottom.
+     *
+     * @param slot Slot of the current comment.
+     * @param root Slot of the comment whose replies are being read, NO_COMMENT for the whole discussion.
+     * @return Slot of the next comment, or NO_COMMENT after the last one.
+     */
+    unsigned int nextInTree(unsigned int slot, unsigned int root) const;
+
+    /**
+     * @brief Rebuilds the comment index from the comment table.
+     */
+    void indexComments();
+
+    /**
+     * @brief Moves the comments still in the reply tree over the slots of removed ones.
+     */
+    void compactComments();
 
 public:
+    static constexpr unsigned int NO_COMMENT = 0xFFFFFFFFu; /**< Missing link in the reply tree. */
+
     /**
      * @brief Constructs a new Discussion object with the given details.
      *
@@ -53,6 +116,13 @@ public:
      */
     Discussion(const Discussion& other);
 
+    /**
+     * @brief Move constructor for the Discussion class, takes over the comment table.
+     *
+     * @param other The discussion to be moved; it is left empty and may only be assigned to or destroyed.
+     */
+    Discussion(Discussion&& other) noexcept;
+
     /**
      * @brief Assignment operator for the Discussion class.
      *
@@ -61,6 +131,14 @@ public:
      */
     Discussion& operator=(const Discussion& other);
 
+    /**
+     * @brief Move assignment operator for the Discussion class.
+     *
+     * @param other The discussion to be moved; it is left empty and may only be assigned to or destroyed.
+     * @return Reference to the assigned discussion.
+     */
+    Discussion& operator=(Discussion&& other) noexcept;
+
     /**
      * @brief Destructor for the Discussion class.
      */
@@ -87,19 +165,26 @@ public:
      */
     void setDiscussionCreatorId(unsigned int creatorId);
 
+    /**
+     * @brief Sets the unique discussion ID.
+     *
+     * @param discussionId The new discussion ID.
+     */
+    void setDiscussionId(unsigned int discussionId);
+
     /**
      * @brief Returns the title of the discussion.
      *
-     * @return The title of the discussion.
+     * @return View of the title of the discussion, valid until the title is changed.
      */
-    std::string getDiscussionTitle() const;
+    std::string_view getDiscussionTitle() const;
 
     /**
      * @brief Returns the content of the discussion.
      *
-     * @return The content of the discussion.
+     * @return View of the content of the discussion, valid until the content is changed.
      */
-    std::string getDiscussionContents() const;
+    std::string_view getDiscussionContents() const;
 
     /**
      * @brief Returns the ID of the discussion creator.
@@ -116,12 +201,19 @@ public:
     unsigned int getDiscussionId() const;
 
     /**
-     * @brief Returns the number of comments in the discussion.
+     * @brief Returns the number of top-level comments in the discussion.
      *
-     * @return The number of comments in the discussion.
+     * @return The number of top-level comments in the discussion.
      */
     unsigned int getCommentNum() const;
 
+    /**
+     * @brief Returns the number of replies in the discussion, at any depth.
+     *
+     * @return The number of replies in the discussion.
+     */
+    unsigned int getReplyNum() const;
+
     /**
      * @brief Returns the unique ID for the comments in the discussion.
      *
@@ -130,11 +222,28 @@ public:
     unsigned int getCommentID() const;
 
     /**
-     * @brief Returns the array of comments in the discussion.
+     * @brief Returns a comment or a reply of the discussion.
      *
-     * @return Pointer to the comments array.
+     * @param slot Slot of the comment in the comment table, as returned by findComment.
+     * @return View of the comment, valid until a comment is added or removed.
      */
-    Comment* getDiscussionComments() const;
+    Comment getComment(unsigned int slot);
+
+    /**
+     * @brief Returns a comment or a reply of the discussion for reading.
+     *
+     * @param slot Slot of the comment in the comment table, as returned by findComment.
+     * @return View of the comment, valid until a comment is added or removed.
+     */
+    const Comment getComment(unsigned int slot) const;
+
+    /**
+     * @brief Looks up a comment or a reply at any depth by ID.
+     *
+     * @param commentId Comment ID.
+     * @return Slot of the comment in the comment table, or -1 if there is no such comment.
+     */
+    int findComment(unsigned int commentId) const;
 
     //topics[id].discussions[id].<command>
 
@@ -142,33 +251,39 @@ public:
      * @brief Adds a new comment to the discussion.
      *
      * @param authorId The ID of the author of the comment.
+     * @param text Comment text.
      */
-    void addComment(unsigned int authorId);
+    void addComment(unsigned int authorId, const std::string& text);
 
     /**
-     * @brief Adds a reply to an existing comment.
+     * @brief Adds a reply to an existing comment or reply.
      *
      * @param authorId Reply author ID.
-     * @param commentId The ID of the comment to which the reply is being added to.
+     * @param commentId The ID of the comment or reply to which the reply is being added to.
+     * @param text Reply text.
+     * @return True if the reply was added, false if there is no such comment.
      */
-    void commentReply(unsigned int authorId, unsigned int commentId);
+    bool commentReply(unsigned int authorId, unsigned int commentId, const std::string& text);
 
     /**
      * @brief Vote for a comment.
      *
      * @param curUserId Current user ID.
      * @param commentId Comment ID being voted on.
+     * @param upvote True for an upvote, false for a downvote.
+     * @return False if there is no such comment or the user has already voted, otherwise true.
      */
-    void commentVote(unsigned int curUserId, unsigned int commentId);
+    bool commentVote(unsigned int curUserId, unsigned int commentId, bool upvote);
 
     /**
-     * @brief Removes comment from discussion.
+     * @brief Removes a comment or reply from the discussion, together with all replies to it.
+     *
+     * The slots are left empty and reclaimed once removed comments fill half of the table.
      *
-     * @param curUserId Current user ID.
      * @param commentId The ID of the comment to be removed.
-     * @param curUserPermission Current user permission.
+     * @return True if the comment was removed, false if there is no such comment.
      */
-    void removeComment(unsigned int curUserId, unsigned int commentId, Permission curUserPermission);
+    bool removeComment(unsigned int commentId);
 
     /**
      * @brief Lists all comments in the discussion.
@@ -176,16 +291,118 @@ public:
     void listComments() const;
 
     /**
-     * @brief Saves discussion data to a file.
+     * @brief Calls a function with the author and rating of every comment of the discussion, replies included.
+     *
+     * Removed comments that still hold a slot are visited with a rating of 0.
+     *
+     * @param visit Function taking the author ID and the rating.
+     */
+    template <typename Visit>
+    void forEachRating(Visit&& visit) const {
+        const unsigned int* authorIds = comments.getAuthorIds();
+        const int* ratings = comments.getRatings();
+        unsigned int count = comments.size();
+        for (unsigned int i = 0; i < count; i++) {
+            visit(authorIds[i], ratings[i]);
+        }
+    }
+
+    /**
+     * @brief Calls a function with every comment and reply of the discussion, each reply after the comment it answers.
+     *
+     * @param visit Function taking the comment.
+     */
+    template <typename Visit>
+    void forEachComment(Visit&& visit) const {
+        for (unsigned int i = firstComment; i != NO_COMMENT; i = nextInTree(i, NO_COMMENT)) {
+            visit(getComment(i));
+        }
+    }
+
+    /**
+     * @brief Calls a function with a comment and all replies below it.
+     *
+     * @param slot Slot of the comment.
+     * @param visit Function taking the comment or reply.
+     */
+    template <typename Visit>
+    void forEachCommentBelow(unsigned int slot, Visit&& visit) const {
+        for (unsigned int i = slot; i != NO_COMMENT; i = nextInTree(i, slot)) {
+            visit(getComment(i));
+        }
+    }
+
+    /**
+     * @brief Calls a function with the author and rating of a comment and of all replies below it.
+     *
+     * @param slot Slot of the comment.
+     * @param visit Function taking the author ID and the rating.
+     */
+    template <typename Visit>
+    void forEachRatingBelow(unsigned int slot, Visit&& visit) const {
+        for (unsigned int i = slot; i != NO_COMMENT; i = nextInTree(i, slot)) {
+            visit(comments.getAuthorId(i), comments.getRating(i));
+        }
+    }
+
+    /**
+     * @brief Lists the fields of a discussion stored in old-format files, comments included.
+     *
+     * Instantiated with BinaryReader to load a discussion; files are only written as snapshots.
+     * Every comment is followed by the number of its replies and then, for each reply, the bytes
+     * of a std::vector: the old writer dumped the vector objects instead of the replies they held.
+     * Those bytes are skipped, so replies cannot be recovered from these files.
+     *
+     * @param archive Binary reader.
+     * @param self The discussion.
+     */
+    template <typename Archive, typename Self>
+    static void schema(Archive& archive, Self& self) {
+        archive(self.title, self.contents, self.creatorId, self.id, self.commentNum, self.commentID);
+        if (!archive.good()) {
+            return;
+        }
+        unsigned int topLevelNum = self.commentNum;
+        self.resetComments(topLevelNum < 2 ? 2 : topLevelNum + 1);
+        for (unsigned int i = 0; i < topLevelNum && archive.good(); i++) {
+            unsigned int slot = self.appendComment(NO_COMMENT, std::string_view(), 0, 0);
+            Comment comment = self.getComment(slot);
+            unsigned int replyNum = 0;
+            Comment::schema(archive, comment);
+            archive(replyNum);
+            archive.skipBytes(static_cast<std::uint64_t>(replyNum) * sizeof(std::vector<Comment>));
+        }
+        self.indexComments();
+    }
+
+    /**
+     * @brief Reads discussion data from a file, comments included.
+     *
+     * @param reader Binary reader.
+     */
+    void readFromFile(BinaryReader& reader);
+
+    /**
+     * @brief Fills a reserved discussion record of a snapshot, comments included.
+     *
+     * @param writer Snapshot writer.
+     * @param index Index of the reserved discussion record.
+     */
+    void writeToSnapshot(SnapshotWriter& writer, std::uint32_t index) const;
+
+    /**
+     * @brief Reads the discussion and its comments and replies from a snapshot record.
      *
-     * @param of The output file stream.
+     * @param reader Snapshot reader.
+     * @param record The discussion record.
+     * @return True if the record is valid, otherwise false.
      */
-    void writeToFile(std::ofstream& of);
+    bool readFromSnapshot(const SnapshotReader& reader, const SnapshotDiscussionRecord& record);
 
     /**
-     * @brief Reads discussion data from a file.
+     * @brief Copies text borrowed from a snapshot into owned storage, comments included.
      *
-     * @param iff The input file stream.
+     * The texts of comments and replies are copied into the arena of the comment table.
      */
-    void readFromFile(std::ifstream& iff);
+    void detachText();
 };
@@ -0,0 +1,163 @@
+﻿#include "IdIndex.h"
+
+static const std::size_t MIN_BUCKETS = 8; /**< Number of buckets of the first allocation. */
+
+/**
+ * @brief Default constructor, creates an empty index.
+ */
+IdIndex::IdIndex() : shift(32), count(0) {  }
+
+/**
+ * @brief Returns the bucket where the search for an ID starts.
+ *
+ * Sequential IDs differ only in their low bits, so the product is taken from its top bits.
+ *
+ * @param id The ID.
+ * @return Index of the bucket.
+ */
+std::size_t IdIndex::home(std::uint32_t id) const {
+    return static_cast<std::size_t>((id * 2654435769u) >> shift);
+}
+
+/**
+ * @brief Returns the bucket holding an ID or the unused bucket where it belongs.
+ * @param id The ID.
+ * @return Index of the bucket.
+ */
+std::size_t IdIndex::probe(std::uint32_t id) const {
+    std::size_t mask = entries.size() - 1;
+    std::size_t i = home(id);
+    while (entries[i].id != EMPTY && entries[i].id != id) {
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+/**
+ * @brief Rebuilds the table with a new number of buckets.
+ * @param bucketCount New number of buckets, a power of two.
+ */
+void IdIndex::rehash(std::size_t bucketCount) {
+    std::vector<Entry> old(bucketCount, Entry{ EMPTY, 0 });
+    old.swap(entries);
+    shift = 32;
+    for (std::size_t size = bucketCount; size > 1; size >>= 1) {
+        shift--;
+    }
+    for (const Entry& entry : old) {
+        if (entry.id != EMPTY) {
+            entries[probe(entry.id)] = entry;
+        }
+    }
+}
+
+/**
+ * @brief Removes all IDs.
+ */
+void IdIndex::clear() {
+    entries.clear();
+    shift = 32;
+    count = 0;
+}
+
+/**
+ * @brief Makes room for a number of IDs without growing in between.
+ * @param idCount Expected number of IDs.
+ */
+void IdIndex::reserve(std::size_t idCount) {
+    std::size_t bucketCount = entries.empty() ? MIN_BUCKETS : entries.size();
+    while (idCount * 4 >= bucketCount * 3) {
+        bucketCount *= 2;
+    }
+    if (bucketCount != entries.size()) {
+        rehash(bucketCount);
+    }
+}
+
+/**
+ * @brief Adds an ID.
+ * @param id The ID.
+ * @param slot Slot of the entity.
+ * @return True if the ID was added, false if it is already indexed.
+ */
+bool IdIndex::insert(std::uint32_t id, unsigned int slot) {
+    if (id == EMPTY) {
+        return false;
+    }
+    reserve(count + 1);
+    std::size_t i = probe(id);
+    if (entries[i].id == id) {
+        return false;
+    }
+    entries[i] = Entry{ id, slot };
+    count++;
+    return true;
+}
+
+/**
+ * @brief Changes the slot of an indexed ID, after its entity was moved.
+ * @param id The ID.
+ * @param slot New slot of the entity.
+ */
+void IdIndex::update(std::uint32_t id, unsigned int slot) {
+    if (entries.empty() || id == EMPTY) {
+        return;
+    }
+    std::size_t i = probe(id);
+    if (entries[i].id == id) {
+        entries[i].slot = slot;
+    }
+}
+
+/**
+ * @brief Removes an ID.
+ *
+ * Every following entry of the same probe run that may move into the freed bucket is moved
+ * there, repeatedly, so no lookup ever stops early at the gap.
+ *
+ * @param id The ID.
+ * @return True if the ID was removed, false if it was not indexed.
+ */
+bool IdIndex::erase(std::uint32_t id) {
+    if (entries.empty() || id == EMPTY) {
+        return false;
+    }
+    std::size_t mask = entries.size() - 1;
+    std::size_t gap = probe(id);
+    if (entries[gap].id != id) {
+        return false;
+    }
+    for (std::size_t i = (gap + 1) & mask; entries[i].id != EMPTY; i = (i + 1) & mask) {
+        // the entry may fill the gap unless its home lies cyclically after the gap
+        std::size_t distanceToHome = (i - home(entries[i].id)) & mask;
+        std::size_t distanceToGap = (i - gap) & mask;
+        if (distanceToHome >= distanceToGap) {
+            entries[gap] = entries[i];
+            gap = i;
+        }
+    }
+    entries[gap].id = EMPTY;
+    count--;
+    return true;
+}
+
+/**
+ * @brief Looks up an ID.
+ * @param id The ID.
+ * @return Slot of the entity, or -1 if the ID is not indexed.
+ */
+int IdIndex::find(std::uint32_t id) const {
+    if (entries.empty() || id == EMPTY) {
+        return -1;
+    }
+    const Entry& entry = entries[probe(id)];
+    return entry.id == EMPTY ? -1 : static_cast<int>(entry.slot);
+}
+
+/**
+ * @brief Returns the number of indexed IDs.
+ * @return Number of IDs.
+ */
+std::size_t IdIndex::size() const {
+    return count;
+}
@@ -0,0 +1,102 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/**
+ * @class IdIndex
+ * @brief Open-addressing hash table from an entity ID to the slot of the entity in its array.
+ *
+ * IDs are spread by a multiplicative hash over a power-of-two table and probed linearly.
+ * Erasing shifts the following entries back instead of leaving markers, so lookups stay
+ * short however many entities come and go. An empty index allocates nothing.
+ */
+class IdIndex {
+private:
+    /**
+     * @struct Entry
+     * @brief One bucket of the table.
+     */
+    struct Entry {
+        std::uint32_t id;   /**< ID of the entity, EMPTY for an unused bucket. */
+        std::uint32_t slot; /**< Slot of the entity. */
+    };
+
+    static const std::uint32_t EMPTY = 0xFFFFFFFFu; /**< ID of an unused bucket. */
+
+    std::vector<Entry> entries; /**< The buckets, a power of two of them or none. */
+    unsigned int shift;         /**< 32 minus the number of bucket index bits. */
+    std::size_t count;          /**< Number of indexed IDs. */
+
+    /**
+     * @brief Returns the bucket where the search for an ID starts.
+     * @param id The ID.
+     * @return Index of the bucket.
+     */
+    std::size_t home(std::uint32_t id) const;
+
+    /**
+     * @brief Returns the bucket holding an ID or the unused bucket where it belongs.
+     * @param id The ID.
+     * @return Index of the bucket.
+     */
+    std::size_t probe(std::uint32_t id) const;
+
+    /**
+     * @brief Rebuilds the table with a new number of buckets.
+     * @param bucketCount New number of buckets, a power of two.
+     */
+    void rehash(std::size_t bucketCount);
+
+public:
+    /**
+     * @brief Default constructor, creates an empty index.
+     */
+    IdIndex();
+
+    /**
+     * @brief Removes all IDs.
+     */
+    void clear();
+
+    /**
+     * @brief Makes room for a number of IDs without growing in between.
+     * @param idCount Expected number of IDs.
+     */
+    void reserve(std::size_t idCount);
+
+    /**
+     * @brief Adds an ID.
+     * @param id The ID.
+     * @param slot Slot of the entity.
+     * @return True if the ID was added, false if it is already indexed.
+     */
+    bool insert(std::uint32_t id, unsigned int slot);
+
+    /**
+     * @brief Changes the slot of an indexed ID, after its entity was moved.
+     * @param id The ID.
+     * @param slot New slot of the entity.
+     */
+    void update(std::uint32_t id, unsigned int slot);
+
+    /**
+     * @brief Removes an ID.
+     * @param id The ID.
+     * @return True if the ID was removed, false if it was not indexed.
+     */
+    bool erase(std::uint32_t id);
+
+    /**
+     * @brief Looks up an ID.
+     * @param id The ID.
+     * @return Slot of the entity, or -1 if the ID is not indexed.
+     */
+    int find(std::uint32_t id) const;
+
+    /**
+     * @brief Returns the number of indexed IDs.
+     * @return Number of IDs.
+     */
+    std::size_t size() const;
+};
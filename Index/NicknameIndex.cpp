@@ -0,0 +1,155 @@
+﻿#include "NicknameIndex.h"
+#include <cstring>
+
+/**
+ * @brief Multiplies two 64-bit values and folds the 128-bit product into 64 bits.
+ * @param a First factor.
+ * @param b Second factor.
+ * @return High half of the product XOR its low half.
+ */
+static std::uint64_t mix(std::uint64_t a, std::uint64_t b) {
+#if defined(__SIZEOF_INT128__)
+    unsigned __int128 product = static_cast<unsigned __int128>(a) * b;
+    return static_cast<std::uint64_t>(product) ^ static_cast<std::uint64_t>(product >> 64);
+#else
+    std::uint64_t product = a * b;
+    return product ^ (product >> 32);
+#endif
+}
+
+/**
+ * @brief Default constructor, creates an empty index.
+ */
+NicknameIndex::NicknameIndex() : entries(16, Entry{ 0, EMPTY, 0, 0 }), count(0) {  }
+
+/**
+ * @brief Hashes a nickname, eight bytes at a time.
+ *
+ * Every full word is mixed by a 64x64-bit multiplication with the running state; the tail
+ * is padded with zeros and the length is folded in, so "a" and "a\0" differ.
+ *
+ * @param nickname The nickname.
+ * @return 32-bit hash.
+ */
+std::uint32_t NicknameIndex::hash(std::string_view nickname) {
+    const std::uint64_t SEED = 0x9E3779B97F4A7C15ull;
+    const std::uint64_t PRIME = 0xBF58476D1CE4E5B9ull;
+    const char* data = nickname.data();
+    std::size_t size = nickname.size();
+    std::uint64_t state = SEED ^ size;
+    while (size >= 8) {
+        std::uint64_t word;
+        std::memcpy(&word, data, sizeof(word));
+        state = mix(state ^ word, PRIME);
+        data += 8;
+        size -= 8;
+    }
+    if (size > 0) {
+        std::uint64_t word = 0;
+        std::memcpy(&word, data, size);
+        state = mix(state ^ word, PRIME);
+    }
+    state = mix(state, SEED);
+    return static_cast<std::uint32_t>(state ^ (state >> 32));
+}
+
+/**
+ * @brief Returns the bucket holding a nickname or the unused bucket where it belongs.
+ * @param nickname The nickname.
+ * @param hash Hash of the nickname.
+ * @return Index of the bucket.
+ */
+std::size_t NicknameIndex::probe(std::string_view nickname, std::uint32_t hash) const {
+    std::size_t mask = entries.size() - 1;
+    for (std::size_t i = hash & mask; ; i = (i + 1) & mask) {
+        const Entry& entry = entries[i];
+        if (entry.slot == EMPTY) {
+            return i;
+        }
+        // the stored hash rules out almost every other key before the characters are compared
+        if (entry.hash == hash && entry.keySize == nickname.size() &&
+            std::memcmp(keys.data() + entry.keyOffset, nickname.data(), nickname.size()) == 0) {
+            return i;
+        }
+    }
+}
+
+/**
+ * @brief Rebuilds the table with a new number of buckets.
+ * @param bucketCount New number of buckets, a power of two.
+ */
+void NicknameIndex::rehash(std::size_t bucketCount) {
+    std::vector<Entry> old(bucketCount, Entry{ 0, EMPTY, 0, 0 });
+    old.swap(entries);
+    std::size_t mask = bucketCount - 1;
+    for (const Entry& entry : old) {
+        if (entry.slot == EMPTY) {
+            continue;
+        }
+        std::size_t i = entry.hash & mask;
+        while (entries[i].slot != EMPTY) {
+            i = (i + 1) & mask;
+        }
+        entries[i] = entry;
+    }
+}
+
+/**
+ * @brief Removes all nicknames.
+ */
+void NicknameIndex::clear() {
+    entries.assign(16, Entry{ 0, EMPTY, 0, 0 });
+    keys.clear();
+    count = 0;
+}
+
+/**
+ * @brief Makes room for a number of nicknames without growing in between.
+ * @param nicknameCount Expected number of nicknames.
+ */
+void NicknameIndex::reserve(std::size_t nicknameCount) {
+    std::size_t bucketCount = entries.size();
+    while (nicknameCount * 4 >= bucketCount * 3) {
+        bucketCount *= 2;
+    }
+    if (bucketCount != entries.size()) {
+        rehash(bucketCount);
+    }
+}
+
+/**
+ * @brief Adds a nickname.
+ * @param nickname The nickname.
+ * @param slot Slot of the user.
+ * @return True if the nickname was added, false if it is already taken.
+ */
+bool NicknameIndex::insert(std::string_view nickname, unsigned int slot) {
+    reserve(count + 1);
+    std::uint32_t keyHash = hash(nickname);
+    std::size_t i = probe(nickname, keyHash);
+    if (entries[i].slot != EMPTY) {
+        return false;
+    }
+    entries[i] = Entry{ keyHash, slot, static_cast<std::uint32_t>(keys.size()), static_cast<std::uint32_t>(nickname.size()) };
+    keys.append(nickname.data(), nickname.size());
+    count++;
+    return true;
+}
+
+/**
+ * @brief Looks up a nickname.
+ * @param nickname The nickname.
+ * @return Slot of the user, or -1 if no user has the nickname.
+ */
+int NicknameIndex::find(std::string_view nickname) const {
+    const Entry& entry = entries[probe(nickname, hash(nickname))];
+    return entry.slot == EMPTY ? -1 : static_cast<int>(entry.slot);
+}
+
+/**
+ * @brief Returns the number of indexed nicknames.
+ * @return Number of nicknames.
+ */
+std::size_t NicknameIndex::size() const {
+    return count;
+}
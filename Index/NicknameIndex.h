@@ -0,0 +1,93 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+/**
+ * @class NicknameIndex
+ * @brief Open-addressing hash table from a user nickname to the slot of the user.
+ *
+ * The nicknames are copied into one character buffer owned by the index, so a lookup
+ * compares a std::string_view against them without building any std::string. Entries
+ * keep the full hash of their key, and probing is linear over a power-of-two table.
+ */
+class NicknameIndex {
+private:
+    /**
+     * @struct Entry
+     * @brief One bucket of the table.
+     */
+    struct Entry {
+        std::uint32_t hash;      /**< Hash of the nickname. */
+        std::uint32_t slot;      /**< Slot of the user, EMPTY for an unused bucket. */
+        std::uint32_t keyOffset; /**< Offset of the nickname in the key buffer. */
+        std::uint32_t keySize;   /**< Length of the nickname. */
+    };
+
+    static const std::uint32_t EMPTY = 0xFFFFFFFFu; /**< Slot of an unused bucket. */
+
+    std::vector<Entry> entries; /**< The buckets, a power of two of them. */
+    std::string keys;           /**< Characters of all indexed nicknames. */
+    std::size_t count;          /**< Number of indexed nicknames. */
+
+    /**
+     * @brief Returns the bucket holding a nickname or the unused bucket where it belongs.
+     * @param nickname The nickname.
+     * @param hash Hash of the nickname.
+     * @return Index of the bucket.
+     */
+    std::size_t probe(std::string_view nickname, std::uint32_t hash) const;
+
+    /**
+     * @brief Rebuilds the table with a new number of buckets.
+     * @param bucketCount New number of buckets, a power of two.
+     */
+    void rehash(std::size_t bucketCount);
+
+public:
+    /**
+     * @brief Default constructor, creates an empty index.
+     */
+    NicknameIndex();
+
+    /**
+     * @brief Hashes a nickname, eight bytes at a time.
+     * @param nickname The nickname.
+     * @return 32-bit hash.
+     */
+    static std::uint32_t hash(std::string_view nickname);
+
+    /**
+     * @brief Removes all nicknames.
+     */
+    void clear();
+
+    /**
+     * @brief Makes room for a number of nicknames without growing in between.
+     * @param nicknameCount Expected number of nicknames.
+     */
+    void reserve(std::size_t nicknameCount);
+
+    /**
+     * @brief Adds a nickname.
+     * @param nickname The nickname.
+     * @param slot Slot of the user.
+     * @return True if the nickname was added, false if it is already taken.
+     */
+    bool insert(std::string_view nickname, unsigned int slot);
+
+    /**
+     * @brief Looks up a nickname.
+     * @param nickname The nickname.
+     * @return Slot of the user, or -1 if no user has the nickname.
+     */
+    int find(std::string_view nickname) const;
+
+    /**
+     * @brief Returns the number of indexed nicknames.
+     * @return Number of nicknames.
+     */
+    std::size_t size() const;
+};
@@ -0,0 +1,361 @@
+﻿#include "PostSearchIndex.h"
+#include "Tokenizer.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/**
+ * @brief Orders hits so that the worst one is at the top of a heap.
+ * @param a A hit as score and document number.
+ * @param b Another hit.
+ * @return True if a is better than b, otherwise false.
+ */
+static bool isBetter(const std::pair<double, std::uint32_t>& a, const std::pair<double, std::uint32_t>& b) {
+    return a.first != b.first ? a.first > b.first : a.second < b.second;
+}
+
+/**
+ * @brief Default constructor, creates an empty index.
+ */
+PostSearchIndex::PostSearchIndex() : removedNum(0), totalLength(0) {  }
+
+/**
+ * @brief Combines a topic ID and a discussion ID into one key.
+ * @param topicId ID of the topic.
+ * @param discussionId ID of the discussion.
+ * @return The key.
+ */
+std::uint64_t PostSearchIndex::discussionKey(std::uint32_t topicId, std::uint32_t discussionId) {
+    return (static_cast<std::uint64_t>(topicId) << 32) | discussionId;
+}
+
+/**
+ * @brief Numbers a new document and adds its words to the posting lists.
+ *
+ * The new document has the highest number, so its postings always go to the end of the lists.
+ *
+ * @param document Where the document belongs; the length is filled in.
+ * @param first First text of the document.
+ * @param second Second text of the document, may be empty.
+ * @return Number of the document.
+ */
+std::uint32_t PostSearchIndex::addDocument(Document document, std::string_view first, std::string_view second) {
+    std::uint32_t documentId = static_cast<std::uint32_t>(documents.size());
+    std::uint32_t length = 0;
+    std::string word;
+    for (std::string_view text : { first, second }) {
+        std::size_t position = 0;
+        while (Tokenizer::nextWord(text, position, word)) {
+            std::vector<Posting>& list = postings[word];
+            if (list.empty() || list.back().documentId != documentId) {
+                list.push_back(Posting{ documentId, 0 });
+            }
+            list.back().wordCount++;
+            length++;
+        }
+    }
+    document.length = length;
+    documents.push_back(document);
+    removedDocuments.push_back(false);
+    totalLength += length;
+    return documentId;
+}
+
+/**
+ * @brief Flags a document as removed.
+ * @param documentId Number of the document.
+ */
+void PostSearchIndex::removeDocument(std::uint32_t documentId) {
+    if (removedDocuments[documentId]) {
+        return;
+    }
+    removedDocuments[documentId] = true;
+    removedNum++;
+    totalLength -= documents[documentId].length;
+}
+
+/**
+ * @brief Drops the removed documents from all posting lists and renumbers the others.
+ *
+ * Documents keep their order, so the posting lists stay ascending.
+ */
+void PostSearchIndex::compact() {
+    std::vector<std::uint32_t> newIds(documents.size(), NO_COMMENT);
+    std::uint32_t kept = 0;
+    for (std::size_t i = 0; i < documents.size(); i++) {
+        if (!removedDocuments[i]) {
+            newIds[i] = kept;
+            documents[kept++] = documents[i];
+        }
+    }
+    documents.resize(kept);
+    removedDocuments.assign(kept, false);
+    removedNum = 0;
+
+    for (auto it = postings.begin(); it != postings.end();) {
+        std::vector<Posting>& list = it->second;
+        std::size_t listKept = 0;
+        for (const Posting& posting : list) {
+            if (newIds[posting.documentId] != NO_COMMENT) {
+                list[listKept++] = Posting{ newIds[posting.documentId], posting.wordCount };
+            }
+        }
+        list.resize(listKept);
+        if (list.empty()) {
+            it = postings.erase(it);
+        }
+        else {
+            list.shrink_to_fit();
+            ++it;
+        }
+    }
+
+    for (auto& entry : discussions) {
+        std::vector<std::uint32_t>& ids = entry.second.documents;
+        std::size_t idsKept = 0;
+        for (std::uint32_t documentId : ids) {
+            std::uint32_t newId = newIds[documentId];
+            if (newId == NO_COMMENT) {
+                continue;
+            }
+            ids[idsKept++] = newId;
+            if (documents[newId].commentId != NO_COMMENT) {
+                entry.second.comments.update(documents[newId].commentId, newId);
+            }
+        }
+        ids.resize(idsKept);
+    }
+}
+
+/**
+ * @brief Compacts the index once removed documents outnumber the others.
+ */
+void PostSearchIndex::compactIfSparse() {
+    if (removedNum > documents.size() - removedNum) {
+        compact();
+    }
+}
+
+/**
+ * @brief Removes all documents.
+ */
+void PostSearchIndex::clear() {
+    postings.clear();
+    documents.clear();
+    removedDocuments.clear();
+    discussions.clear();
+    removedNum = 0;
+    totalLength = 0;
+}
+
+/**
+ * @brief Adds a discussion.
+ * @param topicId ID of the topic.
+ * @param discussionId ID of the discussion.
+ * @param title Discussion title.
+ * @param contents Discussion contents.
+ */
+void PostSearchIndex::addDiscussion(unsigned int topicId, unsigned int discussionId, std::string_view title, std::string_view contents) {
+    std::uint32_t documentId = addDocument(Document{ topicId, discussionId, NO_COMMENT, 0 }, title, contents);
+    discussions[discussionKey(topicId, discussionId)].documents.push_back(documentId);
+}
+
+/**
+ * @brief Adds a comment or reply to an indexed discussion.
+ *
+ * Comments of discussions that are not indexed are ignored.
+ *
+ * @param topicId ID of the topic.
+ * @param discussionId ID of the discussion.
+ * @param commentId ID of the comment or reply.
+ * @param text Comment text.
+ */
+void PostSearchIndex::addComment(unsigned int topicId, unsigned int discussionId, unsigned int commentId, std::string_view text) {
+    auto it = discussions.find(discussionKey(topicId, discussionId));
+    if (it == discussions.end()) {
+        return;
+    }
+    std::uint32_t documentId = addDocument(Document{ topicId, discussionId, commentId, 0 }, text, std::string_view());
+    it->second.documents.push_back(documentId);
+    it->second.comments.insert(commentId, documentId);
+}
+
+/**
+ * @brief Removes a discussion with all its comments and replies.
+ * @param topicId ID of the topic.
+ * @param discussionId ID of the discussion.
+ */
+void PostSearchIndex::removeDiscussion(unsigned int topicId, unsigned int discussionId) {
+    auto it = discussions.find(discussionKey(topicId, discussionId));
+    if (it == discussions.end()) {
+        return;
+    }
+    for (std::uint32_t documentId : it->second.documents) {
+        removeDocument(documentId);
+    }
+    discussions.erase(it);
+    compactIfSparse();
+}
+
+/**
+ * @brief Removes one comment or reply; its replies are removed separately.
+ * @param topicId ID of the topic.
+ * @param discussionId ID of the discussion.
+ * @param commentId ID of the comment or reply.
+ */
+void PostSearchIndex::removeComment(unsigned int topicId, unsigned int discussionId, unsigned int commentId) {
+    auto it = discussions.find(discussionKey(topicId, discussionId));
+    if (it == discussions.end()) {
+        return;
+    }
+    int documentId = it->second.comments.find(commentId);
+    if (documentId < 0) {
+        return;
+    }
+    it->second.comments.erase(commentId);
+    removeDocument(static_cast<std::uint32_t>(documentId));
+    compactIfSparse();
+}
+
+/**
+ * @brief Finds the discussions and comments most relevant to a query.
+ *
+ * Documents are scored with BM25 and visited in ascending order across the posting lists of the
+ * query words, keeping the best maxHits in a heap. Each word has an upper bound on what it can add
+ * to a score; once the heap is full, the words whose bounds together cannot lift a document past
+ * the worst kept hit stop proposing documents and are only looked up for the documents the other
+ * words propose (MaxScore), so common words are mostly skipped rather than read.
+ * Word frequencies include removed documents that were not compacted yet.
+ *
+ * @param query The query, any of its words may match.
+ * @param maxHits Largest number of hits returned.
+ * @return The hits, the most relevant first.
+ */
+std::vector<PostSearchIndex::Hit> PostSearchIndex::search(std::string_view query, std::size_t maxHits) const {
+    /**
+     * @brief A query word being matched.
+     */
+    struct Term {
+        const std::vector<Posting>* list; /**< Posting list of the word. */
+        double idf;                       /**< Inverse document frequency. */
+        double bound;                     /**< Highest score the word can add. */
+        std::size_t cursor;               /**< Next posting to be read. */
+    };
+
+    std::vector<Hit> hits;
+    std::size_t documentNum = documents.size() - removedNum;
+    if (maxHits == 0 || documentNum == 0) {
+        return hits;
+    }
+    std::vector<std::string> words;
+    std::vector<Term> terms;
+    std::string word;
+    std::size_t position = 0;
+    while (Tokenizer::nextWord(query, position, word)) {
+        if (std::find(words.begin(), words.end(), word) != words.end()) {
+            continue;
+        }
+        words.push_back(word);
+        auto it = postings.find(word);
+        if (it == postings.end()) {
+            continue;
+        }
+        double frequency = static_cast<double>(std::min(it->second.size(), documentNum));
+        double idf = std::log(1.0 + (documentNum - frequency + 0.5) / (frequency + 0.5));
+        terms.push_back(Term{ &it->second, idf, idf * (K1 + 1.0), 0 });
+    }
+    if (terms.empty()) {
+        return hits;
+    }
+    std::sort(terms.begin(), terms.end(), [](const Term& a, const Term& b) {
+        return a.bound < b.bound;
+    });
+    // bounds[i] is the most the words up to i can add together
+    std::vector<double> bounds(terms.size());
+    double sum = 0.0;
+    for (std::size_t i = 0; i < terms.size(); i++) {
+        sum += terms[i].bound;
+        bounds[i] = sum;
+    }
+
+    double averageLength = static_cast<double>(totalLength) / static_cast<double>(documentNum);
+    if (averageLength <= 0.0) {
+        averageLength = 1.0;
+    }
+    std::vector<std::pair<double, std::uint32_t>> best;
+    best.reserve(std::min(maxHits, documentNum) + 1);
+    double threshold = 0.0;
+    std::size_t firstEssential = 0;
+    while (firstEssential < terms.size()) {
+        std::uint32_t candidate = NO_COMMENT;
+        for (std::size_t i = firstEssential; i < terms.size(); i++) {
+            if (terms[i].cursor < terms[i].list->size()) {
+                candidate = std::min(candidate, (*terms[i].list)[terms[i].cursor].documentId);
+            }
+        }
+        if (candidate == NO_COMMENT) {
+            break;
+        }
+
+        double norm = K1 * (1.0 - B + B * documents[candidate].length / averageLength);
+        double score = 0.0;
+        for (std::size_t i = firstEssential; i < terms.size(); i++) {
+            Term& term = terms[i];
+            if (term.cursor < term.list->size() && (*term.list)[term.cursor].documentId == candidate) {
+                double count = (*term.list)[term.cursor].wordCount;
+                score += term.idf * count * (K1 + 1.0) / (count + norm);
+                term.cursor++;
+            }
+        }
+        if (removedDocuments[candidate]) {
+            continue;
+        }
+        bool full = best.size() == maxHits;
+        for (std::size_t i = firstEssential; i-- > 0;) {
+            if (full && score + bounds[i] <= threshold) {
+                break;
+            }
+            Term& term = terms[i];
+            auto next = std::lower_bound(term.list->begin() + term.cursor, term.list->end(), candidate, [](const Posting& p, std::uint32_t id) {
+                return p.documentId < id;
+            });
+            term.cursor = next - term.list->begin();
+            if (next != term.list->end() && next->documentId == candidate) {
+                double count = next->wordCount;
+                score += term.idf * count * (K1 + 1.0) / (count + norm);
+            }
+        }
+
+        if (!full) {
+            best.emplace_back(score, candidate);
+            std::push_heap(best.begin(), best.end(), isBetter);
+        }
+        else if (score > threshold) {
+            std::pop_heap(best.begin(), best.end(), isBetter);
+            best.back() = std::make_pair(score, candidate);
+            std::push_heap(best.begin(), best.end(), isBetter);
+        }
+        if (best.size() == maxHits) {
+            threshold = best.front().first;
+            while (firstEssential < terms.size() && bounds[firstEssential] <= threshold) {
+                firstEssential++;
+            }
+        }
+    }
+
+    std::sort_heap(best.begin(), best.end(), isBetter);
+    hits.reserve(best.size());
+    for (const std::pair<double, std::uint32_t>& entry : best) {
+        const Document& document = documents[entry.second];
+        hits.push_back(Hit{ document.topicId, document.discussionId, document.commentId, entry.first });
+    }
+    return hits;
+}
+
+/**
+ * @brief Returns the number of indexed documents.
+ * @return Number of discussions, comments and replies that were not removed.
+ */
+std::size_t PostSearchIndex::size() const {
+    return documents.size() - removedNum;
+}
@@ -0,0 +1,164 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "IdIndex.h"
+
+/**
+ * @class PostSearchIndex
+ * @brief Full-text index of discussions, comments and replies, ranked with BM25.
+ *
+ * Every discussion (title and contents) and every comment or reply is a document with a
+ * number assigned in the order it was added. Every word has a posting list of the documents
+ * using it, ascending by document, with the number of occurrences. Removed documents are only
+ * flagged; the lists are cleaned and the documents renumbered once removed ones outnumber the others.
+ */
+class PostSearchIndex {
+public:
+    static constexpr std::uint32_t NO_COMMENT = 0xFFFFFFFFu; /**< Comment ID of a hit on the discussion itself. */
+
+    /**
+     * @struct Hit
+     * @brief A discussion or comment found by a search.
+     */
+    struct Hit {
+        unsigned int topicId;      /**< ID of the topic. */
+        unsigned int discussionId; /**< ID of the discussion. */
+        unsigned int commentId;    /**< ID of the comment or reply, NO_COMMENT for the discussion itself. */
+        double score;              /**< BM25 score, higher is more relevant. */
+    };
+
+private:
+    static constexpr double K1 = 1.2; /**< BM25 saturation of repeated words. */
+    static constexpr double B = 0.75; /**< BM25 weight of the document length. */
+
+    /**
+     * @struct Posting
+     * @brief One document in the posting list of a word.
+     */
+    struct Posting {
+        std::uint32_t documentId; /**< Number of the document. */
+        std::uint32_t wordCount;  /**< Occurrences of the word in the document. */
+    };
+
+    /**
+     * @struct Document
+     * @brief Where an indexed text belongs and how long it is.
+     */
+    struct Document {
+        std::uint32_t topicId;      /**< ID of the topic. */
+        std::uint32_t discussionId; /**< ID of the discussion. */
+        std::uint32_t commentId;    /**< ID of the comment or reply, NO_COMMENT for the discussion itself. */
+        std::uint32_t length;       /**< Number of words. */
+    };
+
+    /**
+     * @struct DiscussionDocuments
+     * @brief The documents of one discussion.
+     */
+    struct DiscussionDocuments {
+        std::vector<std::uint32_t> documents; /**< The discussion and all its comments, ascending; removed ones may remain. */
+        IdIndex comments; /**< Document of every comment and reply by comment ID. */
+    };
+
+    std::unordered_map<std::string, std::vector<Posting>> postings; /**< Posting list of every word. */
+    std::vector<Document> documents; /**< Every document by number, removed ones included. */
+    std::vector<bool> removedDocuments; /**< Whether every document was removed. */
+    std::unordered_map<std::uint64_t, DiscussionDocuments> discussions; /**< Documents of every discussion by topic and discussion ID. */
+    std::size_t removedNum; /**< Number of removed documents still numbered. */
+    std::uint64_t totalLength; /**< Number of words in all documents that were not removed. */
+
+    /**
+     * @brief Combines a topic ID and a discussion ID into one key.
+     * @param topicId ID of the topic.
+     * @param discussionId ID of the discussion.
+     * @return The key.
+     */
+    static std::uint64_t discussionKey(std::uint32_t topicId, std::uint32_t discussionId);
+
+    /**
+     * @brief Numbers a new document and adds its words to the posting lists.
+     * @param document Where the document belongs; the length is filled in.
+     * @param first First text of the document.
+     * @param second Second text of the document, may be empty.
+     * @return Number of the document.
+     */
+    std::uint32_t addDocument(Document document, std::string_view first, std::string_view second);
+
+    /**
+     * @brief Flags a document as removed.
+     * @param documentId Number of the document.
+     */
+    void removeDocument(std::uint32_t documentId);
+
+    /**
+     * @brief Drops the removed documents from all posting lists and renumbers the others.
+     */
+    void compact();
+
+    /**
+     * @brief Compacts the index once removed documents outnumber the others.
+     */
+    void compactIfSparse();
+
+public:
+    /**
+     * @brief Default constructor, creates an empty index.
+     */
+    PostSearchIndex();
+
+    /**
+     * @brief Removes all documents.
+     */
+    void clear();
+
+    /**
+     * @brief Adds a discussion.
+     * @param topicId ID of the topic.
+     * @param discussionId ID of the discussion.
+     * @param title Discussion title.
+     * @param contents Discussion contents.
+     */
+    void addDiscussion(unsigned int topicId, unsigned int discussionId, std::string_view title, std::string_view contents);
+
+    /**
+     * @brief Adds a comment or reply to an indexed discussion.
+     * @param topicId ID of the topic.
+     * @param discussionId ID of the discussion.
+     * @param commentId ID of the comment or reply.
+     * @param text Comment text.
+     */
+    void addComment(unsigned int topicId, unsigned int discussionId, unsigned int commentId, std::string_view text);
+
+    /**
+     * @brief Removes a discussion with all its comments and replies.
+     * @param topicId ID of the topic.
+     * @param discussionId ID of the discussion.
+     */
+    void removeDiscussion(unsigned int topicId, unsigned int discussionId);
+
+    /**
+     * @brief Removes one comment or reply; its replies are removed separately.
+     * @param topicId ID of the topic.
+     * @param discussionId ID of the discussion.
+     * @param commentId ID of the comment or reply.
+     */
+    void removeComment(unsigned int topicId, unsigned int discussionId, unsigned int commentId);
+
+    /**
+     * @brief Finds the discussions and comments most relevant to a query.
+     * @param query The query, any of its words may match.
+     * @param maxHits Largest number of hits returned.
+     * @return The hits, the most relevant first.
+     */
+    std::vector<Hit> search(std::string_view query, std::size_t maxHits) const;
+
+    /**
+     * @brief Returns the number of indexed documents.
+     * @return Number of discussions, comments and replies that were not removed.
+     */
+    std::size_t size() const;
+};
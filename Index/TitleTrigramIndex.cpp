@@ -0,0 +1,435 @@
+﻿#include "TitleTrigramIndex.h"
+#include <algorithm>
+#include <cstring>
+#include "DeltaCodec.h"
+
+/**
+ * @brief Returns the trigram starting at a position of a text.
+ * @param text The text, at least three bytes from the position on.
+ * @param position Position of the first byte.
+ * @return The three bytes as one number.
+ */
+static std::uint32_t trigramAt(std::string_view text, std::size_t position) {
+    return (static_cast<std::uint32_t>(static_cast<unsigned char>(text[position])) << 16) |
+        (static_cast<std::uint32_t>(static_cast<unsigned char>(text[position + 1])) << 8) |
+        static_cast<unsigned char>(text[position + 2]);
+}
+
+/**
+ * @brief Appends a 32-bit number to a byte string.
+ * @param out The byte string.
+ * @param value The number.
+ */
+static void putUInt32(std::string& out, std::uint32_t value) {
+    out.append(reinterpret_cast<const char*>(&value), sizeof(value));
+}
+
+/**
+ * @brief Reads a 32-bit number from a byte string.
+ * @param data The byte string.
+ * @param position Position of the number, moved past it.
+ * @param value Receives the number.
+ * @return True if the number was inside the string, otherwise false.
+ */
+static bool getUInt32(std::string_view data, std::size_t& position, std::uint32_t& value) {
+    if (data.size() - position < sizeof(value)) {
+        return false;
+    }
+    std::memcpy(&value, data.data() + position, sizeof(value));
+    position += sizeof(value);
+    return true;
+}
+
+/**
+ * @brief Default constructor, creates an empty index.
+ */
+TitleTrigramIndex::TitleTrigramIndex() : removedNum(0) {  }
+
+/**
+ * @brief Numbers a new title and adds it to the posting lists of its trigrams.
+ *
+ * The new title has the highest number, so it always goes to the end of the lists;
+ * a trigram repeated in the title is listed once.
+ *
+ * @param title What the title belongs to.
+ * @param text The title.
+ * @return Number of the title.
+ */
+std::uint32_t TitleTrigramIndex::addTitle(Title title, std::string_view text) {
+    std::uint32_t titleId = static_cast<std::uint32_t>(titles.size());
+    for (std::size_t i = 0; i + GRAM_SIZE <= text.size(); i++) {
+        std::vector<std::uint32_t>& list = postings[trigramAt(text, i)];
+        if (list.empty() || list.back() != titleId) {
+            list.push_back(titleId);
+        }
+    }
+    titles.push_back(title);
+    removedTitles.push_back(false);
+    return titleId;
+}
+
+/**
+ * @brief Flags a title as removed.
+ * @param titleId Number of the title.
+ */
+void TitleTrigramIndex::removeTitle(std::uint32_t titleId) {
+    if (!removedTitles[titleId]) {
+        removedTitles[titleId] = true;
+        removedNum++;
+    }
+}
+
+/**
+ * @brief Numbers the titles that were not removed from zero, in their order.
+ * @param newIds Receives the new number of every title, NO_DISCUSSION for removed ones.
+ * @return Number of titles that were not removed.
+ */
+std::uint32_t TitleTrigramIndex::renumber(std::vector<std::uint32_t>& newIds) const {
+    newIds.assign(titles.size(), NO_DISCUSSION);
+    std::uint32_t kept = 0;
+    for (std::size_t i = 0; i < titles.size(); i++) {
+        if (!removedTitles[i]) {
+            newIds[i] = kept++;
+        }
+    }
+    return kept;
+}
+
+/**
+ * @brief Drops the removed titles and renumbers the others once removed ones outnumber them.
+ *
+ * Titles keep their order, so the posting lists stay ascending.
+ */
+void TitleTrigramIndex::compactIfSparse() {
+    if (removedNum <= titles.size() - removedNum) {
+        return;
+    }
+    std::vector<std::uint32_t> newIds;
+    std::uint32_t kept = renumber(newIds);
+    for (std::size_t i = 0; i < titles.size(); i++) {
+        if (newIds[i] != NO_DISCUSSION) {
+            titles[newIds[i]] = titles[i];
+        }
+    }
+    titles.resize(kept);
+    removedTitles.assign(kept, false);
+    removedNum = 0;
+
+    for (auto it = postings.begin(); it != postings.end();) {
+        std::vector<std::uint32_t>& list = it->second;
+        std::size_t listKept = 0;
+        for (std::uint32_t titleId : list) {
+            if (newIds[titleId] != NO_DISCUSSION) {
+                list[listKept++] = newIds[titleId];
+            }
+        }
+        list.resize(listKept);
+        if (list.empty()) {
+            it = postings.erase(it);
+        }
+        else {
+            list.shrink_to_fit();
+            ++it;
+        }
+    }
+
+    for (auto& entry : topics) {
+        std::vector<std::uint32_t>& ids = entry.second.titles;
+        std::size_t idsKept = 0;
+        for (std::uint32_t titleId : ids) {
+            std::uint32_t newId = newIds[titleId];
+            if (newId == NO_DISCUSSION) {
+                continue;
+            }
+            ids[idsKept++] = newId;
+            if (titles[newId].discussionId != NO_DISCUSSION) {
+                entry.second.discussions.update(titles[newId].discussionId, newId);
+            }
+        }
+        ids.resize(idsKept);
+    }
+}
+
+/**
+ * @brief Collects the titles of one kind that can contain a text.
+ *
+ * The shortest posting list of the trigrams of the text is walked and every title in it is
+ * looked up in the other lists, so the work follows the rarest trigram.
+ *
+ * @param part The text.
+ * @param discussionTitles True for discussion titles, false for topic titles.
+ * @return Numbers of the candidate titles, ascending.
+ */
+std::vector<std::uint32_t> TitleTrigramIndex::candidates(std::string_view part, bool discussionTitles) const {
+    std::vector<std::uint32_t> found;
+    auto wanted = [&](std::uint32_t titleId) {
+        return !removedTitles[titleId] && (titles[titleId].discussionId != NO_DISCUSSION) == discussionTitles;
+    };
+    if (part.size() < GRAM_SIZE) {
+        for (std::uint32_t i = 0; i < titles.size(); i++) {
+            if (wanted(i)) {
+                found.push_back(i);
+            }
+        }
+        return found;
+    }
+
+    std::vector<const std::vector<std::uint32_t>*> lists;
+    for (std::size_t i = 0; i + GRAM_SIZE <= part.size(); i++) {
+        auto it = postings.find(trigramAt(part, i));
+        if (it == postings.end()) {
+            return found;
+        }
+        if (std::find(lists.begin(), lists.end(), &it->second) == lists.end()) {
+            lists.push_back(&it->second);
+        }
+    }
+    std::sort(lists.begin(), lists.end(), [](const std::vector<std::uint32_t>* a, const std::vector<std::uint32_t>* b) {
+        return a->size() < b->size();
+    });
+    std::vector<std::size_t> cursors(lists.size(), 0);
+    for (std::uint32_t titleId : *lists[0]) {
+        if (!wanted(titleId)) {
+            continue;
+        }
+        bool inAll = true;
+        for (std::size_t i = 1; i < lists.size() && inAll; i++) {
+            const std::vector<std::uint32_t>& list = *lists[i];
+            cursors[i] = std::lower_bound(list.begin() + cursors[i], list.end(), titleId) - list.begin();
+            inAll = cursors[i] < list.size() && list[cursors[i]] == titleId;
+        }
+        if (inAll) {
+            found.push_back(titleId);
+        }
+    }
+    return found;
+}
+
+/**
+ * @brief Removes all titles.
+ */
+void TitleTrigramIndex::clear() {
+    titles.clear();
+    removedTitles.clear();
+    postings.clear();
+    topics.clear();
+    removedNum = 0;
+}
+
+/**
+ * @brief Adds the title of a topic.
+ * @param topicId ID of the topic.
+ * @param title Topic title.
+ */
+void TitleTrigramIndex::addTopic(unsigned int topicId, std::string_view title) {
+    std::uint32_t titleId = addTitle(Title{ topicId, NO_DISCUSSION }, title);
+    topics[topicId].titles.push_back(titleId);
+}
+
+/**
+ * @brief Adds the title of a discussion of an indexed topic.
+ *
+ * Discussions of topics that are not indexed are ignored.
+ *
+ * @param topicId ID of the topic.
+ * @param discussionId ID of the discussion.
+ * @param title Discussion title.
+ */
+void TitleTrigramIndex::addDiscussion(unsigned int topicId, unsigned int discussionId, std::string_view title) {
+    auto it = topics.find(topicId);
+    if (it == topics.end()) {
+        return;
+    }
+    std::uint32_t titleId = addTitle(Title{ topicId, discussionId }, title);
+    it->second.titles.push_back(titleId);
+    it->second.discussions.insert(discussionId, titleId);
+}
+
+/**
+ * @brief Removes the title of a topic and those of all its discussions.
+ * @param topicId ID of the topic.
+ */
+void TitleTrigramIndex::removeTopic(unsigned int topicId) {
+    auto it = topics.find(topicId);
+    if (it == topics.end()) {
+        return;
+    }
+    for (std::uint32_t titleId : it->second.titles) {
+        removeTitle(titleId);
+    }
+    topics.erase(it);
+    compactIfSparse();
+}
+
+/**
+ * @brief Removes the title of a discussion.
+ * @param topicId ID of the topic.
+ * @param discussionId ID of the discussion.
+ */
+void TitleTrigramIndex::removeDiscussion(unsigned int topicId, unsigned int discussionId) {
+    auto it = topics.find(topicId);
+    if (it == topics.end()) {
+        return;
+    }
+    int titleId = it->second.discussions.find(discussionId);
+    if (titleId < 0) {
+        return;
+    }
+    it->second.discussions.erase(discussionId);
+    removeTitle(static_cast<std::uint32_t>(titleId));
+    compactIfSparse();
+}
+
+/**
+ * @brief Finds the topics whose title can contain a text.
+ * @param part The text.
+ * @return IDs of the candidate topics in the order they were added; their titles must still be checked.
+ */
+std::vector<unsigned int> TitleTrigramIndex::findTopics(std::string_view part) const {
+    std::vector<unsigned int> found;
+    for (std::uint32_t titleId : candidates(part, false)) {
+        found.push_back(titles[titleId].topicId);
+    }
+    return found;
+}
+
+/**
+ * @brief Finds the discussions whose title can contain a text.
+ * @param part The text.
+ * @return Topic and discussion IDs of the candidates, ascending; their titles must still be checked.
+ */
+std::vector<std::pair<unsigned int, unsigned int>> TitleTrigramIndex::findDiscussions(std::string_view part) const {
+    std::vector<std::pair<unsigned int, unsigned int>> found;
+    for (std::uint32_t titleId : candidates(part, true)) {
+        found.emplace_back(titles[titleId].topicId, titles[titleId].discussionId);
+    }
+    // titles are numbered in the order they were added, which mixes the discussions of different topics
+    std::sort(found.begin(), found.end());
+    return found;
+}
+
+/**
+ * @brief Returns the number of indexed titles.
+ * @return Number of topic and discussion titles that were not removed.
+ */
+std::size_t TitleTrigramIndex::size() const {
+    return titles.size() - removedNum;
+}
+
+/**
+ * @brief Appends the index to a byte string, leaving out removed titles.
+ *
+ * Layout: number of titles, then topic and discussion ID of every title; number of posting lists,
+ * then every list as its trigram, number of titles, byte size and the delta coded title numbers.
+ *
+ * @param out Receives the bytes.
+ */
+void TitleTrigramIndex::write(std::string& out) const {
+    std::vector<std::uint32_t> newIds;
+    putUInt32(out, renumber(newIds));
+    for (std::size_t i = 0; i < titles.size(); i++) {
+        if (newIds[i] != NO_DISCUSSION) {
+            putUInt32(out, titles[i].topicId);
+            putUInt32(out, titles[i].discussionId);
+        }
+    }
+
+    std::size_t countPosition = out.size();
+    std::uint32_t listCount = 0;
+    putUInt32(out, 0);
+    std::vector<std::uint32_t> list;
+    std::string encoded;
+    for (const auto& entry : postings) {
+        list.clear();
+        for (std::uint32_t titleId : entry.second) {
+            if (newIds[titleId] != NO_DISCUSSION) {
+                list.push_back(newIds[titleId]);
+            }
+        }
+        if (list.empty()) {
+            continue;
+        }
+        encoded.clear();
+        DeltaCodec::encode(list.data(), list.size(), encoded);
+        putUInt32(out, entry.first);
+        putUInt32(out, static_cast<std::uint32_t>(list.size()));
+        putUInt32(out, static_cast<std::uint32_t>(encoded.size()));
+        out += encoded;
+        listCount++;
+    }
+    std::memcpy(&out[countPosition], &listCount, sizeof(listCount));
+}
+
+/**
+ * @brief Replaces the index with one written by write.
+ *
+ * Every count, ID and posting list is checked, so a damaged index is rejected instead of used.
+ *
+ * @param data The bytes.
+ * @return True if the bytes hold a whole, consistent index, otherwise false and the index is empty.
+ */
+bool TitleTrigramIndex::read(std::string_view data) {
+    clear();
+    std::size_t position = 0;
+    std::uint32_t titleCount = 0;
+    if (!getUInt32(data, position, titleCount) || titleCount > (data.size() - position) / (2 * sizeof(std::uint32_t))) {
+        clear();
+        return false;
+    }
+    titles.reserve(titleCount);
+    for (std::uint32_t i = 0; i < titleCount; i++) {
+        Title title{};
+        getUInt32(data, position, title.topicId);
+        getUInt32(data, position, title.discussionId);
+        auto topic = topics.find(title.topicId);
+        bool valid = true;
+        if (title.discussionId == NO_DISCUSSION) {
+            // a topic title comes before the titles of its discussions
+            valid = topic == topics.end();
+            topic = topics.emplace(title.topicId, TopicTitles()).first;
+        }
+        else {
+            valid = topic != topics.end() && topic->second.discussions.insert(title.discussionId, i);
+        }
+        if (!valid) {
+            clear();
+            return false;
+        }
+        topic->second.titles.push_back(i);
+        titles.push_back(title);
+    }
+    removedTitles.assign(titleCount, false);
+
+    std::uint32_t listCount = 0;
+    if (!getUInt32(data, position, listCount)) {
+        clear();
+        return false;
+    }
+    for (std::uint32_t i = 0; i < listCount; i++) {
+        std::uint32_t trigram = 0, count = 0, byteSize = 0;
+        if (!getUInt32(data, position, trigram) || !getUInt32(data, position, count) || !getUInt32(data, position, byteSize) ||
+            trigram >= (1u << 24) || count == 0 || count > titleCount || byteSize > data.size() - position ||
+            postings.find(trigram) != postings.end()) {
+            clear();
+            return false;
+        }
+        std::vector<std::uint32_t>& list = postings[trigram];
+        list.resize(count);
+        if (!DeltaCodec::decode(data.data() + position, byteSize, list.data(), count)) {
+            clear();
+            return false;
+        }
+        for (std::uint32_t j = 0; j < count; j++) {
+            if (list[j] >= titleCount || (j > 0 && list[j] <= list[j - 1])) {
+                clear();
+                return false;
+            }
+        }
+        position += byteSize;
+    }
+    if (position != data.size()) {
+        clear();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,160 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "IdIndex.h"
+
+/**
+ * @class TitleTrigramIndex
+ * @brief Index of topic and discussion titles by every three consecutive bytes they contain.
+ *
+ * A title containing a text contains every three-byte sequence (trigram) of the text, so the
+ * titles in all posting lists of its trigrams are the only ones that can contain it. Searches
+ * return these candidates and the caller verifies them with an exact substring match, so results
+ * stay exactly those of scanning every title. Texts shorter than a trigram match every title.
+ *
+ * Titles are numbered in the order they were added and posting lists are ascending. Removed
+ * titles are only flagged until they outnumber the others. The index can be written into a
+ * snapshot and read back, so it need not be rebuilt on load.
+ */
+class TitleTrigramIndex {
+public:
+    static constexpr std::uint32_t NO_DISCUSSION = 0xFFFFFFFFu; /**< Discussion ID of a topic title. */
+
+private:
+    static const std::size_t GRAM_SIZE = 3; /**< Bytes in a trigram. */
+
+    /**
+     * @struct Title
+     * @brief What an indexed title belongs to.
+     */
+    struct Title {
+        std::uint32_t topicId;      /**< ID of the topic. */
+        std::uint32_t discussionId; /**< ID of the discussion, NO_DISCUSSION for the title of the topic itself. */
+    };
+
+    /**
+     * @struct TopicTitles
+     * @brief The titles of one topic.
+     */
+    struct TopicTitles {
+        std::vector<std::uint32_t> titles; /**< The topic title and then its discussion titles, ascending; removed ones may remain. */
+        IdIndex discussions; /**< Title of every discussion by discussion ID. */
+    };
+
+    std::vector<Title> titles; /**< Every title by number, removed ones included. */
+    std::vector<bool> removedTitles; /**< Whether every title was removed. */
+    std::unordered_map<std::uint32_t, std::vector<std::uint32_t>> postings; /**< Titles containing every trigram. */
+    std::unordered_map<std::uint32_t, TopicTitles> topics; /**< Titles of every topic by topic ID. */
+    std::size_t removedNum; /**< Number of removed titles still numbered. */
+
+    /**
+     * @brief Numbers a new title and adds it to the posting lists of its trigrams.
+     * @param title What the title belongs to.
+     * @param text The title.
+     * @return Number of the title.
+     */
+    std::uint32_t addTitle(Title title, std::string_view text);
+
+    /**
+     * @brief Flags a title as removed.
+     * @param titleId Number of the title.
+     */
+    void removeTitle(std::uint32_t titleId);
+
+    /**
+     * @brief Numbers the titles that were not removed from zero, in their order.
+     * @param newIds Receives the new number of every title, NO_DISCUSSION for removed ones.
+     * @return Number of titles that were not removed.
+     */
+    std::uint32_t renumber(std::vector<std::uint32_t>& newIds) const;
+
+    /**
+     * @brief Drops the removed titles and renumbers the others once removed ones outnumber them.
+     */
+    void compactIfSparse();
+
+    /**
+     * @brief Collects the titles of one kind that can contain a text.
+     * @param part The text.
+     * @param discussionTitles True for discussion titles, false for topic titles.
+     * @return Numbers of the candidate titles, ascending.
+     */
+    std::vector<std::uint32_t> candidates(std::string_view part, bool discussionTitles) const;
+
+public:
+    /**
+     * @brief Default constructor, creates an empty index.
+     */
+    TitleTrigramIndex();
+
+    /**
+     * @brief Removes all titles.
+     */
+    void clear();
+
+    /**
+     * @brief Adds the title of a topic.
+     * @param topicId ID of the topic.
+     * @param title Topic title.
+     */
+    void addTopic(unsigned int topicId, std::string_view title);
+
+    /**
+     * @brief Adds the title of a discussion of an indexed topic.
+     * @param topicId ID of the topic.
+     * @param discussionId ID of the discussion.
+     * @param title Discussion title.
+     */
+    void addDiscussion(unsigned int topicId, unsigned int discussionId, std::string_view title);
+
+    /**
+     * @brief Removes the title of a topic and those of all its discussions.
+     * @param topicId ID of the topic.
+     */
+    void removeTopic(unsigned int topicId);
+
+    /**
+     * @brief Removes the title of a discussion.
+     * @param topicId ID of the topic.
+     * @param discussionId ID of the discussion.
+     */
+    void removeDiscussion(unsigned int topicId, unsigned int discussionId);
+
+    /**
+     * @brief Finds the topics whose title can contain a text.
+     * @param part The text.
+     * @return IDs of the candidate topics in the order they were added; their titles must still be checked.
+     */
+    std::vector<unsigned int> findTopics(std::string_view part) const;
+
+    /**
+     * @brief Finds the discussions whose title can contain a text.
+     * @param part The text.
+     * @return Topic and discussion IDs of the candidates, ascending; their titles must still be checked.
+     */
+    std::vector<std::pair<unsigned int, unsigned int>> findDiscussions(std::string_view part) const;
+
+    /**
+     * @brief Returns the number of indexed titles.
+     * @return Number of topic and discussion titles that were not removed.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Appends the index to a byte string, leaving out removed titles.
+     * @param out Receives the bytes.
+     */
+    void write(std::string& out) const;
+
+    /**
+     * @brief Replaces the index with one written by write.
+     * @param data The bytes.
+     * @return True if the bytes hold a whole, consistent index, otherwise false and the index is empty.
+     */
+    bool read(std::string_view data);
+};
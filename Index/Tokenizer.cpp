@@ -0,0 +1,34 @@
+﻿#include "Tokenizer.h"
+
+/**
+ * @brief Checks whether a byte belongs to a word.
+ * @param c The byte.
+ * @return True for ASCII letters and digits and for bytes of multi-byte UTF-8 characters.
+ */
+static bool isWordByte(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+/**
+ * @brief Reads the next word of a text.
+ * @param text The text.
+ * @param position Where to start reading; moved past the word.
+ * @param word Receives the word in lower case.
+ * @return True if a word was read, false at the end of the text.
+ */
+bool Tokenizer::nextWord(std::string_view text, std::size_t& position, std::string& word) {
+    while (position < text.size() && !isWordByte(static_cast<unsigned char>(text[position]))) {
+        position++;
+    }
+    if (position == text.size()) {
+        return false;
+    }
+    word.clear();
+    for (; position < text.size() && isWordByte(static_cast<unsigned char>(text[position])); position++) {
+        char c = text[position];
+        if (word.size() < MAX_WORD_SIZE) {
+            word.push_back(c >= 'A' && c <= 'Z' ? static_cast<char>(c - 'A' + 'a') : c);
+        }
+    }
+    return true;
+}
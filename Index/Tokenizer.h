@@ -0,0 +1,26 @@
+﻿#pragma once
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+/**
+ * @class Tokenizer
+ * @brief Splits texts into the words used by the search indexes.
+ *
+ * A word is a run of ASCII letters and digits or of bytes of multi-byte UTF-8 characters,
+ * so words in other scripts stay whole. ASCII letters are folded to lower case, so
+ * "Topic" and "topic" are the same word; everything else separates words.
+ */
+class Tokenizer {
+public:
+    static const std::size_t MAX_WORD_SIZE = 64; /**< Longer words are cut to this many bytes. */
+
+    /**
+     * @brief Reads the next word of a text.
+     * @param text The text.
+     * @param position Where to start reading; moved past the word.
+     * @param word Receives the word in lower case.
+     * @return True if a word was read, false at the end of the text.
+     */
+    static bool nextWord(std::string_view text, std::size_t& position, std::string& word);
+};
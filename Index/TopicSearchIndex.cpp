@@ -0,0 +1,180 @@
+﻿#include "TopicSearchIndex.h"
+#include "Tokenizer.h"
+#include <algorithm>
+#include <cmath>
+#include <utility>
+
+/**
+ * @brief Default constructor, creates an empty index.
+ */
+TopicSearchIndex::TopicSearchIndex() : topicNum(0) {  }
+
+/**
+ * @brief Adds the words of a text of a topic to their posting lists.
+ *
+ * Topics are usually added in ascending ID order, so the posting normally goes to the end
+ * of the list; a topic with a lower ID is inserted at its place.
+ *
+ * @param topicId ID of the topic.
+ * @param text Title or description.
+ * @param title True for the title, false for the description.
+ */
+void TopicSearchIndex::addWords(std::uint32_t topicId, std::string_view text, bool title) {
+    std::string word;
+    std::size_t position = 0;
+    while (Tokenizer::nextWord(text, position, word)) {
+        std::vector<Posting>& list = postings[word];
+        auto posting = list.end();
+        if (list.empty() || list.back().topicId < topicId) {
+            list.push_back(Posting{ topicId, 0, 0 });
+            posting = list.end() - 1;
+        }
+        else {
+            posting = std::lower_bound(list.begin(), list.end(), topicId, [](const Posting& p, std::uint32_t id) {
+                return p.topicId < id;
+            });
+            if (posting->topicId != topicId) {
+                posting = list.insert(posting, Posting{ topicId, 0, 0 });
+            }
+        }
+        std::uint16_t& count = title ? posting->titleCount : posting->descriptionCount;
+        if (count < 0xFFFF) {
+            count++;
+        }
+    }
+}
+
+/**
+ * @brief Drops the removed topics from all posting lists.
+ *
+ * Words left without topics are forgotten.
+ */
+void TopicSearchIndex::purgeRemoved() {
+    for (auto it = postings.begin(); it != postings.end();) {
+        std::vector<Posting>& list = it->second;
+        list.erase(std::remove_if(list.begin(), list.end(), [this](const Posting& p) {
+            return removedTopics.find(p.topicId) >= 0;
+        }), list.end());
+        if (list.empty()) {
+            it = postings.erase(it);
+        }
+        else {
+            ++it;
+        }
+    }
+    removedTopics.clear();
+}
+
+/**
+ * @brief Removes all topics.
+ */
+void TopicSearchIndex::clear() {
+    postings.clear();
+    removedTopics.clear();
+    topicNum = 0;
+}
+
+/**
+ * @brief Adds a topic.
+ * @param topicId ID of the topic.
+ * @param title Topic title.
+ * @param description Topic description.
+ */
+void TopicSearchIndex::addTopic(unsigned int topicId, std::string_view title, std::string_view description) {
+    if (removedTopics.find(topicId) >= 0) {
+        // the postings of the removed topic with the same ID must not be counted for this one
+        purgeRemoved();
+    }
+    addWords(topicId, title, true);
+    addWords(topicId, description, false);
+    topicNum++;
+}
+
+/**
+ * @brief Removes a topic.
+ *
+ * The topic is only marked as removed, so removing costs the same however common its words are.
+ * The posting lists are cleaned in one pass once removed topics outnumber the others.
+ *
+ * @param topicId ID of the topic.
+ */
+void TopicSearchIndex::removeTopic(unsigned int topicId) {
+    if (!removedTopics.insert(topicId, 0)) {
+        return;
+    }
+    topicNum--;
+    if (removedTopics.size() > topicNum) {
+        purgeRemoved();
+    }
+}
+
+/**
+ * @brief Finds the topics whose title or description contains every word of a query.
+ *
+ * Each word of a topic scores its occurrences, title ones TITLE_WEIGHT times, multiplied by
+ * the inverse document frequency of the word, so rare words weigh more than common ones.
+ * Topics with equal scores are returned in ascending ID order.
+ *
+ * @param query The query.
+ * @return IDs of the matching topics, the most relevant first.
+ */
+std::vector<unsigned int> TopicSearchIndex::search(std::string_view query) const {
+    std::vector<const std::vector<Posting>*> lists;
+    std::vector<std::string> words;
+    std::string word;
+    std::size_t position = 0;
+    while (Tokenizer::nextWord(query, position, word)) {
+        if (std::find(words.begin(), words.end(), word) != words.end()) {
+            continue;
+        }
+        auto it = postings.find(word);
+        if (it == postings.end()) {
+            return std::vector<unsigned int>();
+        }
+        lists.push_back(&it->second);
+        words.push_back(word);
+    }
+    if (lists.empty()) {
+        return std::vector<unsigned int>();
+    }
+    std::sort(lists.begin(), lists.end(), [](const std::vector<Posting>* a, const std::vector<Posting>* b) {
+        return a->size() < b->size();
+    });
+    double documentNum = static_cast<double>(topicNum + removedTopics.size());
+    std::vector<double> weights(lists.size());
+    for (std::size_t i = 0; i < lists.size(); i++) {
+        weights[i] = std::log(1.0 + documentNum / static_cast<double>(lists[i]->size()));
+    }
+
+    std::vector<std::pair<double, unsigned int>> matches;
+    std::vector<std::size_t> cursors(lists.size(), 0);
+    for (const Posting& candidate : *lists[0]) {
+        if (removedTopics.size() > 0 && removedTopics.find(candidate.topicId) >= 0) {
+            continue;
+        }
+        double score = (TITLE_WEIGHT * candidate.titleCount + candidate.descriptionCount) * weights[0];
+        bool inAll = true;
+        for (std::size_t i = 1; i < lists.size() && inAll; i++) {
+            const std::vector<Posting>& list = *lists[i];
+            cursors[i] = std::lower_bound(list.begin() + cursors[i], list.end(), candidate.topicId, [](const Posting& p, std::uint32_t id) {
+                return p.topicId < id;
+            }) - list.begin();
+            inAll = cursors[i] < list.size() && list[cursors[i]].topicId == candidate.topicId;
+            if (inAll) {
+                score += (TITLE_WEIGHT * list[cursors[i]].titleCount + list[cursors[i]].descriptionCount) * weights[i];
+            }
+        }
+        if (inAll) {
+            matches.emplace_back(score, candidate.topicId);
+        }
+    }
+    std::sort(matches.begin(), matches.end(), [](const std::pair<double, unsigned int>& a, const std::pair<double, unsigned int>& b) {
+        return a.first != b.first ? a.first > b.first : a.second < b.second;
+    });
+    std::vector<unsigned int> found;
+    found.reserve(matches.size());
+    for (const std::pair<double, unsigned int>& match : matches) {
+        found.push_back(match.second);
+    }
+    return found;
+}
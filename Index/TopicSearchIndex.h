@@ -0,0 +1,81 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "IdIndex.h"
+
+/**
+ * @class TopicSearchIndex
+ * @brief Inverted index from the words of topic titles and descriptions to the topics using them.
+ *
+ * Every word has a posting list of the topics it occurs in, ascending by topic ID, with the
+ * number of occurrences in the title and in the description. A query is answered by walking
+ * the shortest list of its words and looking the topic up in the others, so its cost follows
+ * the rarest word instead of the number of topics.
+ */
+class TopicSearchIndex {
+private:
+    /**
+     * @struct Posting
+     * @brief One topic in the posting list of a word.
+     */
+    struct Posting {
+        std::uint32_t topicId;          /**< ID of the topic. */
+        std::uint16_t titleCount;       /**< Occurrences of the word in the title. */
+        std::uint16_t descriptionCount; /**< Occurrences of the word in the description. */
+    };
+
+    static const unsigned int TITLE_WEIGHT = 3; /**< A word in the title counts as much as this many in the description. */
+
+    std::unordered_map<std::string, std::vector<Posting>> postings; /**< Posting list of every word. */
+    IdIndex removedTopics; /**< IDs of removed topics still in the posting lists. */
+    std::size_t topicNum;  /**< Number of indexed topics that were not removed. */
+
+    /**
+     * @brief Adds the words of a text of a topic to their posting lists.
+     * @param topicId ID of the topic.
+     * @param text Title or description.
+     * @param title True for the title, false for the description.
+     */
+    void addWords(std::uint32_t topicId, std::string_view text, bool title);
+
+    /**
+     * @brief Drops the removed topics from all posting lists.
+     */
+    void purgeRemoved();
+
+public:
+    /**
+     * @brief Default constructor, creates an empty index.
+     */
+    TopicSearchIndex();
+
+    /**
+     * @brief Removes all topics.
+     */
+    void clear();
+
+    /**
+     * @brief Adds a topic.
+     * @param topicId ID of the topic.
+     * @param title Topic title.
+     * @param description Topic description.
+     */
+    void addTopic(unsigned int topicId, std::string_view title, std::string_view description);
+
+    /**
+     * @brief Removes a topic.
+     * @param topicId ID of the topic.
+     */
+    void removeTopic(unsigned int topicId);
+
+    /**
+     * @brief Finds the topics whose title or description contains every word of a query.
+     * @param query The query.
+     * @return IDs of the matching topics, the most relevant first.
+     */
+    std::vector<unsigned int> search(std::string_view query) const;
+};
@@ -0,0 +1,137 @@
+﻿#include "AppendFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Default constructor, creates a closed file.
+ */
+#ifdef _WIN32
+AppendFile::AppendFile() : handle(INVALID_HANDLE_VALUE) {  }
+#else
+AppendFile::AppendFile() : fd(-1) {  }
+#endif
+
+/**
+ * @brief Destructor, closes the file.
+ */
+AppendFile::~AppendFile() {
+    close();
+}
+
+/**
+ * @brief Opens a file for appending, creating it if needed.
+ * @param fileName File name.
+ * @param truncate Whether existing contents are discarded.
+ * @return True if the file was opened, otherwise false.
+ */
+bool AppendFile::open(const std::string& fileName, bool truncate) {
+    close();
+#ifdef _WIN32
+    handle = CreateFileA(fileName.c_str(), FILE_APPEND_DATA, FILE_SHARE_READ, nullptr,
+        truncate ? CREATE_ALWAYS : OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    return handle != INVALID_HANDLE_VALUE;
+#else
+    fd = ::open(fileName.c_str(), O_WRONLY | O_APPEND | O_CREAT | (truncate ? O_TRUNC : 0), 0644);
+    return fd >= 0;
+#endif
+}
+
+/**
+ * @brief Closes the file.
+ */
+void AppendFile::close() {
+#ifdef _WIN32
+    if (handle != INVALID_HANDLE_VALUE) {
+        CloseHandle(handle);
+        handle = INVALID_HANDLE_VALUE;
+    }
+#else
+    if (fd >= 0) {
+        ::close(fd);
+        fd = -1;
+    }
+#endif
+}
+
+/**
+ * @brief Checks whether the file is open.
+ * @return True if the file is open, otherwise false.
+ */
+bool AppendFile::isOpen() const {
+#ifdef _WIN32
+    return handle != INVALID_HANDLE_VALUE;
+#else
+    return fd >= 0;
+#endif
+}
+
+/**
+ * @brief Appends bytes to the file. They reach the operating system, not necessarily the disk.
+ * @param data The bytes.
+ * @param size Number of bytes.
+ * @return True if all bytes were written, otherwise false.
+ */
+bool AppendFile::write(const char* data, std::size_t size) {
+    while (size > 0) {
+#ifdef _WIN32
+        DWORD written = 0;
+        DWORD chunk = size > 0x40000000 ? 0x40000000 : static_cast<DWORD>(size);
+        if (!WriteFile(handle, data, chunk, &written, nullptr)) {
+            return false;
+        }
+#else
+        ssize_t written = ::write(fd, data, size);
+        if (written < 0) {
+            return false;
+        }
+#endif
+        data += written;
+        size -= static_cast<std::size_t>(written);
+    }
+    return true;
+}
+
+/**
+ * @brief Waits until everything written so far is on stable storage.
+ * @return True if the sync succeeded, otherwise false.
+ */
+bool AppendFile::sync() {
+#ifdef _WIN32
+    return FlushFileBuffers(handle) != 0;
+#else
+    return fsync(fd) == 0;
+#endif
+}
+
+/**
+ * @brief Waits until the directory entries of the directory holding a file are on stable storage.
+ *
+ * Needed after a rename, which is only durable once the directory is synced. Windows offers
+ * no directory sync to applications and journals the rename itself, so nothing is done there.
+ *
+ * @param fileName File name.
+ * @return True if the sync succeeded, otherwise false.
+ */
+bool AppendFile::syncDirectoryOf(const std::string& fileName) {
+#ifdef _WIN32
+    (void)fileName;
+    return true;
+#else
+    std::string::size_type slash = fileName.find_last_of('/');
+    std::string directory = slash == std::string::npos ? "." : slash == 0 ? "/" : fileName.substr(0, slash);
+    int directoryFd = ::open(directory.c_str(), O_RDONLY | O_DIRECTORY);
+    if (directoryFd < 0) {
+        return false;
+    }
+    bool synced = fsync(directoryFd) == 0;
+    ::close(directoryFd);
+    return synced;
+#endif
+}
@@ -0,0 +1,72 @@
+﻿#pragma once
+#include <string>
+#include <cstddef>
+
+/**
+ * @class AppendFile
+ * @brief File opened for appending, with an explicit sync to stable storage.
+ *
+ * File streams cannot be synced, so the journal writes through the operating system directly.
+ */
+class AppendFile {
+private:
+#ifdef _WIN32
+    void* handle; /**< Windows file handle. */
+#else
+    int fd; /**< POSIX file descriptor. */
+#endif
+
+public:
+    /**
+     * @brief Default constructor, creates a closed file.
+     */
+    AppendFile();
+
+    AppendFile(const AppendFile& other) = delete;
+    AppendFile& operator=(const AppendFile& other) = delete;
+
+    /**
+     * @brief Destructor, closes the file.
+     */
+    ~AppendFile();
+
+    /**
+     * @brief Opens a file for appending, creating it if needed.
+     * @param fileName File name.
+     * @param truncate Whether existing contents are discarded.
+     * @return True if the file was opened, otherwise false.
+     */
+    bool open(const std::string& fileName, bool truncate);
+
+    /**
+     * @brief Closes the file.
+     */
+    void close();
+
+    /**
+     * @brief Checks whether the file is open.
+     * @return True if the file is open, otherwise false.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Appends bytes to the file. They reach the operating system, not necessarily the disk.
+     * @param data The bytes.
+     * @param size Number of bytes.
+     * @return True if all bytes were written, otherwise false.
+     */
+    bool write(const char* data, std::size_t size);
+
+    /**
+     * @brief Waits until everything written so far is on stable storage.
+     * @return True if the sync succeeded, otherwise false.
+     */
+    bool sync();
+
+    /**
+     * @brief Waits until the directory entries of the directory holding a file are on stable storage.
+     * @param fileName File name.
+     * @return True if the sync succeeded, otherwise false.
+     */
+    static bool syncDirectoryOf(const std::string& fileName);
+};
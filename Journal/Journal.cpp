@@ -0,0 +1,602 @@
+﻿#include "Journal.h"
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+
+/**
+ * @brief Magic bytes at the start of every journal file.
+ */
+static const char JOURNAL_MAGIC[8] = { 'S', 'N', 'E', 'T', 'J', 'R', 'N', 'L' };
+
+/**
+ * @brief Largest payload accepted when reading, so a damaged size field cannot exhaust memory.
+ */
+static const std::uint32_t JOURNAL_MAX_PAYLOAD = 64u * 1024u * 1024u;
+
+/**
+ * @brief Computes the FNV-1a checksum of a framed record.
+ * @param op Kind of the mutation.
+ * @param payload Encoded values.
+ * @return Checksum.
+ */
+static std::uint32_t recordChecksum(JournalOp op, const std::string& payload) {
+    std::uint32_t hash = 2166136261u;
+    hash = (hash ^ static_cast<std::uint8_t>(op)) * 16777619u;
+    for (char c : payload) {
+        hash = (hash ^ static_cast<std::uint8_t>(c)) * 16777619u;
+    }
+    return hash;
+}
+
+/**
+ * @brief Constructor for a record of the given kind.
+ * @param op Kind of the mutation.
+ */
+JournalRecord::JournalRecord(JournalOp op) : op(op) {  }
+
+/**
+ * @brief Constructor for a record read back from a journal file.
+ * @param op Kind of the mutation.
+ * @param payload Encoded values.
+ */
+JournalRecord::JournalRecord(JournalOp op, const std::string& payload) : op(op), payload(payload) {  }
+
+/**
+ * @brief Returns the kind of the mutation.
+ * @return Kind of the mutation.
+ */
+JournalOp JournalRecord::getOp() const {
+    return op;
+}
+
+/**
+ * @brief Returns the encoded values.
+ * @return Payload of the record.
+ */
+const std::string& JournalRecord::getPayload() const {
+    return payload;
+}
+
+/**
+ * @brief Appends an unsigned integer as a varint of seven bits per byte.
+ * @param value The value.
+ */
+void JournalRecord::putUInt(std::uint32_t value) {
+    putULong(value);
+}
+
+/**
+ * @brief Appends an unsigned 64-bit integer as a varint of seven bits per byte.
+ * @param value The value.
+ */
+void JournalRecord::putULong(std::uint64_t value) {
+    while (value >= 0x80) {
+        payload.push_back(static_cast<char>((value & 0x7F) | 0x80));
+        value >>= 7;
+    }
+    payload.push_back(static_cast<char>(value));
+}
+
+/**
+ * @brief Appends a signed integer, zigzag encoded so small negative values stay short.
+ * @param value The value.
+ */
+void JournalRecord::putInt(std::int32_t value) {
+    putUInt((static_cast<std::uint32_t>(value) << 1) ^ static_cast<std::uint32_t>(value >> 31));
+}
+
+/**
+ * @brief Appends a string prefixed with its size.
+ * @param value The value.
+ */
+void JournalRecord::putString(std::string_view value) {
+    putUInt(static_cast<std::uint32_t>(value.size()));
+    payload.append(value.data(), value.size());
+}
+
+/**
+ * @brief Constructor for a reader positioned at the first value of a record.
+ * @param record The record; it must outlive the reader.
+ */
+JournalRecordReader::JournalRecordReader(const JournalRecord& record) : payload(record.getPayload()), readPos(0) {  }
+
+/**
+ * @brief Reads the next unsigned integer.
+ * @param value Receives the value.
+ * @return True if a value was read, otherwise false.
+ */
+bool JournalRecordReader::getUInt(std::uint32_t& value) {
+    std::uint64_t wide = 0;
+    if (!getULong(wide) || wide > UINT32_MAX) {
+        return false;
+    }
+    value = static_cast<std::uint32_t>(wide);
+    return true;
+}
+
+/**
+ * @brief Reads the next unsigned 64-bit integer.
+ * @param value Receives the value.
+ * @return True if a value was read, otherwise false.
+ */
+bool JournalRecordReader::getULong(std::uint64_t& value) {
+    value = 0;
+    for (unsigned int shift = 0; shift < 64 && readPos < payload.size(); shift += 7) {
+        std::uint8_t byte = static_cast<std::uint8_t>(payload[readPos++]);
+        value |= static_cast<std::uint64_t>(byte & 0x7F) << shift;
+        if ((byte & 0x80) == 0) {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Reads the next signed integer.
+ * @param value Receives the value.
+ * @return True if a value was read, otherwise false.
+ */
+bool JournalRecordReader::getInt(std::int32_t& value) {
+    std::uint32_t encoded = 0;
+    if (!getUInt(encoded)) {
+        return false;
+    }
+    value = static_cast<std::int32_t>((encoded >> 1) ^ (~(encoded & 1) + 1));
+    return true;
+}
+
+/**
+ * @brief Reads the next string.
+ * @param value Receives the value.
+ * @return True if a value was read, otherwise false.
+ */
+bool JournalRecordReader::getString(std::string& value) {
+    std::uint32_t size = 0;
+    if (!getUInt(size) || size > payload.size() - readPos) {
+        return false;
+    }
+    value.assign(payload, readPos, size);
+    readPos += size;
+    return true;
+}
+
+/**
+ * @brief Waits until no batch is being written. The mutex must be held.
+ * @param lock Lock holding the mutex.
+ */
+void Journal::waitForBatch(std::unique_lock<std::mutex>& lock) {
+    batchWritten.wait(lock, [this] { return !writing; });
+}
+
+/**
+ * @brief Writes pending records to the file as one batch and optionally syncs them.
+ *
+ * The pending records are swapped out under the mutex and written with it released, so records
+ * appended meanwhile wait for the next batch instead of for the sync. Only one batch is written
+ * at a time, which keeps the records in order. A failed batch is put back in front of the pending
+ * records and the journal stops writing: the file may end in part of it, so writing it again
+ * would leave a damaged record in the middle of the journal.
+ *
+ * @param lock Lock holding the mutex.
+ * @param sync Whether to sync the file afterwards.
+ * @return True if the records were written, otherwise false.
+ */
+bool Journal::writePending(std::unique_lock<std::mutex>& lock, bool sync) {
+    waitForBatch(lock);
+    if (failed || !file.isOpen()) {
+        return false;
+    }
+    if (pending.empty()) {
+        return true;
+    }
+    std::string batch;
+    batch.swap(pending);
+    unsigned int batchRecords = pendingRecords;
+    pendingRecords = 0;
+    writing = true;
+
+    lock.unlock();
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    bool written = file.write(batch.data(), batch.size()) && (!sync || file.sync());
+    std::chrono::steady_clock::duration elapsed = std::chrono::steady_clock::now() - start;
+    lock.lock();
+
+    writing = false;
+    batchWritten.notify_all();
+    if (!written) {
+        failed = true;
+        batch += pending;
+        pending.swap(batch);
+        pendingRecords += batchRecords;
+        return false;
+    }
+    batchLatency.record(elapsed);
+    if (checkpointOpen) {
+        sinceCheckpoint += batch;
+    }
+    batchedRecords += batchRecords;
+    batches++;
+    return true;
+}
+
+/**
+ * @brief Body of the group commit thread.
+ *
+ * Sleeps until the oldest pending record has waited for the group interval, or until enough
+ * records arrived, then writes and syncs everything pending as one batch. After a failed write
+ * the thread sleeps until the journal is attached to a file again.
+ */
+void Journal::groupCommitLoop() {
+    std::unique_lock<std::mutex> lock(mutex);
+    while (!stopGroupThread) {
+        if (pendingRecords == 0 || failed || !file.isOpen()) {
+            wake.wait(lock);
+            continue;
+        }
+        std::chrono::steady_clock::time_point deadline = oldestPending + groupInterval;
+        if (pendingRecords >= groupRecords || std::chrono::steady_clock::now() >= deadline) {
+            writePending(lock, true);
+            continue;
+        }
+        wake.wait_until(lock, deadline);
+    }
+}
+
+/**
+ * @brief Stops the group commit thread if it is running.
+ */
+void Journal::stopGroupCommit() {
+    if (!groupThread.joinable()) {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        stopGroupThread = true;
+    }
+    wake.notify_all();
+    groupThread.join();
+    stopGroupThread = false;
+}
+
+/**
+ * @brief Default constructor, creates a detached journal in manual mode.
+ */
+Journal::Journal() : pendingRecords(0), durability(Durability::MANUAL), groupInterval(10), groupRecords(64),
+    batchedRecords(0), batches(0), checkpointOpen(false), writing(false), failed(false), stopGroupThread(false) {  }
+
+/**
+ * @brief Destructor, stops the group commit thread and writes out pending group records.
+ *
+ * In manual mode pending records are unsaved changes and are dropped.
+ */
+Journal::~Journal() {
+    stopGroupCommit();
+    std::unique_lock<std::mutex> lock(mutex);
+    if (durability == Durability::GROUP) {
+        writePending(lock, true);
+    }
+}
+
+/**
+ * @brief Returns the journal file name belonging to a snapshot file.
+ * @param snapshotFileName Snapshot file name.
+ * @return Journal file name.
+ */
+std::string Journal::journalFileName(const std::string& snapshotFileName) {
+    return snapshotFileName + ".journal";
+}
+
+/**
+ * @brief Reads all intact records of a journal file belonging to the given snapshot generation.
+ *
+ * A missing file or a file of another generation has no records for this snapshot, unless it is
+ * an older journal holding the checkpoint mark of the snapshot: a crash can happen after a background
+ * snapshot was put in place but before its records were moved into a journal of its own.
+ *
+ * @param fileName Journal file name.
+ * @param generation Generation of the loaded snapshot.
+ * @param records Receives the records.
+ * @return State of the journal file.
+ */
+JournalState Journal::readRecords(const std::string& fileName, std::uint64_t generation, std::vector<JournalRecord>& records) {
+    std::ifstream iff(fileName, std::ios::binary);
+    if (!iff.is_open()) {
+        return JournalState::EMPTY;
+    }
+
+    char magic[sizeof(JOURNAL_MAGIC)] = { 0 };
+    std::uint64_t fileGeneration = 0;
+    iff.read(magic, sizeof(magic));
+    iff.read(reinterpret_cast<char*>(&fileGeneration), sizeof(fileGeneration));
+    if (!iff || std::memcmp(magic, JOURNAL_MAGIC, sizeof(magic)) != 0 || fileGeneration > generation) {
+        return JournalState::EMPTY;
+    }
+    // records of an older generation are only read once the mark of this generation was seen
+    bool reading = fileGeneration == generation;
+
+    std::uint32_t size = 0;
+    while (iff.read(reinterpret_cast<char*>(&size), sizeof(size))) {
+        if (size > JOURNAL_MAX_PAYLOAD) {
+            return JournalState::DAMAGED;
+        }
+        std::uint8_t op = 0;
+        std::uint32_t checksum = 0;
+        std::string payload(size, '\0');
+        iff.read(reinterpret_cast<char*>(&op), sizeof(op));
+        iff.read(&payload[0], size);
+        iff.read(reinterpret_cast<char*>(&checksum), sizeof(checksum));
+        if (!iff || checksum != recordChecksum(static_cast<JournalOp>(op), payload)) {
+            return reading ? JournalState::DAMAGED : JournalState::EMPTY;
+        }
+        if (static_cast<JournalOp>(op) == JournalOp::CHECKPOINT) {
+            JournalRecord mark(JournalOp::CHECKPOINT, payload);
+            JournalRecordReader markReader(mark);
+            std::uint64_t markGeneration = 0;
+            if (!reading && markReader.getULong(markGeneration) && markGeneration == generation) {
+                reading = true;
+            }
+            continue;
+        }
+        if (reading) {
+            records.emplace_back(static_cast<JournalOp>(op), payload);
+        }
+    }
+    if (!reading) {
+        return JournalState::EMPTY;
+    }
+    return iff.gcount() == 0 ? JournalState::INTACT : JournalState::DAMAGED;
+}
+
+/**
+ * @brief Attaches the journal to an existing journal file; new records will be appended to it.
+ * @param fileName Journal file name.
+ * @return True if the file was opened, otherwise false.
+ */
+bool Journal::attach(const std::string& fileName) {
+    std::unique_lock<std::mutex> lock(mutex);
+    waitForBatch(lock);
+    failed = false;
+    if (!file.open(fileName, false)) {
+        this->fileName.clear();
+        return false;
+    }
+    this->fileName = fileName;
+    wake.notify_one();
+    return true;
+}
+
+/**
+ * @brief Starts a new, empty journal file for the given snapshot generation and attaches to it.
+ * @param fileName Journal file name.
+ * @param generation Generation of the snapshot the journal belongs to.
+ * @return True if the file was created, otherwise false.
+ */
+bool Journal::reset(const std::string& fileName, std::uint64_t generation) {
+    std::unique_lock<std::mutex> lock(mutex);
+    waitForBatch(lock);
+    failed = false;
+    checkpointOpen = false;
+    sinceCheckpoint.clear();
+    if (!file.open(fileName, true) || !file.write(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) ||
+        !file.write(reinterpret_cast<const char*>(&generation), sizeof(generation)) || !file.sync()) {
+        file.close();
+        this->fileName.clear();
+        return false;
+    }
+    this->fileName = fileName;
+    wake.notify_one();
+    return true;
+}
+
+/**
+ * @brief Detaches the journal from its file. Pending records are kept.
+ */
+void Journal::detach() {
+    std::unique_lock<std::mutex> lock(mutex);
+    waitForBatch(lock);
+    file.close();
+    fileName.clear();
+    checkpointOpen = false;
+    sinceCheckpoint.clear();
+}
+
+/**
+ * @brief Checks whether the journal is attached to a file.
+ * @return True if attached, otherwise false.
+ */
+bool Journal::isAttached() {
+    std::lock_guard<std::mutex> lock(mutex);
+    return !fileName.empty();
+}
+
+/**
+ * @brief Changes the durability mode.
+ *
+ * Records still pending from manual mode are written out right away under the new mode.
+ *
+ * @param mode The new mode.
+ * @param interval Longest wait of a record in group mode.
+ * @param records Number of records that triggers a group commit.
+ */
+void Journal::setDurability(Durability mode, std::chrono::milliseconds interval, unsigned int records) {
+    stopGroupCommit();
+    std::unique_lock<std::mutex> lock(mutex);
+    durability = mode;
+    groupInterval = interval;
+    groupRecords = records == 0 ? 1 : records;
+    appendLatency.clear();
+    batchLatency.clear();
+    batchedRecords = 0;
+    batches = 0;
+    if (mode != Durability::MANUAL) {
+        writePending(lock, mode != Durability::BUFFERED);
+    }
+    if (mode == Durability::GROUP) {
+        groupThread = std::thread(&Journal::groupCommitLoop, this);
+    }
+}
+
+/**
+ * @brief Queues a record and writes it out as the durability mode requires.
+ *
+ * In group mode the record is only queued; the group commit thread is woken by the first record
+ * of a batch and by the record that fills it, so commands never wait for a sync.
+ *
+ * @param record The record.
+ * @return False if the journal could not write its records, otherwise true.
+ */
+bool Journal::append(const JournalRecord& record) {
+    std::chrono::steady_clock::time_point start = std::chrono::steady_clock::now();
+    std::uint32_t size = static_cast<std::uint32_t>(record.getPayload().size());
+    std::uint8_t op = static_cast<std::uint8_t>(record.getOp());
+    std::uint32_t checksum = recordChecksum(record.getOp(), record.getPayload());
+
+    std::unique_lock<std::mutex> lock(mutex);
+    pending.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    pending.append(reinterpret_cast<const char*>(&op), sizeof(op));
+    pending.append(record.getPayload());
+    pending.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    if (pendingRecords == 0) {
+        oldestPending = start;
+    }
+    pendingRecords++;
+
+    if (durability == Durability::SYNC) {
+        writePending(lock, true);
+    }
+    else if (durability == Durability::BUFFERED) {
+        writePending(lock, false);
+    }
+    else if (durability == Durability::GROUP) {
+        if (pendingRecords == 1 || pendingRecords == groupRecords) {
+            wake.notify_one();
+        }
+    }
+    appendLatency.record(std::chrono::steady_clock::now() - start);
+    return !failed;
+}
+
+/**
+ * @brief Drops all pending records, used after they were folded into a snapshot.
+ */
+void Journal::clearPending() {
+    std::lock_guard<std::mutex> lock(mutex);
+    pending.clear();
+    pendingRecords = 0;
+}
+
+/**
+ * @brief Writes and syncs all pending records.
+ * @return True if the records were written, otherwise false.
+ */
+bool Journal::flush() {
+    std::unique_lock<std::mutex> lock(mutex);
+    return writePending(lock, true);
+}
+
+/**
+ * @brief Marks where a background snapshot is captured and syncs every record before the mark.
+ *
+ * Records appended later are kept aside as they are written, until the checkpoint finishes.
+ *
+ * @param generation Generation of the snapshot being written.
+ * @return True if the mark was written, otherwise false.
+ */
+bool Journal::beginCheckpoint(std::uint64_t generation) {
+    JournalRecord mark(JournalOp::CHECKPOINT);
+    mark.putULong(generation);
+    std::uint32_t size = static_cast<std::uint32_t>(mark.getPayload().size());
+    std::uint8_t op = static_cast<std::uint8_t>(JournalOp::CHECKPOINT);
+    std::uint32_t checksum = recordChecksum(JournalOp::CHECKPOINT, mark.getPayload());
+
+    std::unique_lock<std::mutex> lock(mutex);
+    if (fileName.empty() || failed) {
+        return false;
+    }
+    pending.append(reinterpret_cast<const char*>(&size), sizeof(size));
+    pending.append(reinterpret_cast<const char*>(&op), sizeof(op));
+    pending.append(mark.getPayload());
+    pending.append(reinterpret_cast<const char*>(&checksum), sizeof(checksum));
+    if (pendingRecords == 0) {
+        oldestPending = std::chrono::steady_clock::now();
+    }
+    pendingRecords++;
+    if (!writePending(lock, true)) {
+        return false;
+    }
+    checkpointOpen = true;
+    sinceCheckpoint.clear();
+    return true;
+}
+
+/**
+ * @brief Replaces the journal file with a journal of the new generation holding the records behind the mark.
+ *
+ * The new journal is written next to the old one and renamed over it, so a crash leaves either
+ * the old journal with the mark or the new one, and both replay the same records.
+ *
+ * @param generation Generation of the snapshot that was written.
+ * @return True if the new journal file is in place, otherwise false.
+ */
+bool Journal::finishCheckpoint(std::uint64_t generation) {
+    std::unique_lock<std::mutex> lock(mutex);
+    waitForBatch(lock);
+    if (!checkpointOpen) {
+        return false;
+    }
+    checkpointOpen = false;
+    std::string tempName = fileName + ".tmp";
+    AppendFile temp;
+    bool written = temp.open(tempName, true) && temp.write(JOURNAL_MAGIC, sizeof(JOURNAL_MAGIC)) &&
+        temp.write(reinterpret_cast<const char*>(&generation), sizeof(generation)) &&
+        temp.write(sinceCheckpoint.data(), sinceCheckpoint.size()) && temp.sync();
+    temp.close();
+    sinceCheckpoint.clear();
+    if (!written) {
+        std::remove(tempName.c_str());
+        return false;
+    }
+
+    file.close();
+#ifdef _WIN32
+    std::remove(fileName.c_str());
+#endif
+    bool renamed = std::rename(tempName.c_str(), fileName.c_str()) == 0;
+    if (!file.open(fileName, false)) {
+        fileName.clear();
+        return false;
+    }
+    return renamed;
+}
+
+/**
+ * @brief Forgets the checkpoint mark after the background snapshot failed; the journal stays as it is.
+ */
+void Journal::abortCheckpoint() {
+    std::lock_guard<std::mutex> lock(mutex);
+    checkpointOpen = false;
+    sinceCheckpoint.clear();
+}
+
+/**
+ * @brief Prints the durability mode and the latency histograms.
+ * @param os Output stream.
+ */
+void Journal::printStats(std::ostream& os) {
+    static const char* modeNames[] = { "manual", "sync", "group", "buffered" };
+    std::lock_guard<std::mutex> lock(mutex);
+    os << ">Durability: " << modeNames[static_cast<int>(durability)];
+    if (durability == Durability::GROUP) {
+        os << " (every " << groupInterval.count() << " ms or " << groupRecords << " records)";
+    }
+    os << ", pending records: " << pendingRecords << ", batches: " << batches;
+    if (batches > 0) {
+        os << ", records per batch: " << static_cast<double>(batchedRecords) / batches;
+    }
+    if (failed) {
+        os << ", writing failed";
+    }
+    os << "\n";
+    appendLatency.print(os, "append");
+    batchLatency.print(os, durability == Durability::BUFFERED ? "write per batch" : "write and sync per batch");
+}
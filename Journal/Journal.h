@@ -0,0 +1,347 @@
+﻿#pragma once
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include "AppendFile.h"
+#include "LatencyHistogram.h"
+
+/**
+ * @enum JournalOp
+ * @brief Kinds of mutations recorded in the journal.
+ */
+enum class JournalOp : std::uint8_t {
+    NONE = 0,          /**< Invalid or unused record. */
+    SIGNUP,            /**< A new user registered. */
+    EDIT_USER,         /**< A user changed a personal field. */
+    SET_ROLE,          /**< A moderator changed the role of a user. */
+    CREATE_TOPIC,      /**< A topic was created. */
+    REMOVE_TOPIC,      /**< A topic was removed. */
+    POST_DISCUSSION,   /**< A discussion was posted. */
+    REMOVE_DISCUSSION, /**< A discussion was removed. */
+    ADD_COMMENT,       /**< A comment was added. */
+    ADD_REPLY,         /**< A reply was added. */
+    COMMENT_VOTE,      /**< A comment was voted on. */
+    REMOVE_COMMENT,    /**< A comment was removed. */
+    CHECKPOINT         /**< A background snapshot of the next generation captured every record before this one. */
+};
+
+/**
+ * @enum Durability
+ * @brief When journal records reach the file and stable storage.
+ */
+enum class Durability {
+    MANUAL,   /**< Records are written and synced only on save. */
+    SYNC,     /**< Every record is written and synced before its command finishes. */
+    GROUP,    /**< Records are written and synced together every N milliseconds or N records. */
+    BUFFERED  /**< Every record is handed to the operating system, which decides when it reaches the disk. */
+};
+
+/**
+ * @enum JournalState
+ * @brief Result of reading a journal file.
+ */
+enum class JournalState {
+    EMPTY,   /**< No journal, or a journal of another snapshot generation. */
+    INTACT,  /**< Every record was read. */
+    DAMAGED  /**< The file ends in a damaged record; the records before it were read. */
+};
+
+/**
+ * @class JournalRecord
+ * @brief One mutation: its kind and a compact payload of integers and strings.
+ *
+ * Values are read back in the order they were put, through a JournalRecordReader.
+ */
+class JournalRecord {
+private:
+    JournalOp op; /**< Kind of the mutation. */
+    std::string payload; /**< Encoded values. */
+
+public:
+    /**
+     * @brief Constructor for a record of the given kind.
+     * @param op Kind of the mutation.
+     */
+    JournalRecord(JournalOp op = JournalOp::NONE);
+
+    /**
+     * @brief Constructor for a record read back from a journal file.
+     * @param op Kind of the mutation.
+     * @param payload Encoded values.
+     */
+    JournalRecord(JournalOp op, const std::string& payload);
+
+    /**
+     * @brief Returns the kind of the mutation.
+     * @return Kind of the mutation.
+     */
+    JournalOp getOp() const;
+
+    /**
+     * @brief Returns the encoded values.
+     * @return Payload of the record.
+     */
+    const std::string& getPayload() const;
+
+    /**
+     * @brief Appends an unsigned integer.
+     * @param value The value.
+     */
+    void putUInt(std::uint32_t value);
+
+    /**
+     * @brief Appends an unsigned 64-bit integer.
+     * @param value The value.
+     */
+    void putULong(std::uint64_t value);
+
+    /**
+     * @brief Appends a signed integer.
+     * @param value The value.
+     */
+    void putInt(std::int32_t value);
+
+    /**
+     * @brief Appends a string.
+     * @param value The value.
+     */
+    void putString(std::string_view value);
+};
+
+/**
+ * @class JournalRecordReader
+ * @brief Reads the values of a record back in the order they were put.
+ *
+ * The read position lives in the reader, so the record itself is never changed by reading it.
+ */
+class JournalRecordReader {
+private:
+    const std::string& payload; /**< Encoded values of the record being read. */
+    std::size_t readPos; /**< Position of the next value to read. */
+
+public:
+    /**
+     * @brief Constructor for a reader positioned at the first value of a record.
+     * @param record The record; it must outlive the reader.
+     */
+    explicit JournalRecordReader(const JournalRecord& record);
+
+    /**
+     * @brief Reads the next unsigned integer.
+     * @param value Receives the value.
+     * @return True if a value was read, otherwise false.
+     */
+    bool getUInt(std::uint32_t& value);
+
+    /**
+     * @brief Reads the next unsigned 64-bit integer.
+     * @param value Receives the value.
+     * @return True if a value was read, otherwise false.
+     */
+    bool getULong(std::uint64_t& value);
+
+    /**
+     * @brief Reads the next signed integer.
+     * @param value Receives the value.
+     * @return True if a value was read, otherwise false.
+     */
+    bool getInt(std::int32_t& value);
+
+    /**
+     * @brief Reads the next string.
+     * @param value Receives the value.
+     * @return True if a value was read, otherwise false.
+     */
+    bool getString(std::string& value);
+};
+
+/**
+ * @class Journal
+ * @brief Append-only log of mutations made since the last snapshot of a file.
+ *
+ * The journal file starts with the generation of the snapshot it belongs to, followed by
+ * framed records: payload size, kind, payload and a checksum. A record cut short by a crash
+ * fails its checksum and ends the replay.
+ *
+ * The durability mode decides when records are written and synced. In group mode a background
+ * thread syncs records that have waited for the group interval, so one sync covers a whole burst.
+ * A batch is taken out of the pending records under the mutex and written with the mutex released,
+ * so commands keep appending while the file is synced. Once a write fails the journal stops writing
+ * and keeps its records pending until it is reset or attached to a file again.
+ *
+ * While a snapshot is written in the background, a checkpoint record marks where it was captured.
+ * Records behind the mark belong to the new snapshot and are kept aside, so once the snapshot is
+ * in place they are moved into a fresh journal of its generation.
+ */
+class Journal {
+private:
+    std::string fileName; /**< Journal file, empty if no journal is attached. */
+    AppendFile file; /**< Open journal file. */
+    std::string pending; /**< Framed records not yet written to the file. */
+    unsigned int pendingRecords; /**< Number of records in pending. */
+    std::chrono::steady_clock::time_point oldestPending; /**< When the oldest pending record was appended. */
+
+    Durability durability; /**< Current durability mode. */
+    std::chrono::milliseconds groupInterval; /**< Longest wait of a record in group mode. */
+    unsigned int groupRecords; /**< Number of records that triggers a group commit. */
+
+    LatencyHistogram appendLatency; /**< Time spent in append, as seen by commands. */
+    LatencyHistogram batchLatency; /**< Time spent writing, and syncing if required, one batch of records. */
+    std::uint64_t batchedRecords; /**< Number of records written in batches. */
+    std::uint64_t batches; /**< Number of batches written. */
+
+    bool checkpointOpen; /**< Whether a background snapshot is being written. */
+    std::string sinceCheckpoint; /**< Framed records written to the file after the checkpoint mark. */
+
+    bool writing; /**< Whether a batch is being written with the mutex released. */
+    bool failed; /**< Whether a write or sync failed; nothing more is written until the file changes. */
+
+    std::mutex mutex; /**< Guards everything above, shared with the group commit thread. */
+    std::condition_variable wake; /**< Wakes the group commit thread. */
+    std::condition_variable batchWritten; /**< Wakes threads waiting for the batch being written. */
+    std::thread groupThread; /**< Group commit thread, running only in group mode. */
+    bool stopGroupThread; /**< Tells the group commit thread to finish. */
+
+    /**
+     * @brief Waits until no batch is being written. The mutex must be held.
+     * @param lock Lock holding the mutex.
+     */
+    void waitForBatch(std::unique_lock<std::mutex>& lock);
+
+    /**
+     * @brief Writes pending records to the file as one batch and optionally syncs them.
+     *
+     * The mutex must be held; it is released while the batch is written.
+     *
+     * @param lock Lock holding the mutex.
+     * @param sync Whether to sync the file afterwards.
+     * @return True if the records were written, otherwise false.
+     */
+    bool writePending(std::unique_lock<std::mutex>& lock, bool sync);
+
+    /**
+     * @brief Body of the group commit thread.
+     */
+    void groupCommitLoop();
+
+    /**
+     * @brief Stops the group commit thread if it is running.
+     */
+    void stopGroupCommit();
+
+public:
+    /**
+     * @brief Default constructor, creates a detached journal in manual mode.
+     */
+    Journal();
+
+    Journal(const Journal& other) = delete;
+    Journal& operator=(const Journal& other) = delete;
+
+    /**
+     * @brief Destructor, stops the group commit thread and writes out pending group records.
+     */
+    ~Journal();
+
+    /**
+     * @brief Returns the journal file name belonging to a snapshot file.
+     * @param snapshotFileName Snapshot file name.
+     * @return Journal file name.
+     */
+    static std::string journalFileName(const std::string& snapshotFileName);
+
+    /**
+     * @brief Reads all intact records of a journal file belonging to the given snapshot generation.
+     *
+     * A journal of an older generation still counts if it holds the checkpoint mark of the snapshot;
+     * only the records behind the mark are read.
+     *
+     * @param fileName Journal file name.
+     * @param generation Generation of the loaded snapshot.
+     * @param records Receives the records.
+     * @return State of the journal file.
+     */
+    static JournalState readRecords(const std::string& fileName, std::uint64_t generation, std::vector<JournalRecord>& records);
+
+    /**
+     * @brief Attaches the journal to an existing journal file; new records will be appended to it.
+     * @param fileName Journal file name.
+     * @return True if the file was opened, otherwise false.
+     */
+    bool attach(const std::string& fileName);
+
+    /**
+     * @brief Starts a new, empty journal file for the given snapshot generation and attaches to it.
+     * @param fileName Journal file name.
+     * @param generation Generation of the snapshot the journal belongs to.
+     * @return True if the file was created, otherwise false.
+     */
+    bool reset(const std::string& fileName, std::uint64_t generation);
+
+    /**
+     * @brief Detaches the journal from its file. Pending records are kept.
+     */
+    void detach();
+
+    /**
+     * @brief Checks whether the journal is attached to a file.
+     * @return True if attached, otherwise false.
+     */
+    bool isAttached();
+
+    /**
+     * @brief Changes the durability mode.
+     * @param mode The new mode.
+     * @param interval Longest wait of a record in group mode.
+     * @param records Number of records that triggers a group commit.
+     */
+    void setDurability(Durability mode, std::chrono::milliseconds interval, unsigned int records);
+
+    /**
+     * @brief Queues a record and writes it out as the durability mode requires.
+     * @param record The record.
+     * @return False if the journal could not write its records, otherwise true.
+     */
+    bool append(const JournalRecord& record);
+
+    /**
+     * @brief Drops all pending records, used after they were folded into a snapshot.
+     */
+    void clearPending();
+
+    /**
+     * @brief Writes and syncs all pending records.
+     * @return True if the records were written, otherwise false.
+     */
+    bool flush();
+
+    /**
+     * @brief Marks where a background snapshot is captured and syncs every record before the mark.
+     * @param generation Generation of the snapshot being written.
+     * @return True if the mark was written, otherwise false.
+     */
+    bool beginCheckpoint(std::uint64_t generation);
+
+    /**
+     * @brief Replaces the journal file with a journal of the new generation holding the records behind the mark.
+     * @param generation Generation of the snapshot that was written.
+     * @return True if the new journal file is in place, otherwise false.
+     */
+    bool finishCheckpoint(std::uint64_t generation);
+
+    /**
+     * @brief Forgets the checkpoint mark after the background snapshot failed; the journal stays as it is.
+     */
+    void abortCheckpoint();
+
+    /**
+     * @brief Prints the durability mode and the latency histograms.
+     * @param os Output stream.
+     */
+    void printStats(std::ostream& os);
+};
@@ -0,0 +1,78 @@
+﻿#include "LatencyHistogram.h"
+
+/**
+ * @brief Default constructor, creates an empty histogram.
+ */
+LatencyHistogram::LatencyHistogram() {
+    clear();
+}
+
+/**
+ * @brief Adds a sample.
+ * @param latency The latency.
+ */
+void LatencyHistogram::record(std::chrono::nanoseconds latency) {
+    std::uint64_t nanoseconds = latency.count() < 0 ? 0 : static_cast<std::uint64_t>(latency.count());
+    std::uint64_t microseconds = nanoseconds / 1000;
+    unsigned int bucket = 0;
+    while (bucket < BUCKETS - 1 && (static_cast<std::uint64_t>(1) << bucket) <= microseconds) {
+        bucket++;
+    }
+    buckets[bucket]++;
+    count++;
+    totalNanoseconds += nanoseconds;
+    if (nanoseconds > maxNanoseconds) {
+        maxNanoseconds = nanoseconds;
+    }
+}
+
+/**
+ * @brief Removes all samples.
+ */
+void LatencyHistogram::clear() {
+    for (unsigned int i = 0; i < BUCKETS; i++) {
+        buckets[i] = 0;
+    }
+    count = 0;
+    totalNanoseconds = 0;
+    maxNanoseconds = 0;
+}
+
+/**
+ * @brief Returns the upper bound of the bucket holding the given percentile.
+ * @param percentile Percentile between 0 and 100.
+ * @return Upper bound in microseconds.
+ */
+std::uint64_t LatencyHistogram::percentileMicroseconds(double percentile) const {
+    std::uint64_t target = static_cast<std::uint64_t>(count * percentile / 100.0);
+    std::uint64_t seen = 0;
+    for (unsigned int i = 0; i < BUCKETS; i++) {
+        seen += buckets[i];
+        if (seen > target) {
+            return static_cast<std::uint64_t>(1) << i;
+        }
+    }
+    return static_cast<std::uint64_t>(1) << (BUCKETS - 1);
+}
+
+/**
+ * @brief Prints the non-empty buckets and summary values.
+ * @param os Output stream.
+ * @param name Name of the histogram.
+ */
+void LatencyHistogram::print(std::ostream& os, const char* name) const {
+    os << "	" << name << ": " << count << " samples";
+    if (count == 0) {
+        os << "\n";
+        return;
+    }
+    os << ", avg " << totalNanoseconds / count / 1000.0 << " us, p50 < " << percentileMicroseconds(50)
+        << " us, p99 < " << percentileMicroseconds(99) << " us, max " << maxNanoseconds / 1000.0 << " us\n";
+    for (unsigned int i = 0; i < BUCKETS; i++) {
+        if (buckets[i] == 0) {
+            continue;
+        }
+        std::uint64_t low = i == 0 ? 0 : static_cast<std::uint64_t>(1) << (i - 1);
+        os << "		[" << low << ", " << (static_cast<std::uint64_t>(1) << i) << ") us: " << buckets[i] << "\n";
+    }
+}
@@ -0,0 +1,49 @@
+﻿#pragma once
+#include <chrono>
+#include <cstdint>
+#include <ostream>
+
+/**
+ * @class LatencyHistogram
+ * @brief Counts latencies in power-of-two microsecond buckets.
+ */
+class LatencyHistogram {
+private:
+    static const unsigned int BUCKETS = 32; /**< Bucket i holds latencies below 2^i microseconds. */
+
+    std::uint64_t buckets[BUCKETS]; /**< Number of samples per bucket. */
+    std::uint64_t count; /**< Number of samples. */
+    std::uint64_t totalNanoseconds; /**< Sum of all samples. */
+    std::uint64_t maxNanoseconds; /**< Largest sample. */
+
+public:
+    /**
+     * @brief Default constructor, creates an empty histogram.
+     */
+    LatencyHistogram();
+
+    /**
+     * @brief Adds a sample.
+     * @param latency The latency.
+     */
+    void record(std::chrono::nanoseconds latency);
+
+    /**
+     * @brief Removes all samples.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the upper bound of the bucket holding the given percentile.
+     * @param percentile Percentile between 0 and 100.
+     * @return Upper bound in microseconds.
+     */
+    std::uint64_t percentileMicroseconds(double percentile) const;
+
+    /**
+     * @brief Prints the non-empty buckets and summary values.
+     * @param os Output stream.
+     * @param name Name of the histogram.
+     */
+    void print(std::ostream& os, const char* name) const;
+};
@@ -27,18 +27,4 @@ public:
      * @return Pointer to the new User object (in this case Moderator).
      */
     virtual User* clone() const override;
-
-    /**
-     * @brief Saves moderator data to a file.
-     *
-     * @param of The output file stream.
-     */
-    virtual void writeToFile(std::ofstream& of) const override;
-
-    /**
-     * @brief Reads moderator data from a file.
-     *
-     * @param iff The input file stream.
-     */
-    virtual void readFromFile(std::ifstream& iff) override;
 };
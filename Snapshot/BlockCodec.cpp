@@ -0,0 +1,220 @@
+﻿#include "BlockCodec.h"
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+static const unsigned int HASH_BITS = 14; /**< Size of the match finder hash table as a power of two. */
+
+/**
+ * @brief Hashes the four bytes at a position of the block.
+ * @param p Pointer to the bytes.
+ * @return Index into the hash table.
+ */
+static std::uint32_t hashBytes(const unsigned char* p) {
+    std::uint32_t value;
+    std::memcpy(&value, p, sizeof(value));
+    return (value * 2654435761u) >> (32 - HASH_BITS);
+}
+
+/**
+ * @brief Writes the part of a length that does not fit into a token half.
+ * @param op Output position.
+ * @param length The remaining length.
+ * @return Output position after the length.
+ */
+static unsigned char* writeLength(unsigned char* op, std::size_t length) {
+    while (length >= 255) {
+        *op++ = 255;
+        length -= 255;
+    }
+    *op++ = static_cast<unsigned char>(length);
+    return op;
+}
+
+/**
+ * @brief Reads the part of a length that did not fit into a token half.
+ * @param ip Input position, moved past the length.
+ * @param end End of the input.
+ * @param length Receives the added length.
+ * @return True if the length is complete, otherwise false.
+ */
+static bool readLength(const unsigned char*& ip, const unsigned char* end, std::size_t& length) {
+    unsigned char byte;
+    do {
+        if (ip == end) {
+            return false;
+        }
+        byte = *ip++;
+        length += byte;
+    } while (byte == 255);
+    return true;
+}
+
+/**
+ * @brief Writes one sequence.
+ * @param op Output position.
+ * @param literals The literals.
+ * @param literalNum Number of literals.
+ * @param offset Distance back to the match.
+ * @param matchLength Length of the match, zero for the last sequence.
+ * @return Output position after the sequence.
+ */
+static unsigned char* writeSequence(unsigned char* op, const unsigned char* literals, std::size_t literalNum,
+    std::size_t offset, std::size_t matchLength) {
+    unsigned char* token = op++;
+    *token = static_cast<unsigned char>((literalNum >= 15 ? 15 : literalNum) << 4);
+    if (literalNum >= 15) {
+        op = writeLength(op, literalNum - 15);
+    }
+    std::memcpy(op, literals, literalNum);
+    op += literalNum;
+
+    if (matchLength > 0) {
+        *op++ = static_cast<unsigned char>(offset & 0xFF);
+        *op++ = static_cast<unsigned char>(offset >> 8);
+        std::size_t extra = matchLength - BlockCodec::MIN_MATCH;
+        *token |= static_cast<unsigned char>(extra >= 15 ? 15 : extra);
+        if (extra >= 15) {
+            op = writeLength(op, extra - 15);
+        }
+    }
+    return op;
+}
+
+/**
+ * @brief Returns the largest possible compressed size of a block.
+ * @param size Size of the block.
+ * @return Number of bytes the output buffer must hold.
+ */
+std::size_t BlockCodec::maxCompressedSize(std::size_t size) {
+    return size + size / 255 + 16;
+}
+
+/**
+ * @brief Compresses a block.
+ *
+ * Earlier positions with the same four bytes are kept in a hash table; from level 2 on every
+ * position also links to the previous one with the same hash, and the chain is followed
+ * to find the longest match. Matches are taken greedily.
+ *
+ * @param src The block.
+ * @param size Size of the block, at most MAX_BLOCK_SIZE.
+ * @param dst Receives the compressed block, must hold maxCompressedSize(size) bytes.
+ * @param level Compression level from 1 to MAX_LEVEL.
+ * @return Size of the compressed block.
+ */
+std::size_t BlockCodec::compress(const char* src, std::size_t size, char* dst, int level) {
+    if (level < 1) {
+        level = 1;
+    }
+    if (level > MAX_LEVEL) {
+        level = MAX_LEVEL;
+    }
+    const unsigned char* in = reinterpret_cast<const unsigned char*>(src);
+    unsigned char* op = reinterpret_cast<unsigned char*>(dst);
+    unsigned int depth = 1u << (level - 1);
+
+    std::vector<std::int32_t> head(static_cast<std::size_t>(1) << HASH_BITS, -1);
+    std::vector<std::int32_t> chain(level > 1 ? size : 0);
+
+    std::size_t anchor = 0;
+    std::size_t pos = 0;
+    while (pos + MIN_MATCH <= size) {
+        std::uint32_t hash = hashBytes(in + pos);
+        std::size_t bestLength = 0;
+        std::size_t bestOffset = 0;
+        std::int32_t candidate = head[hash];
+        for (unsigned int tries = 0; candidate >= 0 && tries < depth; tries++) {
+            std::size_t length = 0;
+            while (pos + length < size && in[candidate + length] == in[pos + length]) {
+                length++;
+            }
+            if (length > bestLength) {
+                bestLength = length;
+                bestOffset = pos - candidate;
+            }
+            candidate = level > 1 ? chain[candidate] : -1;
+        }
+        if (level > 1) {
+            chain[pos] = head[hash];
+        }
+        head[hash] = static_cast<std::int32_t>(pos);
+
+        if (bestLength < MIN_MATCH) {
+            pos++;
+            continue;
+        }
+        op = writeSequence(op, in + anchor, pos - anchor, bestOffset, bestLength);
+        std::size_t end = pos + bestLength;
+        // positions inside the match are only indexed when chains are searched anyway
+        for (pos++; level > 1 && pos < end && pos + MIN_MATCH <= size; pos++) {
+            hash = hashBytes(in + pos);
+            chain[pos] = head[hash];
+            head[hash] = static_cast<std::int32_t>(pos);
+        }
+        pos = end;
+        anchor = end;
+    }
+    op = writeSequence(op, in + anchor, size - anchor, 0, 0);
+    return static_cast<std::size_t>(op - reinterpret_cast<unsigned char*>(dst));
+}
+
+/**
+ * @brief Decompresses a block, checking every length and offset against both buffers.
+ * @param src The compressed block.
+ * @param srcSize Size of the compressed block.
+ * @param dst Receives the block.
+ * @param dstSize Size of the decompressed block.
+ * @return True if the block decoded to exactly dstSize bytes, otherwise false.
+ */
+bool BlockCodec::decompress(const char* src, std::size_t srcSize, char* dst, std::size_t dstSize) {
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* inEnd = ip + srcSize;
+    unsigned char* out = reinterpret_cast<unsigned char*>(dst);
+    unsigned char* op = out;
+    unsigned char* outEnd = out + dstSize;
+
+    while (ip < inEnd) {
+        unsigned char token = *ip++;
+        std::size_t literalNum = token >> 4;
+        if (literalNum == 15 && !readLength(ip, inEnd, literalNum)) {
+            return false;
+        }
+        if (literalNum > static_cast<std::size_t>(inEnd - ip) || literalNum > static_cast<std::size_t>(outEnd - op)) {
+            return false;
+        }
+        std::memcpy(op, ip, literalNum);
+        op += literalNum;
+        ip += literalNum;
+        if (ip == inEnd) {
+            break;
+        }
+
+        if (inEnd - ip < 2) {
+            return false;
+        }
+        std::size_t offset = ip[0] | (static_cast<std::size_t>(ip[1]) << 8);
+        ip += 2;
+        std::size_t matchLength = token & 15;
+        if (matchLength == 15 && !readLength(ip, inEnd, matchLength)) {
+            return false;
+        }
+        matchLength += MIN_MATCH;
+        if (offset == 0 || offset > static_cast<std::size_t>(op - out) || matchLength > static_cast<std::size_t>(outEnd - op)) {
+            return false;
+        }
+
+        const unsigned char* match = op - offset;
+        if (offset >= matchLength) {
+            std::memcpy(op, match, matchLength);
+        }
+        else {
+            // the match overlaps the bytes it produces, e.g. a run of one repeated character
+            for (std::size_t i = 0; i < matchLength; i++) {
+                op[i] = match[i];
+            }
+        }
+        op += matchLength;
+    }
+    return op == outEnd;
+}
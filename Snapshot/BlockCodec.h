@@ -0,0 +1,51 @@
+﻿#pragma once
+#include <cstddef>
+
+/**
+ * @class BlockCodec
+ * @brief Self-contained LZ77 codec for independent blocks of at most MAX_BLOCK_SIZE bytes.
+ *
+ * A block is a series of sequences. Each sequence has a token byte whose high half is the
+ * number of literals and low half the match length minus MIN_MATCH; a half of 15 continues
+ * in extra bytes of 255 until a smaller byte. The literals follow, then a two-byte offset
+ * back into the decoded block. The last sequence has literals only.
+ *
+ * Blocks never refer to each other, so they can be decoded in any order and on any thread.
+ */
+class BlockCodec {
+public:
+    static const std::size_t MAX_BLOCK_SIZE = 1u << 16; /**< Largest block, every offset fits into two bytes. */
+    static const std::size_t MIN_MATCH = 4; /**< Shortest match worth encoding. */
+    static const int MAX_LEVEL = 9; /**< Slowest level with the best ratio. */
+
+    /**
+     * @brief Returns the largest possible compressed size of a block.
+     * @param size Size of the block.
+     * @return Number of bytes the output buffer must hold.
+     */
+    static std::size_t maxCompressedSize(std::size_t size);
+
+    /**
+     * @brief Compresses a block.
+     *
+     * Level 1 tries one earlier position per byte; every further level doubles the number
+     * of earlier positions tried, up to 256 at MAX_LEVEL.
+     *
+     * @param src The block.
+     * @param size Size of the block, at most MAX_BLOCK_SIZE.
+     * @param dst Receives the compressed block, must hold maxCompressedSize(size) bytes.
+     * @param level Compression level from 1 to MAX_LEVEL.
+     * @return Size of the compressed block.
+     */
+    static std::size_t compress(const char* src, std::size_t size, char* dst, int level);
+
+    /**
+     * @brief Decompresses a block, checking every length and offset against both buffers.
+     * @param src The compressed block.
+     * @param srcSize Size of the compressed block.
+     * @param dst Receives the block.
+     * @param dstSize Size of the decompressed block.
+     * @return True if the block decoded to exactly dstSize bytes, otherwise false.
+     */
+    static bool decompress(const char* src, std::size_t srcSize, char* dst, std::size_t dstSize);
+};
@@ -0,0 +1,103 @@
+﻿#include "DeltaCodec.h"
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define DELTA_CODEC_SSE2
+#endif
+
+/**
+ * @brief Adds eight one-byte differences to the previous ID and stores the eight IDs.
+ * @param deltas The eight differences, one byte each.
+ * @param previous The ID before the group.
+ * @param ids Receives the IDs.
+ * @return The last stored ID.
+ */
+static std::uint32_t addGroup(const unsigned char* deltas, std::uint32_t previous, std::uint32_t* ids) {
+#ifdef DELTA_CODEC_SSE2
+    const __m128i zero = _mm_setzero_si128();
+    __m128i bytes = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(deltas)), zero);
+    __m128i low = _mm_unpacklo_epi16(bytes, zero);
+    __m128i high = _mm_unpackhi_epi16(bytes, zero);
+    // prefix sums within each half of four lanes
+    low = _mm_add_epi32(low, _mm_slli_si128(low, 4));
+    low = _mm_add_epi32(low, _mm_slli_si128(low, 8));
+    high = _mm_add_epi32(high, _mm_slli_si128(high, 4));
+    high = _mm_add_epi32(high, _mm_slli_si128(high, 8));
+    low = _mm_add_epi32(low, _mm_set1_epi32(static_cast<int>(previous)));
+    high = _mm_add_epi32(high, _mm_shuffle_epi32(low, _MM_SHUFFLE(3, 3, 3, 3)));
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ids), low);
+    _mm_storeu_si128(reinterpret_cast<__m128i*>(ids + 4), high);
+    return ids[7];
+#else
+    for (int i = 0; i < 8; i++) {
+        previous += deltas[i];
+        ids[i] = previous;
+    }
+    return previous;
+#endif
+}
+
+/**
+ * @brief Appends the encoding of a run of IDs.
+ * @param ids The IDs, ideally ascending.
+ * @param count Number of IDs.
+ * @param out Receives the encoded bytes.
+ */
+void DeltaCodec::encode(const std::uint32_t* ids, std::size_t count, std::string& out) {
+    std::uint32_t previous = 0;
+    for (std::size_t i = 0; i < count; i++) {
+        std::uint32_t delta = ids[i] - previous;
+        previous = ids[i];
+        while (delta >= 0x80) {
+            out.push_back(static_cast<char>((delta & 0x7F) | 0x80));
+            delta >>= 7;
+        }
+        out.push_back(static_cast<char>(delta));
+    }
+}
+
+/**
+ * @brief Decodes a run of IDs.
+ *
+ * Eight one-byte differences are decoded at a time and summed with SSE2 where available;
+ * longer differences fall back to the byte-wise loop.
+ *
+ * @param src The encoded bytes.
+ * @param size Number of bytes available, the run may end earlier.
+ * @param ids Receives the IDs.
+ * @param count Number of IDs in the run.
+ * @return True if all IDs were decoded within size bytes, otherwise false.
+ */
+bool DeltaCodec::decode(const char* src, std::size_t size, std::uint32_t* ids, std::size_t count) {
+    const unsigned char* ip = reinterpret_cast<const unsigned char*>(src);
+    const unsigned char* end = ip + size;
+    std::uint32_t previous = 0;
+    std::size_t i = 0;
+    while (i < count) {
+        if (count - i >= 8 && end - ip >= 8) {
+            std::uint64_t group;
+            std::memcpy(&group, ip, sizeof(group));
+            if ((group & 0x8080808080808080ull) == 0) {
+                previous = addGroup(ip, previous, ids + i);
+                ip += 8;
+                i += 8;
+                continue;
+            }
+        }
+
+        std::uint32_t delta = 0;
+        for (unsigned int shift = 0; ; shift += 7) {
+            if (ip == end || shift > 28) {
+                return false;
+            }
+            unsigned char byte = *ip++;
+            delta |= static_cast<std::uint32_t>(byte & 0x7F) << shift;
+            if (byte < 0x80) {
+                break;
+            }
+        }
+        previous += delta;
+        ids[i++] = previous;
+    }
+    return true;
+}
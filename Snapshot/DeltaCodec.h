@@ -0,0 +1,39 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <string>
+
+/**
+ * @class DeltaCodec
+ * @brief Delta and varint coding of sorted ID runs, such as the voters of a comment.
+ *
+ * Every ID is stored as its difference to the previous one (the first as it is), in
+ * 7-bit groups with the high bit set on all but the last byte. Differences wrap around,
+ * so any run round-trips, but only ascending runs are small: dense voter IDs take one byte each.
+ */
+class DeltaCodec {
+public:
+    static const std::size_t MAX_BYTES_PER_ID = 5; /**< Longest encoding of one 32-bit difference. */
+
+    /**
+     * @brief Appends the encoding of a run of IDs.
+     * @param ids The IDs, ideally ascending.
+     * @param count Number of IDs.
+     * @param out Receives the encoded bytes.
+     */
+    static void encode(const std::uint32_t* ids, std::size_t count, std::string& out);
+
+    /**
+     * @brief Decodes a run of IDs.
+     *
+     * Eight one-byte differences are decoded at a time and summed with SSE2 where available;
+     * longer differences fall back to the byte-wise loop.
+     *
+     * @param src The encoded bytes.
+     * @param size Number of bytes available, the run may end earlier.
+     * @param ids Receives the IDs.
+     * @param count Number of IDs in the run.
+     * @return True if all IDs were decoded within size bytes, otherwise false.
+     */
+    static bool decode(const char* src, std::size_t size, std::uint32_t* ids, std::size_t count);
+};
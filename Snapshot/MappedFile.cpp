@@ -0,0 +1,143 @@
+﻿#include "MappedFile.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Default constructor, creates an empty mapping.
+ */
+MappedFile::MappedFile() : data(nullptr), size(0) {  }
+
+/**
+ * @brief Move constructor, takes over the mapping of another object.
+ * @param other The mapping to take over.
+ */
+MappedFile::MappedFile(MappedFile&& other) noexcept : data(other.data), size(other.size) {
+    other.data = nullptr;
+    other.size = 0;
+}
+
+/**
+ * @brief Move assignment, releases the current mapping and takes over another.
+ * @param other The mapping to take over.
+ * @return Reference to this mapping.
+ */
+MappedFile& MappedFile::operator=(MappedFile&& other) noexcept {
+    if (this != &other) {
+        close();
+        data = other.data;
+        size = other.size;
+        other.data = nullptr;
+        other.size = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief Destructor, releases the mapping.
+ */
+MappedFile::~MappedFile() {
+    close();
+}
+
+/**
+ * @brief Maps the given file into memory.
+ *
+ * The file handles are closed right away, the mapping itself keeps the file alive.
+ *
+ * @param fileName File name.
+ * @return True if the file was mapped, otherwise false.
+ */
+bool MappedFile::open(const std::string& fileName) {
+    close();
+#ifdef _WIN32
+    HANDLE file = CreateFileA(fileName.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr,
+        OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file == INVALID_HANDLE_VALUE) {
+        return false;
+    }
+    LARGE_INTEGER fileSize;
+    if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart == 0) {
+        CloseHandle(file);
+        return false;
+    }
+    HANDLE mapping = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr) {
+        return false;
+    }
+    void* view = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (view == nullptr) {
+        return false;
+    }
+    data = static_cast<const char*>(view);
+    size = static_cast<std::size_t>(fileSize.QuadPart);
+#else
+    int fd = ::open(fileName.c_str(), O_RDONLY);
+    if (fd < 0) {
+        return false;
+    }
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size == 0) {
+        ::close(fd);
+        return false;
+    }
+    void* view = mmap(nullptr, static_cast<std::size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    ::close(fd);
+    if (view == MAP_FAILED) {
+        return false;
+    }
+    data = static_cast<const char*>(view);
+    size = static_cast<std::size_t>(info.st_size);
+#endif
+    return true;
+}
+
+/**
+ * @brief Releases the mapping.
+ */
+void MappedFile::close() {
+    if (data == nullptr) {
+        return;
+    }
+#ifdef _WIN32
+    UnmapViewOfFile(data);
+#else
+    munmap(const_cast<char*>(data), size);
+#endif
+    data = nullptr;
+    size = 0;
+}
+
+/**
+ * @brief Checks whether a file is mapped.
+ * @return True if a file is mapped, otherwise false.
+ */
+bool MappedFile::isOpen() const {
+    return data != nullptr;
+}
+
+/**
+ * @brief Returns the start of the mapped bytes.
+ * @return Pointer to the mapped bytes.
+ */
+const char* MappedFile::getData() const {
+    return data;
+}
+
+/**
+ * @brief Returns the number of mapped bytes.
+ * @return Size of the mapping.
+ */
+std::size_t MappedFile::getSize() const {
+    return size;
+}
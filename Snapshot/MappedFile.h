@@ -0,0 +1,70 @@
+﻿#pragma once
+#include <string>
+#include <cstddef>
+
+/**
+ * @class MappedFile
+ * @brief Read-only memory mapping of a whole file.
+ */
+class MappedFile {
+private:
+    const char* data; /**< Start of the mapped bytes. */
+    std::size_t size; /**< Number of mapped bytes. */
+
+public:
+    /**
+     * @brief Default constructor, creates an empty mapping.
+     */
+    MappedFile();
+
+    /**
+     * @brief Move constructor, takes over the mapping of another object.
+     * @param other The mapping to take over.
+     */
+    MappedFile(MappedFile&& other) noexcept;
+
+    /**
+     * @brief Move assignment, releases the current mapping and takes over another.
+     * @param other The mapping to take over.
+     * @return Reference to this mapping.
+     */
+    MappedFile& operator=(MappedFile&& other) noexcept;
+
+    MappedFile(const MappedFile& other) = delete;
+    MappedFile& operator=(const MappedFile& other) = delete;
+
+    /**
+     * @brief Destructor, releases the mapping.
+     */
+    ~MappedFile();
+
+    /**
+     * @brief Maps the given file into memory.
+     * @param fileName File name.
+     * @return True if the file was mapped, otherwise false.
+     */
+    bool open(const std::string& fileName);
+
+    /**
+     * @brief Releases the mapping.
+     */
+    void close();
+
+    /**
+     * @brief Checks whether a file is mapped.
+     * @return True if a file is mapped, otherwise false.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Returns the start of the mapped bytes.
+     * @return Pointer to the mapped bytes.
+     */
+    const char* getData() const;
+
+    /**
+     * @brief Returns the number of mapped bytes.
+     * @return Size of the mapping.
+     */
+    std::size_t getSize() const;
+};
@@ -0,0 +1,593 @@
+﻿#include "Snapshot.h"
+#include <atomic>
+#include <chrono>
+#include <cstring>
+#include <fstream>
+#include <thread>
+#include <utility>
+#include "BlockCodec.h"
+#include "DeltaCodec.h"
+
+/**
+ * @brief Rounds an offset up to the next multiple of eight, so every table in the mapping is aligned.
+ * @param offset The offset.
+ * @return Aligned offset.
+ */
+static std::uint64_t alignOffset(std::uint64_t offset) {
+    return (offset + 7) & ~static_cast<std::uint64_t>(7);
+}
+
+/**
+ * @brief Writes zero bytes until the stream reaches the given offset.
+ * @param of Output file stream.
+ * @param position Current offset in the stream.
+ * @param target The offset to reach.
+ */
+static void padTo(std::ofstream& of, std::uint64_t position, std::uint64_t target) {
+    const char zeros[8] = { 0 };
+    of.write(zeros, static_cast<std::streamsize>(target - position));
+}
+
+/**
+ * @brief Runs a task for every block of the string heap, spread over the cores.
+ *
+ * Worker threads and the calling thread pull block indexes from a shared counter.
+ *
+ * @param count Number of blocks.
+ * @param task Called with the index of every block.
+ */
+template <typename Task>
+static void forEachBlock(std::size_t count, const Task& task) {
+    std::atomic<std::size_t> nextBlock(0);
+    auto run = [&]() {
+        for (std::size_t i = nextBlock++; i < count; i = nextBlock++) {
+            task(i);
+        }
+    };
+    std::size_t threadCount = std::thread::hardware_concurrency();
+    if (threadCount > count) {
+        threadCount = count;
+    }
+    std::vector<std::thread> workers;
+    for (std::size_t i = 1; i < threadCount; i++) {
+        workers.emplace_back(run);
+    }
+    run();
+    for (std::thread& worker : workers) {
+        worker.join();
+    }
+}
+
+/**
+ * @brief Returns the seconds elapsed since a point in time.
+ * @param start The point in time.
+ * @return Elapsed seconds.
+ */
+static double secondsSince(std::chrono::steady_clock::time_point start) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Default constructor.
+ */
+SnapshotWriter::SnapshotWriter() : voterCount(0), generation(0), compressionLevel(0), stringStats{} {  }
+
+/**
+ * @brief Sets the checkpoint generation written to the header.
+ * @param generation The generation.
+ */
+void SnapshotWriter::setGeneration(std::uint64_t generation) {
+    this->generation = generation;
+}
+
+/**
+ * @brief Sets how strongly the string heap is compressed.
+ * @param level BlockCodec level from 1 to BlockCodec::MAX_LEVEL, or 0 to store it plainly.
+ */
+void SnapshotWriter::setCompressionLevel(int level) {
+    compressionLevel = level;
+}
+
+/**
+ * @brief Returns the compression figures of the last written string heap.
+ * @return The figures.
+ */
+const SnapshotStringStats& SnapshotWriter::getStringStats() const {
+    return stringStats;
+}
+
+/**
+ * @brief Appends a string to the string heap.
+ * @param str The string to append.
+ * @return Reference to the stored string.
+ */
+SnapshotStringRef SnapshotWriter::addString(std::string_view str) {
+    SnapshotStringRef ref{ strings.size(), static_cast<std::uint32_t>(str.size()), 0 };
+    strings.append(str.data(), str.size());
+    return ref;
+}
+
+/**
+ * @brief Appends a sorted run of voter IDs to the voter table.
+ * @param ids Voter IDs.
+ * @param count Number of voter IDs.
+ * @return Byte offset of the run in the voter table.
+ */
+std::uint64_t SnapshotWriter::addVoters(const unsigned int* ids, unsigned int count) {
+    std::uint64_t first = voters.size();
+    DeltaCodec::encode(ids, count, voters);
+    voterCount += count;
+    return first;
+}
+
+/**
+ * @brief Sets the title index written after the string heap.
+ * @param data The index as written by TitleTrigramIndex::write.
+ */
+void SnapshotWriter::setTitleIndex(std::string data) {
+    titleIndex = std::move(data);
+}
+
+/**
+ * @brief Appends a user record.
+ * @param record The user record.
+ */
+void SnapshotWriter::addUser(const SnapshotUserRecord& record) {
+    users.push_back(record);
+}
+
+/**
+ * @brief Reserves a contiguous block of topic records.
+ * @param count Number of records.
+ * @return Index of the first reserved record.
+ */
+std::uint32_t SnapshotWriter::reserveTopics(std::uint32_t count) {
+    std::uint32_t first = static_cast<std::uint32_t>(topics.size());
+    topics.resize(topics.size() + count, SnapshotTopicRecord{});
+    return first;
+}
+
+/**
+ * @brief Reserves a contiguous block of discussion records.
+ * @param count Number of records.
+ * @return Index of the first reserved record.
+ */
+std::uint32_t SnapshotWriter::reserveDiscussions(std::uint32_t count) {
+    std::uint32_t first = static_cast<std::uint32_t>(discussions.size());
+    discussions.resize(discussions.size() + count, SnapshotDiscussionRecord{});
+    return first;
+}
+
+/**
+ * @brief Reserves a contiguous block of comment records.
+ * @param count Number of records.
+ * @return Index of the first reserved record.
+ */
+std::uint32_t SnapshotWriter::reserveComments(std::uint32_t count) {
+    std::uint32_t first = static_cast<std::uint32_t>(comments.size());
+    comments.resize(comments.size() + count, SnapshotCommentRecord{});
+    return first;
+}
+
+/**
+ * @brief Returns a previously reserved topic record.
+ * @param index Index of the record.
+ * @return Reference to the record.
+ */
+SnapshotTopicRecord& SnapshotWriter::topicAt(std::uint32_t index) {
+    return topics[index];
+}
+
+/**
+ * @brief Returns a previously reserved discussion record.
+ * @param index Index of the record.
+ * @return Reference to the record.
+ */
+SnapshotDiscussionRecord& SnapshotWriter::discussionAt(std::uint32_t index) {
+    return discussions[index];
+}
+
+/**
+ * @brief Returns a previously reserved comment record.
+ * @param index Index of the record.
+ * @return Reference to the record.
+ */
+SnapshotCommentRecord& SnapshotWriter::commentAt(std::uint32_t index) {
+    return comments[index];
+}
+
+/**
+ * @brief Compresses the string heap in blocks.
+ *
+ * Blocks are compressed in parallel; a block that does not get smaller is stored as it is.
+ * The stored blocks follow the block table, so their offsets start after it.
+ *
+ * @param table Receives the block table.
+ * @param data Receives the stored blocks, back to back.
+ */
+void SnapshotWriter::compressStrings(std::vector<SnapshotStringBlock>& table, std::string& data) {
+    std::size_t blockCount = (strings.size() + SNAPSHOT_STRING_BLOCK_SIZE - 1) / SNAPSHOT_STRING_BLOCK_SIZE;
+    std::vector<std::string> stored(blockCount);
+    forEachBlock(blockCount, [&](std::size_t i) {
+        const char* raw = strings.data() + i * SNAPSHOT_STRING_BLOCK_SIZE;
+        std::size_t rawSize = strings.size() - i * SNAPSHOT_STRING_BLOCK_SIZE;
+        if (rawSize > SNAPSHOT_STRING_BLOCK_SIZE) {
+            rawSize = SNAPSHOT_STRING_BLOCK_SIZE;
+        }
+        std::string& block = stored[i];
+        block.resize(BlockCodec::maxCompressedSize(rawSize));
+        std::size_t size = BlockCodec::compress(raw, rawSize, &block[0], compressionLevel);
+        if (size < rawSize) {
+            block.resize(size);
+        }
+        else {
+            block.assign(raw, rawSize);
+        }
+    });
+
+    table.resize(blockCount);
+    std::uint64_t offset = blockCount * sizeof(SnapshotStringBlock);
+    for (std::size_t i = 0; i < blockCount; i++) {
+        std::size_t rawSize = strings.size() - i * SNAPSHOT_STRING_BLOCK_SIZE;
+        table[i].offset = offset;
+        table[i].storedSize = static_cast<std::uint32_t>(stored[i].size());
+        table[i].rawSize = static_cast<std::uint32_t>(rawSize < SNAPSHOT_STRING_BLOCK_SIZE ? rawSize : SNAPSHOT_STRING_BLOCK_SIZE);
+        offset += stored[i].size();
+        data += stored[i];
+    }
+}
+
+/**
+ * @brief Writes the collected records to a file.
+ *
+ * Layout: header, user table, topic table, discussion table, comment table, voter table, string heap, title index.
+ * Every table starts at an offset aligned to eight bytes. A compressed string heap starts with
+ * its block table, followed by the stored blocks.
+ *
+ * @param fileName File name.
+ * @return True if the whole snapshot was written, otherwise false.
+ */
+bool SnapshotWriter::writeToFile(const std::string& fileName) {
+    std::vector<SnapshotStringBlock> stringBlocks;
+    std::string storedStrings;
+    auto start = std::chrono::steady_clock::now();
+    if (compressionLevel > 0 && !strings.empty()) {
+        compressStrings(stringBlocks, storedStrings);
+    }
+    bool compressed = !stringBlocks.empty();
+
+
+    SnapshotHeader header{};
+    std::memcpy(header.magic, SNAPSHOT_MAGIC, sizeof(header.magic));
+    header.version = SNAPSHOT_VERSION;
+    header.headerSize = sizeof(SnapshotHeader);
+    header.userCount = static_cast<std::uint32_t>(users.size());
+    header.topicCount = static_cast<std::uint32_t>(topics.size());
+    header.discussionCount = static_cast<std::uint32_t>(discussions.size());
+    header.commentCount = static_cast<std::uint32_t>(comments.size());
+    header.voterCount = voterCount;
+    header.generation = generation;
+
+    header.usersOffset = alignOffset(sizeof(SnapshotHeader));
+    header.topicsOffset = alignOffset(header.usersOffset + users.size() * sizeof(SnapshotUserRecord));
+    header.discussionsOffset = alignOffset(header.topicsOffset + topics.size() * sizeof(SnapshotTopicRecord));
+    header.commentsOffset = alignOffset(header.discussionsOffset + discussions.size() * sizeof(SnapshotDiscussionRecord));
+    header.votersOffset = alignOffset(header.commentsOffset + comments.size() * sizeof(SnapshotCommentRecord));
+    header.stringsOffset = alignOffset(header.votersOffset + voters.size());
+    header.stringsSize = strings.size();
+    header.stringsEncoding = compressed ? SNAPSHOT_STRINGS_BLOCKS : SNAPSHOT_STRINGS_PLAIN;
+    header.stringBlockCount = static_cast<std::uint32_t>(stringBlocks.size());
+    header.votersSize = voters.size();
+    header.votersEncoding = SNAPSHOT_VOTERS_DELTA;
+    header.stringsStoredSize = compressed ? stringBlocks.size() * sizeof(SnapshotStringBlock) + storedStrings.size() : strings.size();
+    header.titleIndexOffset = alignOffset(header.stringsOffset + header.stringsStoredSize);
+    header.titleIndexSize = titleIndex.size();
+
+    stringStats.rawBytes = header.stringsSize;
+    stringStats.storedBytes = header.stringsStoredSize;
+    stringStats.blockCount = header.stringBlockCount;
+    stringStats.seconds = secondsSince(start);
+
+    std::ofstream of(fileName, std::ios::binary | std::ios::trunc);
+    if (!of.is_open()) {
+        return false;
+    }
+
+    of.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    padTo(of, sizeof(header), header.usersOffset);
+    of.write(reinterpret_cast<const char*>(users.data()), users.size() * sizeof(SnapshotUserRecord));
+    padTo(of, header.usersOffset + users.size() * sizeof(SnapshotUserRecord), header.topicsOffset);
+    of.write(reinterpret_cast<const char*>(topics.data()), topics.size() * sizeof(SnapshotTopicRecord));
+    padTo(of, header.topicsOffset + topics.size() * sizeof(SnapshotTopicRecord), header.discussionsOffset);
+    of.write(reinterpret_cast<const char*>(discussions.data()), discussions.size() * sizeof(SnapshotDiscussionRecord));
+    padTo(of, header.discussionsOffset + discussions.size() * sizeof(SnapshotDiscussionRecord), header.commentsOffset);
+    of.write(reinterpret_cast<const char*>(comments.data()), comments.size() * sizeof(SnapshotCommentRecord));
+    padTo(of, header.commentsOffset + comments.size() * sizeof(SnapshotCommentRecord), header.votersOffset);
+    of.write(voters.data(), voters.size());
+    padTo(of, header.votersOffset + voters.size(), header.stringsOffset);
+    if (compressed) {
+        of.write(reinterpret_cast<const char*>(stringBlocks.data()), stringBlocks.size() * sizeof(SnapshotStringBlock));
+        of.write(storedStrings.data(), storedStrings.size());
+    }
+    else {
+        of.write(strings.data(), strings.size());
+    }
+    padTo(of, header.stringsOffset + header.stringsStoredSize, header.titleIndexOffset);
+    of.write(titleIndex.data(), titleIndex.size());
+
+    of.close();
+    return !of.fail();
+}
+
+/**
+ * @brief Checks that a table lies inside the file.
+ * @param offset File offset of the table.
+ * @param count Number of entries.
+ * @param entrySize Size of one entry in bytes.
+ * @return True if the table is inside the file, otherwise false.
+ */
+bool SnapshotReader::isInsideFile(std::uint64_t offset, std::uint64_t count, std::uint64_t entrySize) const {
+    std::uint64_t fileSize = file.getSize();
+    if (offset > fileSize || offset % 8 != 0) {
+        return false;
+    }
+    return count <= (fileSize - offset) / entrySize;
+}
+
+/**
+ * @brief Validates the block table of a compressed string heap and decompresses all blocks.
+ *
+ * Every block except the last covers SNAPSHOT_STRING_BLOCK_SIZE bytes of the heap, so each one
+ * has a fixed place in the output and the blocks are decompressed in parallel.
+ *
+ * @return True if every block decoded, otherwise false.
+ */
+bool SnapshotReader::decompressStrings() {
+    auto start = std::chrono::steady_clock::now();
+    std::uint64_t tableSize = static_cast<std::uint64_t>(header.stringBlockCount) * sizeof(SnapshotStringBlock);
+    if (tableSize > header.stringsStoredSize) {
+        return false;
+    }
+    const char* section = file.getData() + header.stringsOffset;
+    const SnapshotStringBlock* table = reinterpret_cast<const SnapshotStringBlock*>(section);
+
+    std::uint64_t rawTotal = 0;
+    for (std::uint32_t i = 0; i < header.stringBlockCount; i++) {
+        const SnapshotStringBlock& block = table[i];
+        bool last = i + 1 == header.stringBlockCount;
+        if (block.rawSize > SNAPSHOT_STRING_BLOCK_SIZE || (!last && block.rawSize != SNAPSHOT_STRING_BLOCK_SIZE) ||
+            block.storedSize > block.rawSize || block.offset < tableSize || block.offset > header.stringsStoredSize ||
+            block.storedSize > header.stringsStoredSize - block.offset) {
+            return false;
+        }
+        rawTotal += block.rawSize;
+    }
+    if (rawTotal != header.stringsSize) {
+        return false;
+    }
+
+    decompressed.reset(new char[header.stringsSize]);
+    std::atomic<bool> valid(true);
+    forEachBlock(header.stringBlockCount, [&](std::size_t i) {
+        const SnapshotStringBlock& block = table[i];
+        char* dst = decompressed.get() + i * SNAPSHOT_STRING_BLOCK_SIZE;
+        if (block.storedSize == block.rawSize) {
+            std::memcpy(dst, section + block.offset, block.rawSize);
+        }
+        else if (!BlockCodec::decompress(section + block.offset, block.storedSize, dst, block.rawSize)) {
+            valid = false;
+        }
+    });
+    strings = decompressed.get();
+
+    stringStats.blockCount = header.stringBlockCount;
+    stringStats.seconds = secondsSince(start);
+    return valid;
+}
+
+/**
+ * @brief Default constructor.
+ */
+SnapshotReader::SnapshotReader() : header{}, strings(nullptr), stringStats{} {  }
+
+/**
+ * @brief Checks whether a file starts with the snapshot magic bytes.
+ * @param fileName File name.
+ * @return True if the file is a snapshot, otherwise false.
+ */
+bool SnapshotReader::isSnapshotFile(const std::string& fileName) {
+    std::ifstream iff(fileName, std::ios::binary);
+    char magic[sizeof(SNAPSHOT_MAGIC)] = { 0 };
+    iff.read(magic, sizeof(magic));
+    return iff.gcount() == sizeof(magic) && std::memcmp(magic, SNAPSHOT_MAGIC, sizeof(magic)) == 0;
+}
+
+/**
+ * @brief Maps a snapshot file and validates its header.
+ *
+ * Only the header is checked here, so opening costs the same no matter how big the snapshot is;
+ * a compressed string heap is the exception and is decompressed before this returns.
+ *
+ * @param fileName File name.
+ * @return True if the snapshot is usable, otherwise false.
+ */
+bool SnapshotReader::open(const std::string& fileName) {
+    close();
+    if (!file.open(fileName) || file.getSize() < SNAPSHOT_V2_HEADER_SIZE) {
+        close();
+        return false;
+    }
+
+    // the header is copied, so fields added by later versions read as zero in older files
+    std::memcpy(&header, file.getData(), SNAPSHOT_V2_HEADER_SIZE);
+    bool knownHeader = (header.version == SNAPSHOT_VERSION && header.headerSize == sizeof(SnapshotHeader)) ||
+        (header.version == 5 && header.headerSize == SNAPSHOT_V5_HEADER_SIZE) ||
+        (header.version == 4 && header.headerSize == SNAPSHOT_V4_HEADER_SIZE) ||
+        (header.version == 3 && header.headerSize == SNAPSHOT_V3_HEADER_SIZE) ||
+        (header.version == SNAPSHOT_MIN_VERSION && header.headerSize == SNAPSHOT_V2_HEADER_SIZE);
+    if (std::memcmp(header.magic, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) != 0 || !knownHeader || file.getSize() < header.headerSize) {
+        close();
+        return false;
+    }
+    std::memcpy(&header, file.getData(), header.headerSize);
+    if (header.version < 3) {
+        header.stringsStoredSize = header.stringsSize;
+    }
+    if (header.version < 4) {
+        if (!isInsideFile(header.votersOffset, header.voterCount, sizeof(std::uint32_t))) {
+            close();
+            return false;
+        }
+        header.votersSize = header.voterCount * sizeof(std::uint32_t);
+    }
+
+    if (!isInsideFile(header.usersOffset, header.userCount, sizeof(SnapshotUserRecord)) ||
+        !isInsideFile(header.topicsOffset, header.topicCount, sizeof(SnapshotTopicRecord)) ||
+        !isInsideFile(header.discussionsOffset, header.discussionCount, sizeof(SnapshotDiscussionRecord)) ||
+        !isInsideFile(header.commentsOffset, header.commentCount, sizeof(SnapshotCommentRecord)) ||
+        !isInsideFile(header.votersOffset, header.votersSize, 1) ||
+        (header.votersEncoding != SNAPSHOT_VOTERS_PLAIN && header.votersEncoding != SNAPSHOT_VOTERS_DELTA) ||
+        !isInsideFile(header.stringsOffset, header.stringsStoredSize, 1) ||
+        (header.titleIndexSize > 0 && !isInsideFile(header.titleIndexOffset, header.titleIndexSize, 1))) {
+        close();
+        return false;
+    }
+
+    stringStats.rawBytes = header.stringsSize;
+    stringStats.storedBytes = header.stringsStoredSize;
+    if (header.stringsEncoding == SNAPSHOT_STRINGS_PLAIN && header.stringsStoredSize == header.stringsSize) {
+        strings = file.getData() + header.stringsOffset;
+    }
+    else if (header.stringsEncoding != SNAPSHOT_STRINGS_BLOCKS || !decompressStrings()) {
+        close();
+        return false;
+    }
+    return true;
+}
+
+/**
+ * @brief Releases the mapping. Borrowed texts must not be used afterwards.
+ */
+void SnapshotReader::close() {
+    file.close();
+    header = SnapshotHeader{};
+    strings = nullptr;
+    decompressed.reset();
+    stringStats = SnapshotStringStats{};
+}
+
+/**
+ * @brief Checks whether a snapshot is open.
+ * @return True if a snapshot is open, otherwise false.
+ */
+bool SnapshotReader::isOpen() const {
+    return file.isOpen() && strings != nullptr;
+}
+
+/**
+ * @brief Returns the snapshot header.
+ * @return Reference to the header.
+ */
+const SnapshotHeader& SnapshotReader::getHeader() const {
+    return header;
+}
+
+/**
+ * @brief Returns the compression figures of the opened string heap.
+ * @return The figures.
+ */
+const SnapshotStringStats& SnapshotReader::getStringStats() const {
+    return stringStats;
+}
+
+/**
+ * @brief Returns the user table.
+ * @return Pointer to the first user record.
+ */
+const SnapshotUserRecord* SnapshotReader::getUsers() const {
+    return reinterpret_cast<const SnapshotUserRecord*>(file.getData() + header.usersOffset);
+}
+
+/**
+ * @brief Returns the topic table.
+ * @return Pointer to the first topic record.
+ */
+const SnapshotTopicRecord* SnapshotReader::getTopics() const {
+    return reinterpret_cast<const SnapshotTopicRecord*>(file.getData() + header.topicsOffset);
+}
+
+/**
+ * @brief Returns a block of discussion records.
+ * @param first Index of the first record.
+ * @param count Number of records.
+ * @return Pointer to the first record, or nullptr if the block is out of range.
+ */
+const SnapshotDiscussionRecord* SnapshotReader::getDiscussions(std::uint32_t first, std::uint32_t count) const {
+    if (static_cast<std::uint64_t>(first) + count > header.discussionCount) {
+        return nullptr;
+    }
+    return reinterpret_cast<const SnapshotDiscussionRecord*>(file.getData() + header.discussionsOffset) + first;
+}
+
+/**
+ * @brief Returns a block of comment records.
+ * @param first Index of the first record.
+ * @param count Number of records.
+ * @return Pointer to the first record, or nullptr if the block is out of range.
+ */
+const SnapshotCommentRecord* SnapshotReader::getComments(std::uint32_t first, std::uint32_t count) const {
+    if (static_cast<std::uint64_t>(first) + count > header.commentCount) {
+        return nullptr;
+    }
+    return reinterpret_cast<const SnapshotCommentRecord*>(file.getData() + header.commentsOffset) + first;
+}
+
+/**
+ * @brief Decodes a run of voter IDs.
+ *
+ * Delta coded runs carry no length, so a run is only checked against the end of the voter table.
+ *
+ * @param first Where the run starts, as stored in the comment record.
+ * @param count Number of voters.
+ * @param ids Receives the voter IDs.
+ * @return True if the run is inside the voter table and decodes, otherwise false.
+ */
+bool SnapshotReader::getVoters(std::uint64_t first, std::uint32_t count, std::uint32_t* ids) const {
+    const char* table = file.getData() + header.votersOffset;
+    if (header.votersEncoding == SNAPSHOT_VOTERS_PLAIN) {
+        if (first > header.voterCount || count > header.voterCount - first) {
+            return false;
+        }
+        std::memcpy(ids, table + first * sizeof(std::uint32_t), count * sizeof(std::uint32_t));
+        return true;
+    }
+    if (first > header.votersSize) {
+        return false;
+    }
+    return DeltaCodec::decode(table + first, header.votersSize - first, ids, count);
+}
+
+/**
+ * @brief Returns the title index.
+ * @return View of the index in the mapping, empty if the snapshot has none.
+ */
+std::string_view SnapshotReader::getTitleIndex() const {
+    if (header.titleIndexSize == 0) {
+        return std::string_view();
+    }
+    return std::string_view(file.getData() + header.titleIndexOffset, static_cast<std::size_t>(header.titleIndexSize));
+}
+
+/**
+ * @brief Returns a view of a string inside the string heap.
+ * @param ref Reference to the string.
+ * @param str Receives the view.
+ * @return True if the string is inside the heap, otherwise false.
+ */
+bool SnapshotReader::getString(const SnapshotStringRef& ref, std::string_view& str) const {
+    if (ref.offset > header.stringsSize || ref.size > header.stringsSize - ref.offset) {
+        return false;
+    }
+    str = std::string_view(strings + ref.offset, ref.size);
+    return true;
+}
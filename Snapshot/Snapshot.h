@@ -0,0 +1,449 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "MappedFile.h"
+
+/**
+ * @brief Magic bytes at the start of every snapshot file.
+ */
+constexpr char SNAPSHOT_MAGIC[8] = { 'S', 'N', 'E', 'T', 'S', 'N', 'A', 'P' };
+
+/**
+ * @brief Current version of the snapshot format.
+ */
+constexpr std::uint32_t SNAPSHOT_VERSION = 6;
+
+/**
+ * @brief Oldest snapshot format version that can still be loaded.
+ */
+constexpr std::uint32_t SNAPSHOT_MIN_VERSION = 2;
+
+/**
+ * @brief First snapshot format version whose stored user points are trusted on load.
+ *
+ * Older files may come from programs that added points up on every command, so their points are rebuilt.
+ */
+constexpr std::uint32_t SNAPSHOT_POINTS_VERSION = 6;
+
+/**
+ * @brief The string heap is stored as it is.
+ */
+constexpr std::uint32_t SNAPSHOT_STRINGS_PLAIN = 0;
+
+/**
+ * @brief The string heap is stored as independently compressed blocks, see BlockCodec.
+ */
+constexpr std::uint32_t SNAPSHOT_STRINGS_BLOCKS = 1;
+
+/**
+ * @brief Size of the string heap covered by one compressed block; only the last block is smaller.
+ */
+constexpr std::uint32_t SNAPSHOT_STRING_BLOCK_SIZE = 1u << 16;
+
+/**
+ * @brief The voter table is an array of 32-bit IDs; comments locate their run by index.
+ */
+constexpr std::uint32_t SNAPSHOT_VOTERS_PLAIN = 0;
+
+/**
+ * @brief The voter table holds delta and varint coded runs, see DeltaCodec; comments locate their run by byte offset.
+ */
+constexpr std::uint32_t SNAPSHOT_VOTERS_DELTA = 1;
+
+/**
+ * @brief Reference to a string inside the string heap of a snapshot.
+ */
+struct SnapshotStringRef {
+    std::uint64_t offset; /**< Offset from the start of the string heap. */
+    std::uint32_t size; /**< Number of characters. */
+    std::uint32_t reserved; /**< Padding, always zero. */
+};
+
+/**
+ * @brief Fixed-size header at the start of a snapshot file.
+ */
+struct SnapshotHeader {
+    char magic[8]; /**< Always SNAPSHOT_MAGIC. */
+    std::uint32_t version; /**< Format version. */
+    std::uint32_t headerSize; /**< Size of this header in bytes. */
+
+    std::uint32_t userCount; /**< Number of user records. */
+    std::uint32_t topicCount; /**< Number of topic records. */
+    std::uint32_t discussionCount; /**< Number of discussion records. */
+    std::uint32_t commentCount; /**< Number of comment records, replies included. */
+    std::uint64_t voterCount; /**< Number of entries in the voter table. */
+    std::uint64_t generation; /**< Checkpoint generation, matched against the journal of the file. */
+
+    std::uint64_t usersOffset; /**< File offset of the user table. */
+    std::uint64_t topicsOffset; /**< File offset of the topic table. */
+    std::uint64_t discussionsOffset; /**< File offset of the discussion table. */
+    std::uint64_t commentsOffset; /**< File offset of the comment table. */
+    std::uint64_t votersOffset; /**< File offset of the voter table. */
+    std::uint64_t stringsOffset; /**< File offset of the string heap. */
+    std::uint64_t stringsSize; /**< Size of the string heap in bytes. */
+
+    std::uint32_t stringsEncoding; /**< SNAPSHOT_STRINGS_PLAIN or SNAPSHOT_STRINGS_BLOCKS; added in version 3. */
+    std::uint32_t stringBlockCount; /**< Number of compressed blocks; added in version 3. */
+    std::uint64_t stringsStoredSize; /**< Bytes the string heap takes in the file; added in version 3. */
+
+    std::uint64_t votersSize; /**< Bytes the voter table takes in the file; added in version 4. */
+    std::uint32_t votersEncoding; /**< SNAPSHOT_VOTERS_PLAIN or SNAPSHOT_VOTERS_DELTA; added in version 4. */
+    std::uint32_t reserved; /**< Padding, always zero. */
+
+    std::uint64_t titleIndexOffset; /**< File offset of the title index, see TitleTrigramIndex; added in version 5. */
+    std::uint64_t titleIndexSize; /**< Size of the title index in bytes, zero if there is none; added in version 5. */
+};
+
+/**
+ * @brief Size of the header of version 2 snapshots, which ends with the string heap size.
+ */
+constexpr std::size_t SNAPSHOT_V2_HEADER_SIZE = offsetof(SnapshotHeader, stringsEncoding);
+
+/**
+ * @brief Size of the header of version 3 snapshots, which ends with the stored size of the string heap.
+ */
+constexpr std::size_t SNAPSHOT_V3_HEADER_SIZE = offsetof(SnapshotHeader, votersSize);
+
+/**
+ * @brief Size of the header of version 4 snapshots, which ends with the voter table encoding.
+ */
+constexpr std::size_t SNAPSHOT_V4_HEADER_SIZE = offsetof(SnapshotHeader, titleIndexOffset);
+
+/**
+ * @brief Size of the header of version 5 snapshots; version 6 only marks the user points as current.
+ */
+constexpr std::size_t SNAPSHOT_V5_HEADER_SIZE = sizeof(SnapshotHeader);
+
+/**
+ * @brief Entry of the block table in front of a compressed string heap.
+ */
+struct SnapshotStringBlock {
+    std::uint64_t offset; /**< Offset of the stored block from the start of the string section. */
+    std::uint32_t storedSize; /**< Bytes stored in the file; equal to rawSize when the block did not compress. */
+    std::uint32_t rawSize; /**< Bytes of the string heap in the block. */
+};
+
+/**
+ * @brief Compression figures of the string heap of the last written or opened snapshot.
+ */
+struct SnapshotStringStats {
+    std::uint64_t rawBytes; /**< Size of the string heap. */
+    std::uint64_t storedBytes; /**< Bytes the string heap takes in the file, block table included. */
+    std::uint32_t blockCount; /**< Number of compressed blocks, zero when stored plainly. */
+    double seconds; /**< Time spent compressing or decompressing. */
+};
+
+/**
+ * @brief Snapshot record of a user.
+ */
+struct SnapshotUserRecord {
+    SnapshotStringRef firstName; /**< User first name. */
+    SnapshotStringRef lastName; /**< User last name. */
+    SnapshotStringRef nickname; /**< User nickname. */
+    SnapshotStringRef password; /**< User password. */
+    std::uint32_t id; /**< User ID. */
+    std::int32_t points; /**< User points. */
+    std::int32_t role; /**< User permission role. */
+    std::uint32_t reserved; /**< Padding, always zero. */
+};
+
+/**
+ * @brief Snapshot record of a topic. Its discussions are stored next to each other in the discussion table.
+ */
+struct SnapshotTopicRecord {
+    SnapshotStringRef title; /**< Topic title. */
+    SnapshotStringRef description; /**< Topic description. */
+    std::uint32_t creatorId; /**< Topic creator ID. */
+    std::uint32_t id; /**< Unique topic identifier. */
+    std::uint32_t discussionID; /**< Unique identifier counter for discussions. */
+    std::uint32_t firstDiscussion; /**< Index of the first discussion in the discussion table. */
+    std::uint32_t discussionNum; /**< Number of discussions. */
+    std::uint32_t reserved; /**< Padding, always zero. */
+};
+
+/**
+ * @brief Snapshot record of a discussion. Its comments are stored next to each other in the comment table.
+ */
+struct SnapshotDiscussionRecord {
+    SnapshotStringRef title; /**< Discussion title. */
+    SnapshotStringRef contents; /**< Discussion content. */
+    std::uint32_t creatorId; /**< Discussion creator ID. */
+    std::uint32_t id; /**< Unique discussion ID. */
+    std::uint32_t commentID; /**< Unique identifier counter for comments. */
+    std::uint32_t firstComment; /**< Index of the first comment in the comment table. */
+    std::uint32_t commentNum; /**< Number of comments. */
+    std::uint32_t reserved; /**< Padding, always zero. */
+};
+
+/**
+ * @brief Snapshot record of a comment. Its replies are stored next to each other in the comment table.
+ */
+struct SnapshotCommentRecord {
+    SnapshotStringRef text; /**< Comment text. */
+    std::uint32_t authorId; /**< Comment author ID. */
+    std::uint32_t id; /**< Unique comment identifier. */
+    std::int32_t rating; /**< Comment rating. */
+    std::uint32_t votedUsersNum; /**< Number of users who voted. */
+    std::uint64_t firstVoter; /**< Where the voters start in the voter table: byte offset when delta coded, otherwise index. */
+    std::uint32_t firstReply; /**< Index of the first reply in the comment table. */
+    std::uint32_t replyNum; /**< Number of replies. */
+};
+
+/**
+ * @class SnapshotWriter
+ * @brief Collects records of the whole network and writes them as one snapshot file.
+ *
+ * Children are reserved as contiguous blocks before their parents are finished,
+ * so every record only needs the index and size of its children's block.
+ */
+class SnapshotWriter {
+private:
+    std::vector<SnapshotUserRecord> users; /**< User table. */
+    std::vector<SnapshotTopicRecord> topics; /**< Topic table. */
+    std::vector<SnapshotDiscussionRecord> discussions; /**< Discussion table. */
+    std::vector<SnapshotCommentRecord> comments; /**< Comment table. */
+    std::string voters; /**< Voter table, delta coded runs back to back. */
+    std::uint64_t voterCount; /**< Number of voter IDs in the voter table. */
+    std::string strings; /**< String heap. */
+    std::string titleIndex; /**< Title index, written after the string heap. */
+    std::uint64_t generation; /**< Checkpoint generation written to the header. */
+    int compressionLevel; /**< BlockCodec level for the string heap, 0 stores it plainly. */
+    SnapshotStringStats stringStats; /**< Figures of the last written string heap. */
+
+    /**
+     * @brief Compresses the string heap in blocks.
+     * @param table Receives the block table.
+     * @param data Receives the stored blocks, back to back.
+     */
+    void compressStrings(std::vector<SnapshotStringBlock>& table, std::string& data);
+
+public:
+    /**
+     * @brief Default constructor.
+     */
+    SnapshotWriter();
+
+    /**
+     * @brief Sets the checkpoint generation written to the header.
+     * @param generation The generation.
+     */
+    void setGeneration(std::uint64_t generation);
+
+    /**
+     * @brief Sets how strongly the string heap is compressed.
+     * @param level BlockCodec level from 1 to BlockCodec::MAX_LEVEL, or 0 to store it plainly.
+     */
+    void setCompressionLevel(int level);
+
+    /**
+     * @brief Returns the compression figures of the last written string heap.
+     * @return The figures.
+     */
+    const SnapshotStringStats& getStringStats() const;
+
+    /**
+     * @brief Appends a string to the string heap.
+     * @param str The string to append.
+     * @return Reference to the stored string.
+     */
+    SnapshotStringRef addString(std::string_view str);
+
+    /**
+     * @brief Appends a sorted run of voter IDs to the voter table.
+     * @param ids Voter IDs.
+     * @param count Number of voter IDs.
+     * @return Byte offset of the run in the voter table.
+     */
+    std::uint64_t addVoters(const unsigned int* ids, unsigned int count);
+
+    /**
+     * @brief Sets the title index written after the string heap.
+     * @param data The index as written by TitleTrigramIndex::write.
+     */
+    void setTitleIndex(std::string data);
+
+    /**
+     * @brief Appends a user record.
+     * @param record The user record.
+     */
+    void addUser(const SnapshotUserRecord& record);
+
+    /**
+     * @brief Reserves a contiguous block of topic records.
+     * @param count Number of records.
+     * @return Index of the first reserved record.
+     */
+    std::uint32_t reserveTopics(std::uint32_t count);
+
+    /**
+     * @brief Reserves a contiguous block of discussion records.
+     * @param count Number of records.
+     * @return Index of the first reserved record.
+     */
+    std::uint32_t reserveDiscussions(std::uint32_t count);
+
+    /**
+     * @brief Reserves a contiguous block of comment records.
+     * @param count Number of records.
+     * @return Index of the first reserved record.
+     */
+    std::uint32_t reserveComments(std::uint32_t count);
+
+    /**
+     * @brief Returns a previously reserved topic record.
+     * @param index Index of the record.
+     * @return Reference to the record.
+     */
+    SnapshotTopicRecord& topicAt(std::uint32_t index);
+
+    /**
+     * @brief Returns a previously reserved discussion record.
+     * @param index Index of the record.
+     * @return Reference to the record.
+     */
+    SnapshotDiscussionRecord& discussionAt(std::uint32_t index);
+
+    /**
+     * @brief Returns a previously reserved comment record.
+     * @param index Index of the record.
+     * @return Reference to the record.
+     */
+    SnapshotCommentRecord& commentAt(std::uint32_t index);
+
+    /**
+     * @brief Writes the collected records to a file.
+     * @param fileName File name.
+     * @return True if the whole snapshot was written, otherwise false.
+     */
+    bool writeToFile(const std::string& fileName);
+};
+
+/**
+ * @class SnapshotReader
+ * @brief Maps a snapshot file and gives direct access to its tables.
+ *
+ * Records and strings are read straight from the mapping; nothing is copied.
+ * A compressed string heap is the exception: it is decompressed once, when the file is opened.
+ * Every accessor checks its range against the file, so a damaged file is reported instead of read out of bounds.
+ */
+class SnapshotReader {
+private:
+    MappedFile file; /**< Mapping of the snapshot file. */
+    SnapshotHeader header; /**< Copy of the header, fields missing in older versions are zero. */
+    const char* strings; /**< Start of the string heap, in the mapping or in decompressed. */
+    std::unique_ptr<char[]> decompressed; /**< Decompressed string heap of a compressed snapshot. */
+    SnapshotStringStats stringStats; /**< Figures of the opened string heap. */
+
+    /**
+     * @brief Checks that a table lies inside the file.
+     * @param offset File offset of the table.
+     * @param count Number of entries.
+     * @param entrySize Size of one entry in bytes.
+     * @return True if the table is inside the file, otherwise false.
+     */
+    bool isInsideFile(std::uint64_t offset, std::uint64_t count, std::uint64_t entrySize) const;
+
+    /**
+     * @brief Validates the block table of a compressed string heap and decompresses all blocks.
+     * @return True if every block decoded, otherwise false.
+     */
+    bool decompressStrings();
+
+public:
+    /**
+     * @brief Default constructor.
+     */
+    SnapshotReader();
+
+    /**
+     * @brief Checks whether a file starts with the snapshot magic bytes.
+     * @param fileName File name.
+     * @return True if the file is a snapshot, otherwise false.
+     */
+    static bool isSnapshotFile(const std::string& fileName);
+
+    /**
+     * @brief Maps a snapshot file and validates its header.
+     * @param fileName File name.
+     * @return True if the snapshot is usable, otherwise false.
+     */
+    bool open(const std::string& fileName);
+
+    /**
+     * @brief Releases the mapping. Borrowed texts must not be used afterwards.
+     */
+    void close();
+
+    /**
+     * @brief Checks whether a snapshot is open.
+     * @return True if a snapshot is open, otherwise false.
+     */
+    bool isOpen() const;
+
+    /**
+     * @brief Returns the snapshot header.
+     * @return Reference to the header.
+     */
+    const SnapshotHeader& getHeader() const;
+
+    /**
+     * @brief Returns the compression figures of the opened string heap.
+     * @return The figures.
+     */
+    const SnapshotStringStats& getStringStats() const;
+
+    /**
+     * @brief Returns the user table.
+     * @return Pointer to the first user record.
+     */
+    const SnapshotUserRecord* getUsers() const;
+
+    /**
+     * @brief Returns the topic table.
+     * @return Pointer to the first topic record.
+     */
+    const SnapshotTopicRecord* getTopics() const;
+
+    /**
+     * @brief Returns a block of discussion records.
+     * @param first Index of the first record.
+     * @param count Number of records.
+     * @return Pointer to the first record, or nullptr if the block is out of range.
+     */
+    const SnapshotDiscussionRecord* getDiscussions(std::uint32_t first, std::uint32_t count) const;
+
+    /**
+     * @brief Returns a block of comment records.
+     * @param first Index of the first record.
+     * @param count Number of records.
+     * @return Pointer to the first record, or nullptr if the block is out of range.
+     */
+    const SnapshotCommentRecord* getComments(std::uint32_t first, std::uint32_t count) const;
+
+    /**
+     * @brief Decodes a run of voter IDs.
+     * @param first Where the run starts, as stored in the comment record.
+     * @param count Number of voters.
+     * @param ids Receives the voter IDs.
+     * @return True if the run is inside the voter table and decodes, otherwise false.
+     */
+    bool getVoters(std::uint64_t first, std::uint32_t count, std::uint32_t* ids) const;
+
+    /**
+     * @brief Returns the title index.
+     * @return View of the index in the mapping, empty if the snapshot has none.
+     */
+    std::string_view getTitleIndex() const;
+
+    /**
+     * @brief Returns a view of a string inside the string heap.
+     * @param ref Reference to the string.
+     * @param str Receives the view.
+     * @return True if the string is inside the heap, otherwise false.
+     */
+    bool getString(const SnapshotStringRef& ref, std::string_view& str) const;
+};
@@ -27,6 +27,74 @@ int main() {
 			std::getline(std::cin, fileName, '\n');
 			socialNetwork.saveAs(fileName);
 		}
+		else if (command == "checkpoint") {
+			socialNetwork.checkpoint();
+		}
+		else if (command == "load_mode") {
+			std::string mode;
+			std::cout << ">>Enter load mode (eager/lazy): ";
+			std::cin >> mode;
+			if (mode == "eager") {
+				socialNetwork.setLoadMode(false);
+			}
+			else if (mode == "lazy") {
+				socialNetwork.setLoadMode(true);
+			}
+			else {
+				std::cout << ">>No such load mode exists!";
+			}
+		}
+		else if (command == "checkpoint_mode") {
+			std::string mode;
+			std::cout << ">>Enter checkpoint mode (foreground/background): ";
+			std::cin >> mode;
+			if (mode == "foreground") {
+				socialNetwork.setCheckpointMode(false);
+			}
+			else if (mode == "background") {
+				socialNetwork.setCheckpointMode(true);
+			}
+			else {
+				std::cout << ">>No such checkpoint mode exists!";
+			}
+		}
+		else if (command == "durability") {
+			std::string mode;
+			std::cout << ">>Enter durability mode (manual/sync/group/buffered): ";
+			std::cin >> mode;
+			if (mode == "manual") {
+				socialNetwork.setDurability(Durability::MANUAL, 0, 0);
+			}
+			else if (mode == "sync") {
+				socialNetwork.setDurability(Durability::SYNC, 0, 0);
+			}
+			else if (mode == "group") {
+				unsigned int intervalMs, records;
+				std::cout << ">>Enter group interval in milliseconds: ";
+				std::cin >> intervalMs;
+				std::cout << ">>Enter group size in records: ";
+				std::cin >> records;
+				socialNetwork.setDurability(Durability::GROUP, intervalMs, records);
+			}
+			else if (mode == "buffered") {
+				socialNetwork.setDurability(Durability::BUFFERED, 0, 0);
+			}
+			else {
+				std::cout << ">>No such durability mode exists!";
+			}
+		}
+		else if (command == "journal_stats") {
+			socialNetwork.printJournalStats();
+		}
+		else if (command == "compression") {
+			int level;
+			std::cout << ">>Enter compression level (0 stores texts plainly, 1 fastest, 9 smallest): ";
+			std::cin >> level;
+			socialNetwork.setCompressionLevel(level);
+		}
+		else if (command == "compression_stats") {
+			socialNetwork.printCompressionStats();
+		}
 		else if (command == "load") {
 			std::string fileName;
 			std::cout << ">>Enter file name: ";
@@ -68,6 +136,22 @@ int main() {
 			std::getline(std::cin, topicSubStr);
 			socialNetwork.searchTopic(topicSubStr);
 		}
+		else if (command == "search_discussions") {
+			std::string discussionSubStr;
+			std::cout << ">>Enter part of the title: ";
+			std::cin.clear();
+			std::cin.ignore();
+			std::getline(std::cin, discussionSubStr);
+			socialNetwork.searchDiscussions(discussionSubStr);
+		}
+		else if (command == "search_posts") {
+			std::string query;
+			std::cout << ">>Enter key words: ";
+			std::cin.clear();
+			std::cin.ignore();
+			std::getline(std::cin, query);
+			socialNetwork.searchPosts(query);
+		}
 		else if (command == "open") {
 			std::string buff;
 			std::cout << ">>Open by id or by full title? (Id/title)" << std::endl;
@@ -149,13 +233,25 @@ int main() {
 		else if (command == "list_comments") {
 			socialNetwork.listComments();
 		}
+		else if (command == "scan_comments") {
+			std::string text;
+			std::cout << ">>Enter the text to look for: ";
+			std::cin.clear();
+			std::cin.ignore();
+			std::getline(std::cin, text);
+			socialNetwork.scanComments(text);
+		}
+		else if (command == "rebuild_points") {
+			socialNetwork.rebuildUserPoints();
+		}
 		else if (command == "logout") {
 			socialNetwork.logout();
 		}
 		else if (command == "help") {
-			std::cout << ">>All commands: save, save_as, load, signup, login, logout, edit, create, search, open, quit,\n" <<
-				"list, post, post_open, post_quit, add_comment, add_reply, comment_vote, list_comments, remove_topic,\n" <<
-				"remove_post, remove_comment, help, exit." << std::endl;
+			std::cout << ">>All commands: save, save_as, checkpoint, checkpoint_mode, durability, journal_stats,\n" <<
+				"compression, compression_stats, load, load_mode,\n" <<
+				"signup, login, logout, edit, create, search, search_discussions, search_posts, open, quit, list, post, post_open, post_quit,\n" <<
+				"add_comment, add_reply, comment_vote, list_comments, remove_topic, remove_post, remove_comment, scan_comments, rebuild_points, help, exit." << std::endl;
 		}
 		else if (command == "exit") {
 			char answer;
@@ -171,7 +267,6 @@ int main() {
 		else {
 			std::cout << ">>No such command exist! Use command \'help\' to see all commands.";
 		}
-		socialNetwork.calculateUserPoints();
 		std::cout << "\n>";
 	} while (command != "exit");
 	//thank you, come again
@@ -1,32 +1,175 @@
 ﻿#include "System.h"
+#include <cstdio>
+#include "BlockCodec.h"
+#include "SubstringSearch.h"
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
 
 /**
- * @brief Doubles the capacity of the user array and clones existing users to a new array.
+ * @brief Doubles the capacity of the user array and moves the existing user pointers to a new array.
  */
 void System::resizeUsers() {
 	capacityOfUsers *= 2;
-	User** newArr = new User * [capacityOfUsers];
+	User** newArr = new User * [capacityOfUsers] {nullptr};
 	for (size_t i = 0; i < numOfUsers; i++) {
-		newArr[i] = users[i]->clone();
-		delete users[i];
+		newArr[i] = users[i];
 	}
 	delete[] users;
 	users = newArr;
 }
 
 /**
- * @brief Doubles the capacity of the topic array and copies existing topics to a new array.
+ * @brief Doubles the capacity of the topic array and moves existing topics to a new array.
  */
 void System::resizeTopics() {
 	capacityOfTopics *= 2;
-	Topic* newArr = new Topic[capacityOfTopics];
+	std::shared_ptr<Topic>* newArr = new std::shared_ptr<Topic>[capacityOfTopics];
 	for (size_t i = 0; i < numOfTopics; i++) {
-		newArr[i] = topics[i];
+		newArr[i] = std::move(topics[i]);
 	}
 	delete[] topics;
 	topics = newArr;
 }
 
+/**
+ * @brief Rebuilds the nickname index from the user array.
+ *
+ * Slots without a user, as left by an unknown role in an old file, are skipped; of two users
+ * with the same nickname the first one keeps it, like the linear search used to.
+ */
+void System::indexNicknames() {
+	nicknames.clear();
+	nicknames.reserve(numOfUsers);
+	for (size_t i = 0; i < numOfUsers; i++) {
+		if (users[i] != nullptr) {
+			nicknames.insert(users[i]->getNickname(), static_cast<unsigned int>(i));
+		}
+	}
+}
+
+/**
+ * @brief Rebuilds the topic index and the topic search index from the topic array.
+ */
+void System::indexTopics() {
+	topicSlots.clear();
+	topicSlots.reserve(numOfTopics);
+	topicSearch.clear();
+	for (size_t i = 0; i < numOfTopics; i++) {
+		if (topics[i] != nullptr) {
+			topicSlots.insert(topics[i]->getTopicId(), static_cast<unsigned int>(i));
+			topicSearch.addTopic(topics[i]->getTopicId(), topics[i]->getTopicTitle(), topics[i]->getTopicDescription());
+		}
+	}
+}
+
+/**
+ * @brief Rebuilds the title index from all topics and discussions, loading lazily loaded topics.
+ *
+ * Snapshots carry the title index, so this only runs for files written without one.
+ */
+void System::indexTitles() {
+	titleSearch.clear();
+	for (unsigned int i = 0; i < numOfTopics; i++) {
+		if (topics[i] == nullptr) {
+			continue;
+		}
+		if (!topics[i]->isLoaded()) {
+			editTopic(i);
+		}
+		unsigned int topicId = topics[i]->getTopicId();
+		titleSearch.addTopic(topicId, topics[i]->getTopicTitle());
+		topics[i]->forEachDiscussion([this, topicId](const Discussion& discussion) {
+			titleSearch.addDiscussion(topicId, discussion.getDiscussionId(), discussion.getDiscussionTitle());
+		});
+	}
+}
+
+/**
+ * @brief Builds the post search index from all discussions and comments, loading lazily loaded topics.
+ *
+ * The index is built on the first post search rather than on every load, so sessions that
+ * never search do not pay for it; from then on every change is applied to it as well.
+ */
+void System::indexPosts() {
+	postSearch.clear();
+	for (unsigned int i = 0; i < numOfTopics; i++) {
+		if (topics[i] == nullptr) {
+			continue;
+		}
+		if (!topics[i]->isLoaded()) {
+			editTopic(i);
+		}
+		unsigned int topicId = topics[i]->getTopicId();
+		topics[i]->forEachDiscussion([this, topicId](const Discussion& discussion) {
+			unsigned int discussionId = discussion.getDiscussionId();
+			postSearch.addDiscussion(topicId, discussionId, discussion.getDiscussionTitle(), discussion.getDiscussionContents());
+			discussion.forEachComment([this, topicId, discussionId](const Comment& comment) {
+				postSearch.addComment(topicId, discussionId, comment.getCommentId(), comment.getCommentText());
+			});
+		});
+	}
+	postSearchReady = true;
+}
+
+/**
+ * @brief Moves the remaining topics over the empty slots of removed ones.
+ *
+ * Topics keep their order and IDs; the index entries of the moved ones are updated.
+ */
+void System::compactTopics() {
+	unsigned int kept = 0;
+	for (unsigned int i = 0; i < numOfTopics; i++) {
+		if (topics[i] == nullptr) {
+			continue;
+		}
+		if (kept != i) {
+			topics[kept] = std::move(topics[i]);
+			topicSlots.update(topics[kept]->getTopicId(), kept);
+		}
+		kept++;
+	}
+	numOfTopics = kept;
+	removedTopicNum = 0;
+}
+
+/**
+ * @brief Looks up a topic by ID.
+ * @param topicId Topic ID.
+ * @return Index of the topic in the topic array, or -1 if there is no such topic.
+ */
+int System::findTopic(unsigned int topicId) const {
+	return topicSlots.find(topicId);
+}
+
+/**
+ * @brief Adds points to a user, as a comment of the user gains or loses rating.
+ *
+ * Points are kept up to date this way on every vote and removal, so no command has to
+ * recalculate them.
+ *
+ * @param userId User ID.
+ * @param delta Change of the points.
+ */
+void System::addPoints(unsigned int userId, int delta) {
+	if (userId < numOfUsers && users[userId] != nullptr) {
+		users[userId]->changePoints(delta);
+	}
+}
+
+/**
+ * @brief Returns the currently open discussion.
+ *
+ * A topic and a discussion must be open; removing either of them closes it.
+ *
+ * @return Reference to the discussion.
+ */
+Discussion& System::openedDiscussion() const {
+	const Topic& topic = *topics[findTopic(currTopicId)];
+	return topic.getTopicDiscussions()[topic.findDiscussion(currDiscussionId)];
+}
+
 /**
  * @brief Frees memory for all users and topics on the system.
  */
@@ -37,24 +180,53 @@ void System::free() {
 	}
 	delete[] users;
 	users = nullptr;
+	nicknames.clear();
 
 	delete[] topics;
 	topics = nullptr;
+	removedTopicNum = 0;
+	topicSlots.clear();
+	topicSearch.clear();
+	titleSearch.clear();
+	postSearch.clear();
+	postSearchReady = false;
+}
+
+/**
+ * @brief Returns a loaded topic for changing, copying it first if a background snapshot still shares it.
+ *
+ * Only the first change of a topic during a background snapshot pays for the copy;
+ * the snapshot keeps writing the old version. A lazily loaded topic is loaded here.
+ *
+ * @param index Index of the topic.
+ * @return Reference to the topic.
+ */
+Topic& System::editTopic(unsigned int index) {
+	if (topics[index].use_count() > 1) {
+		topics[index] = std::make_shared<Topic>(*topics[index]);
+	}
+	if (!topics[index]->loadDiscussions()) {
+		std::cout << ">Topic data is corrupted!" << std::endl;
+	}
+	return *topics[index];
 }
 
 /**
  * @brief Default constructor that initializes the system with initial values.
  */
-System::System() : capacityOfUsers(2), numOfUsers(0), capacityOfTopics(2), numOfTopics(0), currUserId(-1),
-currUserPermission(Permission::NaN), currTopicId(-1), currDiscussionId(-1) {
+System::System() : capacityOfUsers(2), numOfUsers(0), capacityOfTopics(2), numOfTopics(0), removedTopicNum(0), postSearchReady(false), currUserId(-1),
+currUserPermission(Permission::NaN), currTopicId(-1), currDiscussionId(-1), snapshotGeneration(0),
+lazyLoading(false), backgroundCheckpoints(false), checkpointDone(false), checkpointSucceeded(false), checkpointGeneration(0),
+checkpointStringStats{}, compressionLevel(0), savedStringStats{}, loadedStringStats{} {
 	users = new User * [capacityOfUsers] {nullptr};
-	topics = new Topic[capacityOfTopics];
+	topics = new std::shared_ptr<Topic>[capacityOfTopics];
 }
 
 /**
  * @brief Destructor that releases all system resources.
  */
 System::~System() {
+	finishBackgroundCheckpoint(true);
 	free();
 }
 
@@ -72,38 +244,21 @@ void System::signup() {
 
 	std::cout << "\n>Enter Nickname: ";
 	std::cin >> nickname;
-	bool flag = false;
-	do {
-		for (size_t i = 0; i < numOfUsers; i++) {
-			if (users[i]->getNickname() == nickname) {
-				flag = true;
-				std::cout << "\n>A user with this nickname already exists!";
-				break;
-			}
-		}
-		if (flag) {
-			std::cout << ">Enter a new nickname: ";
-			std::cin >> nickname;
-		}
-	} while (flag);
+	while (std::cin && nicknames.find(nickname) >= 0) {
+		std::cout << "\n>A user with this nickname already exists!";
+		std::cout << ">Enter a new nickname: ";
+		std::cin >> nickname;
+	}
 
 	std::cout << "\n>Enter password: ";
 	std::cin >> password;
 
-	if (numOfUsers == 0) {
-		Moderator firstNewUser(firstName, lastName, nickname, password);
-		users[numOfUsers] = firstNewUser.clone();
-		numOfUsers++;
-	}
-	else {
-		User newUser(firstName, lastName, nickname, password);
-		users[numOfUsers] = newUser.clone();
-		numOfUsers++;
-	}
-
-	if (numOfUsers >= capacityOfUsers) {
-		resizeUsers();
-	}
+	JournalRecord record(JournalOp::SIGNUP);
+	record.putString(firstName);
+	record.putString(lastName);
+	record.putString(nickname);
+	record.putString(password);
+	commit(record);
 }
 
 /**
@@ -112,28 +267,17 @@ void System::signup() {
  * @param password Password.
  */
 void System::login(const std::string& nickname, const std::string& password) {
-	bool nicknameFlag = 0, passwordFlag = 0;
-	for (size_t i = 0; i < numOfUsers; i++) {
-		nicknameFlag = passwordFlag = false;
-		if (users[i]->getNickname() == nickname) {
-			nicknameFlag = true;
-			if (users[i]->getPassword() == password) {
-				passwordFlag = true;
-				currUserId = i;
-				currUserPermission = users[i]->getPermissionRole();
-			}
-			break;
-		}
-	}
-
-	if (!nicknameFlag) {
+	int slot = nicknames.find(nickname);
+	if (slot < 0) {
 		std::cout << ">User with this nickname does not exist!";
 		return;
 	}
-	if (!passwordFlag) {
+	if (users[slot]->getPassword() != password) {
 		std::cout << ">User's password is incorrect!";
 		return;
 	}
+	currUserId = slot;
+	currUserPermission = users[slot]->getPermissionRole();
 
 	std::cout << ">Welcome, " << users[currUserId]->getFirstName();
 }
@@ -149,19 +293,31 @@ void System::editUser() {
 		if (buff == "firstName") {
 			std::cout << ">Enter new first name: ";
 			std::cin >> buff;
-			users[currUserId]->setFirstName(buff);
+			JournalRecord record(JournalOp::EDIT_USER);
+			record.putUInt(currUserId);
+			record.putUInt(static_cast<std::uint32_t>(UserField::FIRST_NAME));
+			record.putString(buff);
+			commit(record);
 			continue;
 		}
 		else if (buff == "lastName") {
 			std::cout << ">Enter new last name: ";
 			std::cin >> buff;
-			users[currUserId]->setLastName(buff);
+			JournalRecord record(JournalOp::EDIT_USER);
+			record.putUInt(currUserId);
+			record.putUInt(static_cast<std::uint32_t>(UserField::LAST_NAME));
+			record.putString(buff);
+			commit(record);
 			continue;
 		}
 		else if (buff == "password") {
 			std::cout << ">Enter new password: ";
 			std::cin >> buff;
-			users[currUserId]->setPassword(buff);
+			JournalRecord record(JournalOp::EDIT_USER);
+			record.putUInt(currUserId);
+			record.putUInt(static_cast<std::uint32_t>(UserField::PASSWORD));
+			record.putString(buff);
+			commit(record);
 			continue;
 		}
 		else if (buff == "id") {
@@ -177,11 +333,17 @@ void System::editUser() {
 				std::cout << ">Enter new role of selected user: ";
 				std::cin >> buff;
 				if (buff == "user" || buff == "User" || buff == "USER") {
-					users[id]->setPermissionRole(Permission::USER);
+					JournalRecord record(JournalOp::SET_ROLE);
+					record.putUInt(id);
+					record.putInt(static_cast<std::int32_t>(Permission::USER));
+					commit(record);
 					continue;
 				}
 				else if (buff == "mod" || buff == "Mod" || buff == "MOD" || buff == "moderator" || buff == "Moderator" || buff == "MODERATOR") {
-					users[id]->setPermissionRole(Permission::MOD);
+					JournalRecord record(JournalOp::SET_ROLE);
+					record.putUInt(id);
+					record.putInt(static_cast<std::int32_t>(Permission::MOD));
+					commit(record);
 					continue;
 				}
 				else {
@@ -211,6 +373,10 @@ void System::logout() {
 
 /**
  * @brief Loads social network data from a file.
+ *
+ * Snapshot files are recognised by their magic bytes; any other file is read in the old format.
+ * User points stored in current snapshots are kept as they are; points of older files are rebuilt.
+ *
  * @param fileName File name.
  */
 void System::load(const std::string& fileName) {
@@ -220,64 +386,234 @@ void System::load(const std::string& fileName) {
 		readFile.close();
 		return;
 	}
+	readFile.close();
+
+	// the background snapshot may still read texts from the current mapping
+	finishBackgroundCheckpoint(true);
+	if (SnapshotReader::isSnapshotFile(fileName)) {
+		loadSnapshot(fileName);
+	}
+	else {
+		loadLegacy(fileName);
+	}
+	// points of older files may predate incremental points, which used to add up on every command
+	if (!snapshot.isOpen() || snapshot.getHeader().version < SNAPSHOT_POINTS_VERSION) {
+		calculateUserPoints();
+	}
+}
+
+/**
+ * @brief Returns how many extra threads are worth starting to read topics.
+ *
+ * One thread per core, but no more than one per TOPICS_PER_LOAD_THREAD topics,
+ * so small networks are read without starting any thread.
+ *
+ * @param topicCount Number of topics to read.
+ * @return Number of threads besides the loading one.
+ */
+static unsigned int loadWorkerCount(unsigned int topicCount) {
+	const unsigned int TOPICS_PER_LOAD_THREAD = 16;
+	unsigned int threads = std::thread::hardware_concurrency();
+	if (threads > topicCount / TOPICS_PER_LOAD_THREAD) {
+		threads = topicCount / TOPICS_PER_LOAD_THREAD;
+	}
+	return threads > 1 ? threads - 1 : 0;
+}
+
+/**
+ * @brief Loads the network from a memory-mapped snapshot file.
+ *
+ * Records are read straight from the mapping and texts of topics, discussions and comments
+ * keep pointing into it, so no text is copied. The mapping stays open until the next load.
+ * Every topic record locates its own discussions, comments and voters, so topics are read
+ * in parallel on all cores.
+ *
+ * @param fileName File name.
+ */
+void System::loadSnapshot(const std::string& fileName) {
+	SnapshotReader reader;
+	if (!reader.open(fileName)) {
+		std::cout << ">File is corrupted!" << std::endl;
+		return;
+	}
+
+	// the old network may still borrow texts from the old mapping, so it is freed first
+	free();
+	journal.detach();
+	journal.clearPending();
+	snapshot = std::move(reader);
+	const SnapshotHeader& header = snapshot.getHeader();
+
+	numOfUsers = header.userCount;
+	capacityOfUsers = numOfUsers < 2 ? 2 : numOfUsers + 1;
+	users = new User * [capacityOfUsers] {nullptr};
+
+	numOfTopics = header.topicCount;
+	capacityOfTopics = numOfTopics < 2 ? 2 : numOfTopics + 1;
+	topics = new std::shared_ptr<Topic>[capacityOfTopics];
+
+	// topics are independent blocks of the snapshot, so worker threads read them
+	// while this thread reads the users, then it helps with the remaining topics
+	std::atomic<bool> valid(true);
+	std::atomic<unsigned int> nextTopic(0);
+	const SnapshotTopicRecord* topicRecords = snapshot.getTopics();
+	auto readTopics = [&]() {
+		for (unsigned int i = nextTopic++; i < numOfTopics && valid; i = nextTopic++) {
+			topics[i] = std::make_shared<Topic>();
+			if (!topics[i]->readFromSnapshot(snapshot, topicRecords[i], lazyLoading)) {
+				valid = false;
+			}
+		}
+	};
+	std::vector<std::thread> workers;
+	unsigned int workerCount = lazyLoading ? 0 : loadWorkerCount(numOfTopics);
+	for (unsigned int i = 0; i < workerCount; i++) {
+		workers.emplace_back(readTopics);
+	}
+
+	const SnapshotUserRecord* userRecords = snapshot.getUsers();
+	for (size_t i = 0; i < numOfUsers && valid; i++) {
+		if (static_cast<Permission>(userRecords[i].role) == Permission::MOD) {
+			users[i] = new Moderator();
+		}
+		else {
+			users[i] = new User();
+		}
+		if (!users[i]->readFromSnapshot(snapshot, userRecords[i])) {
+			valid = false;
+		}
+	}
+
+	readTopics();
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	if (!valid) {
+		free();
+		snapshot.close();
+		capacityOfUsers = capacityOfTopics = 2;
+		numOfUsers = numOfTopics = 0;
+		users = new User * [capacityOfUsers] {nullptr};
+		topics = new std::shared_ptr<Topic>[capacityOfTopics];
+		std::cout << ">File is corrupted!" << std::endl;
+		return;
+	}
+	if (numOfTopics > 0) {
+		Topic::setNextTopicId(topics[numOfTopics - 1]->getTopicId() + 1);
+	}
+	indexNicknames();
+	indexTopics();
+	// the stored title index must describe exactly the stored topics and discussions
+	if (!titleSearch.read(snapshot.getTitleIndex()) || titleSearch.size() != numOfTopics + static_cast<std::size_t>(header.discussionCount)) {
+		indexTitles();
+	}
+
+	std::cout << ">Load successful!" << std::endl;
+	currFileOpened = fileName;
+	snapshotGeneration = header.generation;
+	loadedStringStats = snapshot.getStringStats();
+	replayJournal(fileName);
+}
+
+/**
+ * @brief Loads the network from a file in the old field-by-field format.
+ * @param fileName File name.
+ */
+void System::loadLegacy(const std::string& fileName) {
+	std::ifstream readFile(fileName, std::ios::binary);
+	BinaryReader reader(readFile);
 
 	// if the file exists...
 	free();
+	snapshot.close();
+	journal.detach();
+	journal.clearPending();
+	snapshotGeneration = 0;
 
-	readFile.read(reinterpret_cast<char*>(&numOfUsers), sizeof(numOfUsers));
-	readFile.read(reinterpret_cast<char*>(&capacityOfUsers), sizeof(capacityOfUsers));
+	reader.read(numOfUsers);
+	reader.read(capacityOfUsers);
 
 	users = new User * [capacityOfUsers] {nullptr};
 
 	Permission userPerm = Permission::NaN;
 	for (size_t i = 0; i < numOfUsers; i++) {
-		readFile.read(reinterpret_cast<char*>(&userPerm), sizeof(Permission));
+		reader.read(userPerm);
 		if (userPerm == Permission::USER) {
-			User* userToRead = new User();
-			userToRead->readFromFile(readFile);
-
-			users[i] = userToRead->clone();
-			delete userToRead;
-			continue;
+			users[i] = new User();
 		}
-		if (userPerm == Permission::MOD) {
-			Moderator* modToRead = new Moderator();
-			modToRead->readFromFile(readFile);
-
-			users[i] = modToRead->clone();
-			delete modToRead;
+		else if (userPerm == Permission::MOD) {
+			users[i] = new Moderator();
+		}
+		else {
+			continue;
 		}
+		users[i]->readFromFile(reader);
 	}
 
-	readFile.read(reinterpret_cast<char*>(&numOfTopics), sizeof(numOfTopics));
-	readFile.read(reinterpret_cast<char*>(&capacityOfTopics), sizeof(capacityOfTopics));
+	reader.read(numOfTopics);
+	reader.read(capacityOfTopics);
 
-	topics = new Topic[capacityOfTopics];
+	topics = new std::shared_ptr<Topic>[capacityOfTopics];
 
 	for (size_t i = 0; i < numOfTopics; i++) {
-		topics[i].readFromFile(readFile);
-
-		for (size_t j = 0; j < topics[i].getDiscussionNum(); j++) {
-			topics[i].getTopicDiscussions()[j].readFromFile(readFile);
-
-			for (size_t k = 0; k < topics[i].getTopicDiscussions()[j].getCommentNum(); k++) {
-				topics[i].getTopicDiscussions()[j].getDiscussionComments()[k].readFromFile(readFile);
-			}
-		}
+		topics[i] = std::make_shared<Topic>();
+		topics[i]->readFromFile(reader);
 	}
+	indexNicknames();
+	indexTopics();
+	indexTitles();
 
 	std::cout << ">Load successful!" << std::endl;
 	currFileOpened = fileName;
 	readFile.close();
 }
 
+/**
+ * @brief Replays the journal of a freshly loaded snapshot.
+ *
+ * A journal that ends in a damaged record is folded into a new snapshot right away,
+ * so new records are never appended behind the damage.
+ *
+ * @param fileName Snapshot file name.
+ */
+void System::replayJournal(const std::string& fileName) {
+	std::string journalName = Journal::journalFileName(fileName);
+	std::vector<JournalRecord> records;
+	JournalState state = Journal::readRecords(journalName, snapshotGeneration, records);
+
+	unsigned int applied = 0;
+	for (const JournalRecord& record : records) {
+		if (applyRecord(record)) {
+			applied++;
+		}
+	}
+	if (!records.empty()) {
+		std::cout << ">Replayed " << applied << " journaled changes." << std::endl;
+	}
+
+	if (state == JournalState::DAMAGED) {
+		std::cout << ">The journal ends in a damaged record, writing a new snapshot." << std::endl;
+		writeCheckpoint(fileName);
+		return;
+	}
+	if (state == JournalState::INTACT) {
+		journal.attach(journalName);
+		return;
+	}
+	journal.reset(journalName, snapshotGeneration);
+}
+
 /**
  * @brief Saves the current state of the social network to a file.
  *
  * If the file does not exist, it asks the user whether to create it.
  * If a file is not created, the current progress is not saved.
+ * Changes made since the last checkpoint are appended to the journal of the file;
+ * a full snapshot is only written when the file has no journal yet or the journal
+ * could not be written.
  */
-void System::save() const {
+void System::save() {
 	std::ifstream tryToOpen(currFileOpened, std::ios::binary);
 	if (!tryToOpen.is_open()) {
 		char answer;
@@ -297,73 +633,325 @@ void System::save() const {
 	tryToOpen.close();
 
 	// if the file exists...
-	std::ofstream writeFile(currFileOpened, std::ios::binary);
+	finishBackgroundCheckpoint(false);
+	bool saved = journal.isAttached() && journal.flush();
+	if (!saved) {
+		saved = writeCheckpoint(currFileOpened);
+	}
+	if (!saved) {
+		std::cout << ">Current progress was not saved!" << std::endl;
+		return;
+	}
+	std::cout << ">Current progress was saved!" << std::endl;
+}
 
-	writeFile.write(reinterpret_cast<const char*>(&numOfUsers), sizeof(numOfUsers));
-	writeFile.write(reinterpret_cast<const char*>(&capacityOfUsers), sizeof(capacityOfUsers));
-	// there is a resize() function, but why use it when you can directly set the capacity
+/**
+ * @brief Saves the current state of the social network to a specified file.
+ *
+ * The file becomes the opened file, later saves append to its journal.
+ *
+ * @param fileName File name.
+ */
+void System::saveAs(const std::string& fileName) {
+	if (!writeCheckpoint(fileName)) {
+		std::cout << ">Current progress was not saved!" << std::endl;
+		return;
+	}
+	currFileOpened = fileName;
+	std::cout << ">Current progress was saved!" << std::endl;
+}
 
-	for (size_t i = 0; i < numOfUsers; i++) {
-		//writeFile.write(reinterpret_cast<const char*>(users[i]->getPermissionRole()), sizeof(Permission));
-		users[i]->writeToFile(writeFile);
+/**
+ * @brief Folds the journal of the opened file into a new snapshot.
+ */
+void System::checkpoint() {
+	if (currFileOpened.empty()) {
+		std::cout << ">No file is opened! Use save_as first." << std::endl;
+		return;
 	}
+	finishBackgroundCheckpoint(true);
+	if (backgroundCheckpoints && journal.isAttached()) {
+		if (!startBackgroundCheckpoint(currFileOpened)) {
+			std::cout << ">Checkpoint failed!" << std::endl;
+			return;
+		}
+		std::cout << ">Writing checkpoint in the background." << std::endl;
+		return;
+	}
+	if (!writeCheckpoint(currFileOpened)) {
+		std::cout << ">Checkpoint failed!" << std::endl;
+		return;
+	}
+	std::cout << ">Checkpoint written!" << std::endl;
+}
 
-	// begins saving data from topics
-	writeFile.write(reinterpret_cast<const char*>(&numOfTopics), sizeof(numOfTopics));
-	writeFile.write(reinterpret_cast<const char*>(&capacityOfTopics), sizeof(capacityOfTopics));
+/**
+ * @brief Chooses whether snapshots are loaded lazily.
+ *
+ * In lazy mode a load reads only users and topic headers; the discussions and comments
+ * of a topic are read from the mapping when the topic is first opened or changed.
+ * Files in the old format are always loaded whole.
+ *
+ * @param lazy True to load topics on first use.
+ */
+void System::setLoadMode(bool lazy) {
+	lazyLoading = lazy;
+}
 
-	for (size_t i = 0; i < numOfTopics; i++) {
-		topics[i].writeToFile(writeFile);
+/**
+ * @brief Chooses whether checkpoints are written in the background.
+ *
+ * A background checkpoint only blocks commands while users are copied and topics are shared
+ * with the snapshot; a file without a journal is still checkpointed in the foreground.
+ *
+ * @param background True to write checkpoints on a background thread.
+ */
+void System::setCheckpointMode(bool background) {
+	backgroundCheckpoints = background;
+}
+
+/**
+ * @brief Changes when journaled changes are written and synced.
+ *
+ * In every mode except manual, changes become durable without a save command.
+ *
+ * @param mode Durability mode.
+ * @param intervalMs Longest wait of a change in group mode, in milliseconds.
+ * @param records Number of changes that triggers a group commit.
+ */
+void System::setDurability(Durability mode, unsigned int intervalMs, unsigned int records) {
+	if (mode != Durability::MANUAL && !journal.isAttached()) {
+		std::cout << ">No file is opened, changes are kept until save_as." << std::endl;
+	}
+	journal.setDurability(mode, std::chrono::milliseconds(intervalMs), records);
+}
+
+/**
+ * @brief Displays the durability mode and journal latency histograms.
+ */
+void System::printJournalStats() {
+	journal.printStats(std::cout);
+}
+
+/**
+ * @brief Sets how strongly texts are compressed in written snapshots.
+ *
+ * Texts are compressed in independent blocks that are decompressed in parallel on load.
+ * Higher levels search longer for repeated text: smaller files, slower saves, same load speed.
+ *
+ * @param level Level from 1 (fastest) to 9 (smallest), or 0 to store texts plainly.
+ */
+void System::setCompressionLevel(int level) {
+	if (level < 0 || level > BlockCodec::MAX_LEVEL) {
+		std::cout << ">Compression level must be between 0 and " << BlockCodec::MAX_LEVEL << "!" << std::endl;
+		return;
+	}
+	compressionLevel = level;
+}
+
+/**
+ * @brief Prints the figures of one string heap.
+ * @param label What the figures belong to.
+ * @param stats The figures.
+ */
+static void printStringStats(const char* label, const SnapshotStringStats& stats) {
+	std::cout << ">" << label << ": ";
+	if (stats.rawBytes == 0) {
+		std::cout << "no texts" << std::endl;
+		return;
+	}
+	std::cout << stats.rawBytes << " bytes of text stored in " << stats.storedBytes << " bytes";
+	if (stats.blockCount == 0) {
+		std::cout << ", uncompressed" << std::endl;
+		return;
+	}
+	std::cout << ", ratio " << static_cast<double>(stats.rawBytes) / stats.storedBytes << ", " << stats.blockCount << " blocks";
+	if (stats.seconds > 0) {
+		std::cout << ", " << stats.rawBytes / stats.seconds / (1024 * 1024) << " MiB/s";
+	}
+	std::cout << std::endl;
+}
+
+/**
+ * @brief Displays the compression ratio and throughput of the last written and loaded snapshots.
+ */
+void System::printCompressionStats() {
+	std::cout << ">Compression level: " << compressionLevel << std::endl;
+	printStringStats("Last save", savedStringStats);
+	printStringStats("Last load", loadedStringStats);
+}
+
+/**
+ * @brief Writes a new snapshot and starts an empty journal for it.
+ *
+ * The snapshot carries the next generation; a journal left over from an older generation
+ * is ignored on load, so a crash between the two steps never replays changes twice.
+ *
+ * @param fileName File name.
+ * @return True if the checkpoint was written, otherwise false.
+ */
+bool System::writeCheckpoint(const std::string& fileName) {
+	finishBackgroundCheckpoint(true);
+	std::uint64_t generation = snapshotGeneration + 1;
+	if (!writeSnapshot(fileName, generation)) {
+		return false;
+	}
+	snapshotGeneration = generation;
+	journal.clearPending();
+	if (!journal.reset(Journal::journalFileName(fileName), generation)) {
+		std::cout << ">Journal could not be created, the next save writes a full snapshot." << std::endl;
+	}
+	return true;
+}
+
+/**
+ * @brief Writes captured users and topics as a snapshot file.
+ *
+ * The snapshot is written next to the target and renamed over it, so the loaded mapping
+ * is never overwritten while texts still point into it. The file is synced before the rename
+ * and its directory after it, so the journal is only reset or moved once the snapshot is on
+ * stable storage; otherwise a power loss could keep the new empty journal but lose the
+ * snapshot it belongs to. If a topic cannot be written,
+ * nothing is written and the target is left as it was. Only the captured view is read,
+ * so this may run on a background thread.
+ *
+ * @param writer Snapshot writer holding the users.
+ * @param view Topics of the snapshot.
+ * @param fileName File name.
+ * @return True if the snapshot was written, otherwise false.
+ */
+static bool writeSnapshotFile(SnapshotWriter& writer, const std::vector<std::shared_ptr<const Topic>>& view, const std::string& fileName) {
+	std::uint32_t firstTopic = writer.reserveTopics(static_cast<std::uint32_t>(view.size()));
+	for (size_t i = 0; i < view.size(); i++) {
+		if (!view[i]->writeToSnapshot(writer, firstTopic + static_cast<std::uint32_t>(i))) {
+			return false;
+		}
+	}
 
-		for (size_t j = 0; j < topics[i].getDiscussionNum(); j++) {
-			topics[i].getTopicDiscussions()[j].writeToFile(writeFile);
+	std::string tempName = fileName + ".tmp";
+	AppendFile temp;
+	if (!writer.writeToFile(tempName) || !temp.open(tempName, false) || !temp.sync()) {
+		temp.close();
+		std::remove(tempName.c_str());
+		return false;
+	}
+	temp.close();
+#ifdef _WIN32
+	std::remove(fileName.c_str());
+#endif
+	return std::rename(tempName.c_str(), fileName.c_str()) == 0 && AppendFile::syncDirectoryOf(fileName);
+}
 
-			for (size_t k = 0; k < topics[i].getTopicDiscussions()[j].getCommentNum(); k++) {
-				topics[i].getTopicDiscussions()[j].getDiscussionComments()[k].writeToFile(writeFile);
+/**
+ * @brief Writes the whole network as a snapshot file.
+ * @param fileName File name.
+ * @param generation Checkpoint generation stored in the snapshot.
+ * @return True if the snapshot was written, otherwise false.
+ */
+bool System::writeSnapshot(const std::string& fileName, std::uint64_t generation) {
+	SnapshotWriter writer;
+	std::vector<std::shared_ptr<const Topic>> view;
+	captureSnapshot(writer, view, generation);
+	bool written = writeSnapshotFile(writer, view, fileName);
+	savedStringStats = writer.getStringStats();
+	return written;
+}
+
+/**
+ * @brief Captures a point-in-time view of the network for a snapshot.
+ *
+ * Users are small and copied into the writer right away. Topics are not copied at all:
+ * the view shares them, and a topic changed later is copied by editTopic instead.
+ *
+ * @param writer Receives the users.
+ * @param view Receives the topics, shared with the network.
+ * @param generation Checkpoint generation stored in the snapshot.
+ */
+void System::captureSnapshot(SnapshotWriter& writer, std::vector<std::shared_ptr<const Topic>>& view, std::uint64_t generation) {
+#ifdef _WIN32
+	// Windows cannot replace a mapped file, so the texts are copied out of the mapping first
+	if (snapshot.isOpen()) {
+		for (size_t i = 0; i < numOfTopics; i++) {
+			if (topics[i] != nullptr) {
+				topics[i]->detachText();
 			}
 		}
+		snapshot.close();
+	}
+#endif
+	writer.setGeneration(generation);
+	writer.setCompressionLevel(compressionLevel);
+	std::string titleIndex;
+	titleSearch.write(titleIndex);
+	writer.setTitleIndex(std::move(titleIndex));
+	for (size_t i = 0; i < numOfUsers; i++) {
+		users[i]->writeToSnapshot(writer);
+	}
+	view.clear();
+	view.reserve(numOfTopics - removedTopicNum);
+	for (size_t i = 0; i < numOfTopics; i++) {
+		if (topics[i] != nullptr) {
+			view.push_back(topics[i]);
+		}
 	}
-
-	std::cout << ">Current progress was saved!" << std::endl;
-	writeFile.close();
 }
 
 /**
- * @brief Saves the current state of the social network to a specified file.
+ * @brief Captures the network and writes the next checkpoint on a background thread.
+ *
+ * A checkpoint mark is journaled first; records appended while the snapshot is written
+ * belong to the new generation and are moved to its journal when the snapshot is in place.
+ *
  * @param fileName File name.
+ * @return True if the background snapshot was started, otherwise false.
  */
-void System::saveAs(const std::string& fileName) const {
-	std::ofstream writeFile(fileName, std::ios::binary);
-
-	// newly created file...
-	writeFile.write(reinterpret_cast<const char*>(&numOfUsers), sizeof(numOfUsers));
-	writeFile.write(reinterpret_cast<const char*>(&capacityOfUsers), sizeof(capacityOfUsers));
-	// there is a resize() function, but why use it when you can directly set the capacity
-
-	for (size_t i = 0; i < numOfUsers; i++) {
-
-		//writeFile.write(reinterpret_cast<const char*>(users[i]->getPermissionRole()), sizeof(Permission));
-		users[i]->writeToFile(writeFile);
+bool System::startBackgroundCheckpoint(const std::string& fileName) {
+	std::uint64_t generation = snapshotGeneration + 1;
+	if (!journal.beginCheckpoint(generation)) {
+		return false;
 	}
+	SnapshotWriter writer;
+	std::vector<std::shared_ptr<const Topic>> view;
+	captureSnapshot(writer, view, generation);
+
+	checkpointGeneration = generation;
+	checkpointSucceeded = false;
+	checkpointDone = false;
+	checkpointThread = std::thread([this, fileName](SnapshotWriter writer, std::vector<std::shared_ptr<const Topic>> view) {
+#ifdef __linux__
+		// the snapshot only gets the processor time commands leave idle
+		sched_param param{};
+		pthread_setschedparam(pthread_self(), SCHED_IDLE, &param);
+#endif
+		checkpointSucceeded = writeSnapshotFile(writer, view, fileName);
+		checkpointStringStats = writer.getStringStats();
+		// the topics are released before reporting, so later changes stop copying them
+		view.clear();
+		checkpointDone = true;
+	}, std::move(writer), std::move(view));
+	return true;
+}
 
-	// begins saving data from topics
-	writeFile.write(reinterpret_cast<const char*>(&numOfTopics), sizeof(numOfTopics));
-	writeFile.write(reinterpret_cast<const char*>(&capacityOfTopics), sizeof(capacityOfTopics));
-
-	for (size_t i = 0; i < numOfTopics; i++) {
-		topics[i].writeToFile(writeFile);
-
-		for (size_t j = 0; j < topics[i].getDiscussionNum(); j++) {
-			topics[i].getTopicDiscussions()[j].writeToFile(writeFile);
-
-			for (size_t k = 0; k < topics[i].getTopicDiscussions()[j].getCommentNum(); k++) {
-				topics[i].getTopicDiscussions()[j].getDiscussionComments()[k].writeToFile(writeFile);
-			}
-		}
+/**
+ * @brief Completes a background checkpoint once its snapshot is written.
+ * @param wait Whether to wait for the snapshot if it is still being written.
+ */
+void System::finishBackgroundCheckpoint(bool wait) {
+	if (!checkpointThread.joinable() || (!wait && !checkpointDone)) {
+		return;
 	}
-
-	std::cout << ">Current progress was saved!" << std::endl;
-	writeFile.close();
+	checkpointThread.join();
+	if (!checkpointSucceeded) {
+		journal.abortCheckpoint();
+		std::cout << ">Background checkpoint failed!" << std::endl;
+		return;
+	}
+	snapshotGeneration = checkpointGeneration;
+	savedStringStats = checkpointStringStats;
+	if (!journal.finishCheckpoint(checkpointGeneration)) {
+		std::cout << ">Journal could not be moved to the new checkpoint!" << std::endl;
+	}
+	std::cout << ">Background checkpoint written!" << std::endl;
 }
 
 /**
@@ -372,29 +960,106 @@ void System::saveAs(const std::string& fileName) const {
  * @param description Topic description.
  */
 void System::createTopic(const std::string& topicTitle, const std::string& description) {
-	Topic newTopic(topicTitle, description, currUserId);
-	topics[numOfTopics] = newTopic;
-	numOfTopics++;
+	JournalRecord record(JournalOp::CREATE_TOPIC);
+	record.putString(topicTitle);
+	record.putString(description);
+	record.putUInt(currUserId);
+	commit(record);
+}
 
-	if (numOfTopics >= capacityOfTopics) {
-		resizeTopics();
+/**
+ * @brief Searches for topics by words of their titles and descriptions or by part of the title and displays all of them.
+ *
+ * Topics containing every word of the query come first, the most relevant at the top, followed by
+ * the other topics whose title contains the query as it is. Only the titles the title index
+ * cannot rule out are compared with the query.
+ *
+ * @param partOfTitle Words or part of the topic title.
+ */
+void System::searchTopic(const std::string& partOfTitle) {
+	std::vector<unsigned int> found = topicSearch.search(partOfTitle);
+	IdIndex listed;
+	listed.reserve(found.size());
+	for (unsigned int topicId : found) {
+		listed.insert(topicId, 0);
+	}
+	// the title index only narrows the candidates, each title is still checked
+	for (unsigned int topicId : titleSearch.findTopics(partOfTitle)) {
+		if (listed.find(topicId) >= 0) {
+			continue;
+		}
+		if (SubstringSearch::contains(topics[findTopic(topicId)]->getTopicTitle(), partOfTitle)) {
+			found.push_back(topicId);
+		}
+	}
+
+	if (found.empty()) {
+		std::cout << ">No topic found!" << std::endl;
+		return;
+	}
+	for (unsigned int topicId : found) {
+		const Topic& topic = *topics[findTopic(topicId)];
+		std::cout << "	>>" << topic.getTopicTitle() << " {id: " << topic.getTopicId() << "}\n";
 	}
 }
 
 /**
- * @brief Searches for a topic by part of the title and displays it if found.
- * @param partOfTitle Part of the topic title.
+ * @brief Searches for discussions of all topics by part of the title and displays all of them.
+ *
+ * Only the titles the title index cannot rule out are compared with the text; lazily loaded
+ * topics are loaded only if one of their discussions is such a candidate.
+ *
+ * @param partOfTitle Part of the discussion title.
  */
-void System::searchTopic(const std::string& partOfTitle) {
-	unsigned int found = 0;
-	for (size_t i = 0; i < numOfTopics; i++) {
-		found = topics[i].getTopicTitle().find(partOfTitle);
-		if (found != std::string::npos) {
-			std::cout << "	>>" << topics[i].getTopicTitle() << " {id: " << topics[i].getTopicId() << "}\n";
-			return;
+void System::searchDiscussions(const std::string& partOfTitle) {
+	bool found = false;
+	for (const std::pair<unsigned int, unsigned int>& candidate : titleSearch.findDiscussions(partOfTitle)) {
+		int slot = findTopic(candidate.first);
+		if (!topics[slot]->isLoaded()) {
+			editTopic(slot);
+		}
+		const Topic& topic = *topics[slot];
+		const Discussion& discussion = topic.getTopicDiscussions()[topic.findDiscussion(candidate.second)];
+		if (SubstringSearch::contains(discussion.getDiscussionTitle(), partOfTitle)) {
+			std::cout << "	>>" << topic.getTopicTitle() << " / " << discussion.getDiscussionTitle() <<
+				" {topic id: " << candidate.first << ", discussion id: " << candidate.second << "}\n";
+			found = true;
+		}
+	}
+	if (!found) {
+		std::cout << ">No discussion found!" << std::endl;
+	}
+}
+
+/**
+ * @brief Searches discussions, comments and replies by words and displays the most relevant ones.
+ *
+ * Any word of the query may match; discussions and comments using more of the words, and rarer
+ * ones, rank higher. At most MAX_POST_HITS results are shown.
+ *
+ * @param query Words to search for.
+ */
+void System::searchPosts(const std::string& query) {
+	if (!postSearchReady) {
+		indexPosts();
+	}
+	std::vector<PostSearchIndex::Hit> hits = postSearch.search(query, MAX_POST_HITS);
+	if (hits.empty()) {
+		std::cout << ">No post found!" << std::endl;
+		return;
+	}
+	for (const PostSearchIndex::Hit& hit : hits) {
+		const Topic& topic = *topics[findTopic(hit.topicId)];
+		const Discussion& discussion = topic.getTopicDiscussions()[topic.findDiscussion(hit.discussionId)];
+		std::cout << "	>>" << topic.getTopicTitle() << " / " << discussion.getDiscussionTitle();
+		if (hit.commentId == PostSearchIndex::NO_COMMENT) {
+			std::cout << " {topic id: " << hit.topicId << ", discussion id: " << hit.discussionId << "}\n";
+		}
+		else {
+			std::cout << ": " << discussion.getComment(discussion.findComment(hit.commentId)).getCommentText() <<
+				" {topic id: " << hit.topicId << ", discussion id: " << hit.discussionId << ", comment id: " << hit.commentId << "}\n";
 		}
 	}
-	std::cout << ">No topic found!" << std::endl;
 }
 
 /**
@@ -407,15 +1072,21 @@ void System::openTopic(const std::string& topicTitle) {
 		return;
 	}
 
+	int slot = -1;
 	for (size_t i = 0; i < numOfTopics; i++) {
-		if (topics[i].getTopicTitle() == topicTitle) {
-			currTopicId = topics[i].getTopicId();
+		if (topics[i] != nullptr && topics[i]->getTopicTitle() == topicTitle) {
+			slot = static_cast<int>(i);
 			break;
 		}
 	}
 
-	if (currTopicId > -1) {
-		std::cout << "	Welcome to \"" + topics[currTopicId].getTopicTitle() + "\"." << std::endl;
+	if (slot > -1) {
+		currTopicId = topics[slot]->getTopicId();
+		// discussions of a lazily loaded topic are read on its first opening
+		if (!topics[slot]->isLoaded()) {
+			editTopic(slot);
+		}
+		std::cout << "	Welcome to \"" << topics[slot]->getTopicTitle() << "\"." << std::endl;
 		return;
 	}
 	std::cout << ">Topic with such name does not exist!" << std::endl;
@@ -435,15 +1106,14 @@ void System::openTopic(unsigned int topicId) {
 		return;
 	}
 
-	for (size_t i = 0; i < numOfTopics; i++) {
-		if (topics[i].getTopicId() == topicId) {
-			currTopicId = topics[i].getTopicId();
-			break;
+	int slot = findTopic(topicId);
+	if (slot > -1) {
+		currTopicId = topicId;
+		// discussions of a lazily loaded topic are read on its first opening
+		if (!topics[slot]->isLoaded()) {
+			editTopic(slot);
 		}
-	}
-
-	if (currTopicId > -1) {
-		std::cout << "	Welcome to \"" + topics[currTopicId].getTopicTitle() + "\"." << std::endl;
+		std::cout << "	Welcome to \"" << topics[slot]->getTopicTitle() << "\"." << std::endl;
 		return;
 	}
 	std::cout << ">Topic with such id does not exist!" << std::endl;
@@ -463,7 +1133,7 @@ void System::quitTopic() {
 		currDiscussionId = -1;
 	}
 
-	std::cout << "	Closing topic \"" << topics[currTopicId].getTopicTitle() << "\"." << std::endl;
+	std::cout << "	Closing topic \"" << topics[findTopic(currTopicId)]->getTopicTitle() << "\"." << std::endl;
 	currTopicId = -1;
 }
 
@@ -473,7 +1143,7 @@ void System::quitTopic() {
  * @param topicId Identifier of the topic to be removed.
  *
  * Only moderators can remove topics. Upon successful removal,
- * a recalculation of users' points is called.
+ * the authors of its comments lose the ratings of those comments.
  */
 void System::removeTopic(unsigned int topicId) {
 	if (currUserPermission != Permission::MOD) {
@@ -481,15 +1151,11 @@ void System::removeTopic(unsigned int topicId) {
 		return;
 	}
 
-	for (size_t i = 0; i < numOfTopics; i++) {
-		if (topics[i].getTopicId() < topicId) {
-			continue;
-		}
-		topics[i] = topics[i + 1];
+	JournalRecord record(JournalOp::REMOVE_TOPIC);
+	record.putUInt(topicId);
+	if (!commit(record)) {
+		std::cout << ">Topic with such id does not exist!" << std::endl;
 	}
-	numOfTopics--;
-
-	calculateUserPoints();
 }
 
 /**
@@ -498,10 +1164,14 @@ void System::removeTopic(unsigned int topicId) {
  * If no topic is selected, an error message is displayed.
  */
 void System::listDiscussions() const {
-	for (size_t i = 0; i < topics[currTopicId].getDiscussionNum(); i++) {
-		std::cout << "	" + topics[currTopicId].getTopicDiscussions()->getDiscussionTitle() <<
-			" {id: " + topics[currTopicId].getTopicDiscussions()->getDiscussionId() << "}\n";
+	if (currTopicId == -1) {
+		std::cout << ">No topic selected!" << std::endl;
+		return;
 	}
+	const Topic& topic = *topics[findTopic(currTopicId)];
+	topic.forEachDiscussion([](const Discussion& discussion) {
+		std::cout << "	" << discussion.getDiscussionTitle() << " {id: " << discussion.getDiscussionId() << "}\n";
+	});
 }
 
 /**
@@ -517,9 +1187,12 @@ void System::postDiscussion(const std::string& discussionTitle, const std::strin
 		std::cout << ">No topic selected!" << std::endl;
 		return;
 	}
-	Discussion newDiscussion(discussionTitle, discussionContents, currUserId, topics[currTopicId].getDiscussionNum());
-	topics[currTopicId].getTopicDiscussions()[topics[currTopicId].getDiscussionNum()] = newDiscussion;
-	topics[currTopicId].discussionNumIncrement();
+	JournalRecord record(JournalOp::POST_DISCUSSION);
+	record.putUInt(currTopicId);
+	record.putString(discussionTitle);
+	record.putString(discussionContents);
+	record.putUInt(currUserId);
+	commit(record);
 }
 
 /**
@@ -541,19 +1214,14 @@ void System::openDiscussion(unsigned int discussionId) {
 		return;
 	}
 
-	for (size_t i = 0; i < topics[currTopicId].getDiscussionNum(); i++) {
-		if (topics[currTopicId].getTopicDiscussions()[i].getDiscussionId() == discussionId) {
-			currDiscussionId = topics[currTopicId].getTopicDiscussions()[i].getDiscussionId();
-			break;
-		}
-	}
-
-	if (currDiscussionId > -1) {
-		std::cout << "	Welcome to \"" << topics[currTopicId].getTopicDiscussions()[currDiscussionId].getDiscussionTitle() << "\".\n";
-		std::cout << "	The contents of this discussion are as follow: \n	" <<
-			topics[currTopicId].getTopicDiscussions()[currDiscussionId].getDiscussionContents() << ".\n";
-		std::cout << "	There are currently " + topics[currTopicId].getTopicDiscussions()[currDiscussionId].getCommentNum() <<
-			" comments in the discussion." << std::endl;
+	const Topic& topic = *topics[findTopic(currTopicId)];
+	int slot = topic.findDiscussion(discussionId);
+	if (slot > -1) {
+		currDiscussionId = discussionId;
+		const Discussion& discussion = topic.getTopicDiscussions()[slot];
+		std::cout << "	Welcome to \"" << discussion.getDiscussionTitle() << "\".\n";
+		std::cout << "	The contents of this discussion are as follow: \n	" << discussion.getDiscussionContents() << ".\n";
+		std::cout << "	There are currently " << discussion.getCommentNum() << " comments and " << discussion.getReplyNum() << " replies in the discussion." << std::endl;
 		return;
 	}
 	std::cout << ">Discussion with such id does not exist!" << std::endl;
@@ -574,7 +1242,7 @@ void System::quitDiscussion(){
 		return;
 	}
 
-	std::cout << "	Closing discussion \"" << topics[currTopicId].getTopicDiscussions()[currDiscussionId].getDiscussionTitle() << "\"." << std::endl;
+	std::cout << "	Closing discussion \"" << openedDiscussion().getDiscussionTitle() << "\"." << std::endl;
 	currDiscussionId = -1;
 }
 
@@ -584,25 +1252,24 @@ void System::quitDiscussion(){
  * @param discussionId ID of the discussion to be removed.
  *
  * Only moderators can remove discussions. Upon successful removal,
- * a recalculation of users' points is called.
+ * the authors of its comments lose the ratings of those comments.
  */
 void System::removeDiscussion(unsigned int discussionId) {
-	//topics[currTopicId].getTopicDiscussions()[currDiscussionId].
 	if (currUserPermission != Permission::MOD) {
 		std::cout << ">Access denied!" << std::endl;
 		return;
 	}
-
-	for (size_t i = 0; i < topics[currTopicId].getDiscussionNum(); i++) {
-		if (topics[currTopicId].getTopicDiscussions()[i].getDiscussionId() < discussionId) {
-			continue;
-		}
-		topics[currTopicId].getTopicDiscussions()[i] = topics[currTopicId].getTopicDiscussions()[i + 1];
+	if (currTopicId == -1) {
+		std::cout << ">No topic selected!" << std::endl;
+		return;
 	}
-	topics[currTopicId].discussionNumDecrement();
 
-	// change user points/rating...
-	calculateUserPoints();
+	JournalRecord record(JournalOp::REMOVE_DISCUSSION);
+	record.putUInt(currTopicId);
+	record.putUInt(discussionId);
+	if (!commit(record)) {
+		std::cout << ">Discussion with such id does not exist!" << std::endl;
+	}
 }
 
 /**
@@ -619,7 +1286,7 @@ void System::listComments() const {
 		std::cout << ">No discussion selected!" << std::endl;
 		return;
 	}
-	topics[currTopicId].getTopicDiscussions()[currDiscussionId].listComments();
+	openedDiscussion().listComments();
 }
 
 /**
@@ -636,7 +1303,16 @@ void System::addComment() {
 		std::cout << ">No discussion selected!" << std::endl;
 		return;
 	}
-	topics[currTopicId].getTopicDiscussions()[currDiscussionId].addComment(currUserId);
+	std::string buff;
+	std::cout << ">Enter a comment: ";
+	std::getline(std::cin, buff);
+
+	JournalRecord record(JournalOp::ADD_COMMENT);
+	record.putUInt(currTopicId);
+	record.putUInt(currDiscussionId);
+	record.putUInt(currUserId);
+	record.putString(buff);
+	commit(record);
 }
 
 /**
@@ -655,7 +1331,21 @@ void System::addReply(unsigned int commentId) {
 		std::cout << ">No discussion selected!" << std::endl;
 		return;
 	}
-	topics[currTopicId].getTopicDiscussions()[currDiscussionId].commentReply(currUserId, commentId);
+	if (openedDiscussion().findComment(commentId) < 0) {
+		std::cout << ">Comment with such id does not exist!" << std::endl;
+		return;
+	}
+	std::string buff;
+	std::cout << ">Enter the reply: ";
+	std::getline(std::cin, buff);
+
+	JournalRecord record(JournalOp::ADD_REPLY);
+	record.putUInt(currTopicId);
+	record.putUInt(currDiscussionId);
+	record.putUInt(commentId);
+	record.putUInt(currUserId);
+	record.putString(buff);
+	commit(record);
 }
 
 /**
@@ -674,7 +1364,32 @@ void System::commentVote(unsigned int commentId) {
 		std::cout << ">No discussion selected!" << std::endl;
 		return;
 	}
-	topics[currTopicId].getTopicDiscussions()[currDiscussionId].commentVote(currUserId, commentId);
+	const Discussion& discussion = openedDiscussion();
+	int slot = discussion.findComment(commentId);
+	if (slot < 0) {
+		std::cout << ">Comment with such id does not exist!" << std::endl;
+		return;
+	}
+	if (discussion.getComment(slot).DidUserAlreadyVote(currUserId)) {
+		std::cout << ">You have already voted!\n";
+		return;
+	}
+	char vote;
+	std::cout << ">Upvote or downvote a comment(U/D): ";
+	std::cin >> vote;
+
+	while (vote != 'U' && vote != 'u' && vote != 'D' && vote != 'd') {
+		std::cout << ">No such vote exists! Enter a new vote(U/D): ";
+		std::cin >> vote;
+	}
+
+	JournalRecord record(JournalOp::COMMENT_VOTE);
+	record.putUInt(currTopicId);
+	record.putUInt(currDiscussionId);
+	record.putUInt(commentId);
+	record.putUInt(currUserId);
+	record.putUInt(vote == 'U' || vote == 'u' ? 1 : 0);
+	commit(record);
 }
 
 /**
@@ -693,27 +1408,493 @@ void System::removeComment(unsigned int commentId) {
 		std::cout << ">No discussion selected!" << std::endl;
 		return;
 	}
-	topics[currTopicId].getTopicDiscussions()[currDiscussionId].removeComment(currUserId, commentId, currUserPermission);
+	const Discussion& discussion = openedDiscussion();
+	int slot = discussion.findComment(commentId);
+	if (slot < 0) {
+		std::cout << ">Comment with such id does not exist!" << std::endl;
+		return;
+	}
+	if (discussion.getComment(slot).getAuthorId() != static_cast<unsigned int>(currUserId) && currUserPermission != Permission::MOD) {
+		std::cout << ">Access denied!\n";
+		return;
+	}
+
+	JournalRecord record(JournalOp::REMOVE_COMMENT);
+	record.putUInt(currTopicId);
+	record.putUInt(currDiscussionId);
+	record.putUInt(commentId);
+	commit(record);
 }
 
 /**
- * @brief Calculates and updates users' points in the system.
+ * @brief Recalculates users' points from scratch and reports how many were out of date.
  *
- * Points are calculated based on the ratings of the comments they have written.
- * When this method is called, all user points are reset and recalculated.
+ * Points are maintained on every vote and removal; this is only needed to verify or repair them.
  */
-void System::calculateUserPoints() { // maybe recalculate
-	// If I take out the first for-loop and add userId, there will be three for-loops
-	for (size_t i = 0; i < numOfUsers; i++) {
-		users[i]->changePoints(0); // resets previous score and recalculates points
-		for (size_t j = 0; j < numOfTopics; j++) {
-			for (size_t k = 0; k < topics[j].getDiscussionNum(); k++) {
-				for (size_t l = 0; l < topics[j].getTopicDiscussions()[k].getCommentNum(); l++) {
-					if (topics[j].getTopicDiscussions()[k].getDiscussionComments()[l].getAuthorId() == users[i]->getId()) {
-						users[i]->changePoints(topics[j].getTopicDiscussions()[k].getDiscussionComments()[l].getCommentRating());
-					}
+void System::rebuildUserPoints() {
+	unsigned int corrected = calculateUserPoints();
+	std::cout << ">Points of " << numOfUsers << " users rebuilt, " << corrected << " of them were out of date." << std::endl;
+}
+
+/**
+ * @brief Displays every comment and reply of all topics whose text contains a given text.
+ *
+ * Only moderators can scan comments. No index covers arbitrary parts of comment texts, so every
+ * text is checked with the vectorised SubstringSearch; lazily loaded topics are loaded first.
+ *
+ * @param text The text to look for.
+ */
+void System::scanComments(const std::string& text) {
+	if (currUserPermission != Permission::MOD) {
+		std::cout << ">Access denied!" << std::endl;
+		return;
+	}
+	unsigned int found = 0;
+	for (unsigned int i = 0; i < numOfTopics; i++) {
+		if (topics[i] == nullptr) {
+			continue;
+		}
+		if (!topics[i]->isLoaded()) {
+			editTopic(i);
+		}
+		const Topic& topic = *topics[i];
+		topic.forEachDiscussion([&](const Discussion& discussion) {
+			discussion.forEachComment([&](const Comment& comment) {
+				if (SubstringSearch::contains(comment.getCommentText(), text)) {
+					std::cout << "	>>" << topic.getTopicTitle() << " / " << discussion.getDiscussionTitle() << ": " << comment.getCommentText() <<
+						" {topic id: " << topic.getTopicId() << ", discussion id: " << discussion.getDiscussionId() << ", comment id: " << comment.getCommentId() << "}\n";
+					found++;
 				}
+			});
+		});
+	}
+	if (found == 0) {
+		std::cout << ">No comment found!" << std::endl;
+		return;
+	}
+	std::cout << ">" << found << " comments found." << std::endl;
+}
+
+/**
+ * @brief Recalculates the points of all users from the ratings of their comments and replies.
+ *
+ * Every comment is visited once. Topics are spread over worker threads the same way as on load;
+ * each thread adds up the ratings into its own array indexed by user ID, and the arrays are summed
+ * at the end, so the threads never write to shared memory.
+ *
+ * @return Number of users whose points changed.
+ */
+unsigned int System::calculateUserPoints() {
+	unsigned int workerCount = loadWorkerCount(numOfTopics);
+	std::vector<std::vector<long long>> partialPoints(workerCount + 1, std::vector<long long>(numOfUsers, 0));
+	std::atomic<unsigned int> nextTopic(0);
+	auto sumTopics = [&](std::vector<long long>& points) {
+		for (unsigned int i = nextTopic++; i < numOfTopics; i = nextTopic++) {
+			if (topics[i] == nullptr) {
+				continue;
 			}
+			topics[i]->forEachRating([&points](unsigned int authorId, int rating) {
+				if (authorId < points.size()) {
+					points[authorId] += rating;
+				}
+			});
+		}
+	};
+	std::vector<std::thread> workers;
+	for (unsigned int i = 1; i <= workerCount; i++) {
+		workers.emplace_back(sumTopics, std::ref(partialPoints[i]));
+	}
+	sumTopics(partialPoints[0]);
+	for (std::thread& worker : workers) {
+		worker.join();
+	}
+
+	unsigned int corrected = 0;
+	for (size_t i = 0; i < numOfUsers; i++) {
+		if (users[i] == nullptr) {
+			continue;
 		}
+		long long sum = 0;
+		for (const std::vector<long long>& points : partialPoints) {
+			sum += points[i];
+		}
+		int points = static_cast<int>(sum);
+		if (static_cast<int>(users[i]->getPoints()) != points) {
+			users[i]->setPoints(points);
+			corrected++;
+		}
+	}
+	return corrected;
+}
+
+/**
+ * @brief Applies a mutation and, if it succeeded, records it in the journal.
+ *
+ * Commands and journal replay go through the same decoding, so a replayed record
+ * changes the network exactly like the command that produced it. A journal that failed
+ * to write keeps the change pending; the next save writes a full snapshot instead.
+ *
+ * @param record The mutation.
+ * @return True if the mutation was applied, otherwise false.
+ */
+bool System::commit(const JournalRecord& record) {
+	finishBackgroundCheckpoint(false);
+	if (!applyRecord(record)) {
+		return false;
+	}
+	if (!journal.append(record)) {
+		std::cout << ">Journal could not be written, the change is kept until the next save." << std::endl;
+	}
+	return true;
+}
+
+/**
+ * @brief Decodes a journal record and applies the mutation it describes.
+ * @param record The mutation.
+ * @return True if the mutation was applied, otherwise false.
+ */
+bool System::applyRecord(const JournalRecord& record) {
+	std::uint32_t topicId = 0, discussionId = 0, commentId = 0, userId = 0, value = 0;
+	std::int32_t role = 0;
+	std::string first, second, third, fourth;
+	JournalRecordReader reader(record);
+
+	switch (record.getOp()) {
+	case JournalOp::SIGNUP:
+		return reader.getString(first) && reader.getString(second) && reader.getString(third) && reader.getString(fourth) &&
+			applySignup(first, second, third, fourth);
+	case JournalOp::EDIT_USER:
+		return reader.getUInt(userId) && reader.getUInt(value) && reader.getString(first) &&
+			applyEditUser(userId, static_cast<UserField>(value), first);
+	case JournalOp::SET_ROLE:
+		return reader.getUInt(userId) && reader.getInt(role) && applySetRole(userId, static_cast<Permission>(role));
+	case JournalOp::CREATE_TOPIC:
+		return reader.getString(first) && reader.getString(second) && reader.getUInt(userId) &&
+			applyCreateTopic(first, second, userId);
+	case JournalOp::REMOVE_TOPIC:
+		return reader.getUInt(topicId) && applyRemoveTopic(topicId);
+	case JournalOp::POST_DISCUSSION:
+		return reader.getUInt(topicId) && reader.getString(first) && reader.getString(second) && reader.getUInt(userId) &&
+			applyPostDiscussion(topicId, first, second, userId);
+	case JournalOp::REMOVE_DISCUSSION:
+		return reader.getUInt(topicId) && reader.getUInt(discussionId) && applyRemoveDiscussion(topicId, discussionId);
+	case JournalOp::ADD_COMMENT:
+		return reader.getUInt(topicId) && reader.getUInt(discussionId) && reader.getUInt(userId) && reader.getString(first) &&
+			applyAddComment(topicId, discussionId, userId, first);
+	case JournalOp::ADD_REPLY:
+		return reader.getUInt(topicId) && reader.getUInt(discussionId) && reader.getUInt(commentId) && reader.getUInt(userId) &&
+			reader.getString(first) && applyAddReply(topicId, discussionId, commentId, userId, first);
+	case JournalOp::COMMENT_VOTE:
+		return reader.getUInt(topicId) && reader.getUInt(discussionId) && reader.getUInt(commentId) && reader.getUInt(userId) &&
+			reader.getUInt(value) && applyCommentVote(topicId, discussionId, commentId, userId, value != 0);
+	case JournalOp::REMOVE_COMMENT:
+		return reader.getUInt(topicId) && reader.getUInt(discussionId) && reader.getUInt(commentId) &&
+			applyRemoveComment(topicId, discussionId, commentId);
+	default:
+		return false;
+	}
+}
+
+/**
+ * @brief Adds a new user; the first user becomes a moderator.
+ *
+ * A nickname that is already taken is refused, so a replayed journal cannot add it twice.
+ *
+ * @param firstName User first name.
+ * @param lastName User last name.
+ * @param nickname User nickname.
+ * @param password User password.
+ * @return True if the user was added, otherwise false.
+ */
+bool System::applySignup(const std::string& firstName, const std::string& lastName, const std::string& nickname, const std::string& password) {
+	if (!nicknames.insert(nickname, numOfUsers)) {
+		return false;
+	}
+	if (numOfUsers == 0) {
+		Moderator firstNewUser(firstName, lastName, nickname, password);
+		users[numOfUsers] = firstNewUser.clone();
+		numOfUsers++;
+	}
+	else {
+		User newUser(firstName, lastName, nickname, password);
+		users[numOfUsers] = newUser.clone();
+		numOfUsers++;
+	}
+
+	if (numOfUsers >= capacityOfUsers) {
+		resizeUsers();
+	}
+	return true;
+}
+
+/**
+ * @brief Changes a personal field of a user.
+ * @param userId User ID.
+ * @param field The field to change.
+ * @param value The new value.
+ * @return True if the field was changed, otherwise false.
+ */
+bool System::applyEditUser(unsigned int userId, UserField field, const std::string& value) {
+	if (userId >= numOfUsers) {
+		return false;
+	}
+	if (field == UserField::FIRST_NAME) {
+		users[userId]->setFirstName(value);
+		return true;
+	}
+	if (field == UserField::LAST_NAME) {
+		users[userId]->setLastName(value);
+		return true;
+	}
+	if (field == UserField::PASSWORD) {
+		users[userId]->setPassword(value);
+		return true;
+	}
+	return false;
+}
+
+/**
+ * @brief Changes the role of a user.
+ * @param userId User ID.
+ * @param role The new role.
+ * @return True if the role was changed, otherwise false.
+ */
+bool System::applySetRole(unsigned int userId, Permission role) {
+	if (userId >= numOfUsers || (role != Permission::USER && role != Permission::MOD)) {
+		return false;
+	}
+	users[userId]->setPermissionRole(role);
+	return true;
+}
+
+/**
+ * @brief Adds a new topic.
+ * @param topicTitle Topic title.
+ * @param description Topic description.
+ * @param creatorId Topic creator ID.
+ * @return True if the topic was added, otherwise false.
+ */
+bool System::applyCreateTopic(const std::string& topicTitle, const std::string& description, unsigned int creatorId) {
+	topics[numOfTopics] = std::make_shared<Topic>(topicTitle, description, creatorId);
+	topicSlots.insert(topics[numOfTopics]->getTopicId(), numOfTopics);
+	topicSearch.addTopic(topics[numOfTopics]->getTopicId(), topics[numOfTopics]->getTopicTitle(), topics[numOfTopics]->getTopicDescription());
+	titleSearch.addTopic(topics[numOfTopics]->getTopicId(), topics[numOfTopics]->getTopicTitle());
+	numOfTopics++;
+
+	if (numOfTopics >= capacityOfTopics) {
+		resizeTopics();
+	}
+	return true;
+}
+
+/**
+ * @brief Removes a topic.
+ *
+ * The topic is freed and its slot left empty, so the topics after it stay where they are;
+ * the slots are reclaimed once removed topics fill half of the array. The topic is closed
+ * if it was open. The authors of its comments lose the ratings of those comments.
+ *
+ * @param topicId Topic ID.
+ * @return True if the topic was removed, otherwise false.
+ */
+bool System::applyRemoveTopic(unsigned int topicId) {
+	int slot = findTopic(topicId);
+	if (slot < 0) {
+		return false;
+	}
+	topics[slot]->forEachRating([this](unsigned int authorId, int rating) {
+		addPoints(authorId, -rating);
+	});
+
+	if (postSearchReady) {
+		topics[slot]->forEachDiscussion([this, topicId](const Discussion& discussion) {
+			postSearch.removeDiscussion(topicId, discussion.getDiscussionId());
+		});
+	}
+	topicSlots.erase(topicId);
+	topicSearch.removeTopic(topicId);
+	titleSearch.removeTopic(topicId);
+	topics[slot].reset();
+	removedTopicNum++;
+	if (removedTopicNum * 2 > numOfTopics) {
+		compactTopics();
+	}
+	if (currTopicId == static_cast<int>(topicId)) {
+		currTopicId = -1;
+		currDiscussionId = -1;
+	}
+	return true;
+}
+
+/**
+ * @brief Adds a new discussion to a topic.
+ * @param topicId Topic ID.
+ * @param discussionTitle Discussion title.
+ * @param discussionContents Discussion content.
+ * @param creatorId Discussion creator ID.
+ * @return True if the discussion was added, otherwise false.
+ */
+bool System::applyPostDiscussion(unsigned int topicId, const std::string& discussionTitle, const std::string& discussionContents, unsigned int creatorId) {
+	int slot = findTopic(topicId);
+	if (slot < 0) {
+		return false;
+	}
+	Topic& topic = editTopic(slot);
+	topic.addDiscussion(discussionTitle, discussionContents, creatorId);
+	titleSearch.addDiscussion(topicId, topic.getDiscussionID() - 1, discussionTitle);
+	if (postSearchReady) {
+		postSearch.addDiscussion(topicId, topic.getDiscussionID() - 1, discussionTitle, discussionContents);
+	}
+	return true;
+}
+
+/**
+ * @brief Removes a discussion from a topic.
+ *
+ * The discussion is closed if it was open. The authors of its comments lose the ratings of those comments.
+ *
+ * @param topicId Topic ID.
+ * @param discussionId Discussion ID.
+ * @return True if the discussion was removed, otherwise false.
+ */
+bool System::applyRemoveDiscussion(unsigned int topicId, unsigned int discussionId) {
+	int slot = findTopic(topicId);
+	if (slot < 0) {
+		return false;
+	}
+	Topic& topic = editTopic(slot);
+	int discussionSlot = topic.findDiscussion(discussionId);
+	if (discussionSlot < 0) {
+		return false;
+	}
+	topic.getTopicDiscussions()[discussionSlot].forEachRating([this](unsigned int authorId, int rating) {
+		addPoints(authorId, -rating);
+	});
+	topic.removeDiscussion(discussionId);
+	titleSearch.removeDiscussion(topicId, discussionId);
+	if (postSearchReady) {
+		postSearch.removeDiscussion(topicId, discussionId);
+	}
+	if (currTopicId == static_cast<int>(topicId) && currDiscussionId == static_cast<int>(discussionId)) {
+		currDiscussionId = -1;
+	}
+	return true;
+}
+
+/**
+ * @brief Adds a comment to a discussion.
+ * @param topicId Topic ID.
+ * @param discussionId Discussion ID.
+ * @param authorId Comment author ID.
+ * @param text Comment text.
+ * @return True if the comment was added, otherwise false.
+ */
+bool System::applyAddComment(unsigned int topicId, unsigned int discussionId, unsigned int authorId, const std::string& text) {
+	int slot = findTopic(topicId);
+	if (slot < 0) {
+		return false;
+	}
+	Topic& topic = editTopic(slot);
+	int discussionSlot = topic.findDiscussion(discussionId);
+	if (discussionSlot < 0) {
+		return false;
+	}
+	Discussion& discussion = topic.getTopicDiscussions()[discussionSlot];
+	discussion.addComment(authorId, text);
+	if (postSearchReady) {
+		postSearch.addComment(topicId, discussionId, discussion.getCommentID() - 1, text);
+	}
+	return true;
+}
+
+/**
+ * @brief Adds a reply to a comment.
+ * @param topicId Topic ID.
+ * @param discussionId Discussion ID.
+ * @param commentId Comment ID.
+ * @param authorId Reply author ID.
+ * @param text Reply text.
+ * @return True if the reply was added, otherwise false.
+ */
+bool System::applyAddReply(unsigned int topicId, unsigned int discussionId, unsigned int commentId, unsigned int authorId, const std::string& text) {
+	int slot = findTopic(topicId);
+	if (slot < 0) {
+		return false;
+	}
+	Topic& topic = editTopic(slot);
+	int discussionSlot = topic.findDiscussion(discussionId);
+	if (discussionSlot < 0) {
+		return false;
+	}
+	Discussion& discussion = topic.getTopicDiscussions()[discussionSlot];
+	if (!discussion.commentReply(authorId, commentId, text)) {
+		return false;
+	}
+	if (postSearchReady) {
+		postSearch.addComment(topicId, discussionId, discussion.getCommentID() - 1, text);
+	}
+	return true;
+}
+
+/**
+ * @brief Votes for a comment.
+ * @param topicId Topic ID.
+ * @param discussionId Discussion ID.
+ * @param commentId Comment ID.
+ * @param userId ID of the voting user.
+ * @param upvote True for an upvote, false for a downvote.
+ * @return True if the vote was counted, false if the comment does not exist or the user already voted.
+ */
+bool System::applyCommentVote(unsigned int topicId, unsigned int discussionId, unsigned int commentId, unsigned int userId, bool upvote) {
+	int slot = findTopic(topicId);
+	if (slot < 0) {
+		return false;
+	}
+	Topic& topic = editTopic(slot);
+	int discussionSlot = topic.findDiscussion(discussionId);
+	if (discussionSlot < 0) {
+		return false;
+	}
+	Discussion& discussion = topic.getTopicDiscussions()[discussionSlot];
+	if (!discussion.commentVote(userId, commentId, upvote)) {
+		return false;
+	}
+	addPoints(discussion.getComment(discussion.findComment(commentId)).getAuthorId(), upvote ? 1 : -1);
+	return true;
+}
+
+/**
+ * @brief Removes a comment from a discussion.
+ *
+ * The authors of the comment and of its replies lose their ratings.
+ *
+ * @param topicId Topic ID.
+ * @param discussionId Discussion ID.
+ * @param commentId Comment ID.
+ * @return True if the comment was removed, otherwise false.
+ */
+bool System::applyRemoveComment(unsigned int topicId, unsigned int discussionId, unsigned int commentId) {
+	int slot = findTopic(topicId);
+	if (slot < 0) {
+		return false;
+	}
+	Topic& topic = editTopic(slot);
+	int discussionSlot = topic.findDiscussion(discussionId);
+	if (discussionSlot < 0) {
+		return false;
+	}
+	Discussion& discussion = topic.getTopicDiscussions()[discussionSlot];
+	int commentSlot = discussion.findComment(commentId);
+	if (commentSlot < 0) {
+		return false;
+	}
+	discussion.forEachRatingBelow(commentSlot, [this](unsigned int authorId, int rating) {
+		addPoints(authorId, -rating);
+	});
+	if (postSearchReady) {
+		discussion.forEachCommentBelow(commentSlot, [this, topicId, discussionId](const Comment& comment) {
+			postSearch.removeComment(topicId, discussionId, comment.getCommentId());
+		});
 	}
+	return discussion.removeComment(commentId);
 }
@@ -1,21 +1,51 @@
 ﻿#pragma once
+#include <atomic>
 #include <fstream>
+#include <memory>
+#include <thread>
+#include <vector>
 #include "Moderator.h"
 #include "Topic.h"
+#include "Snapshot.h"
+#include "Journal.h"
+#include "NicknameIndex.h"
+#include "IdIndex.h"
+#include "TopicSearchIndex.h"
+#include "PostSearchIndex.h"
+#include "TitleTrigramIndex.h"
+
+/**
+ * @enum UserField
+ * @brief Personal fields of a user that can be edited.
+ */
+enum class UserField {
+	FIRST_NAME, ///< User first name.
+	LAST_NAME,  ///< User last name.
+	PASSWORD    ///< User password.
+};
 
 /**
  * @brief The System class represents the entire social network. This class is a singleton and provides various functions for managing users, topics, discussions, and comments.
  */
 class System {
 private:
+	static const unsigned int MAX_POST_HITS = 10; ///< Most results shown by a post search.
+
 	User** users; ///< Array of pointers to users.
-	Topic* topics; ///< Array of topics.
+	std::shared_ptr<Topic>* topics; ///< Array of topics, shared with a background snapshot until changed.
 
 	unsigned int capacityOfUsers; ///< User array capacity.
 	unsigned int numOfUsers; ///< Number of current users.
+	NicknameIndex nicknames; ///< Slot of every user by nickname.
 
 	unsigned int capacityOfTopics; ///< Topic array capacity.
-	unsigned int numOfTopics; ///< Number of current topics.
+	unsigned int numOfTopics; ///< Number of used topic slots, removed topics included.
+	unsigned int removedTopicNum; ///< Number of removed topics whose slots are still empty.
+	IdIndex topicSlots; ///< Slot of every topic by topic ID.
+	TopicSearchIndex topicSearch; ///< Topics by the words of their titles and descriptions.
+	TitleTrigramIndex titleSearch; ///< Topics and discussions by the three-byte sequences of their titles.
+	PostSearchIndex postSearch; ///< Discussions, comments and replies by their words, once built.
+	bool postSearchReady; ///< Whether postSearch was built and is kept up to date.
 
 	int currUserId; ///< ID of the currently logged in user.
 	Permission currUserPermission; ///< Permession role of the currently logged in user.
@@ -25,6 +55,22 @@ private:
 	int currTopicId; ///< Identifier of the currently open topic.
 	int currDiscussionId; ///< Identifier of the currently open discussion.
 
+	SnapshotReader snapshot; ///< Mapping of the loaded snapshot, texts of the network point into it.
+	std::uint64_t snapshotGeneration; ///< Checkpoint generation of the opened file.
+	Journal journal; ///< Mutations made since the last checkpoint of the opened file.
+	bool lazyLoading; ///< Whether topics of a snapshot are loaded on first use.
+
+	bool backgroundCheckpoints; ///< Whether checkpoints are written by a background thread.
+	std::thread checkpointThread; ///< Thread writing a background snapshot.
+	std::atomic<bool> checkpointDone; ///< Set by the background thread when the snapshot is written.
+	bool checkpointSucceeded; ///< Whether the background snapshot was put in place.
+	std::uint64_t checkpointGeneration; ///< Generation of the background snapshot.
+	SnapshotStringStats checkpointStringStats; ///< String heap figures of the background snapshot.
+
+	int compressionLevel; ///< Compression level of the string heap in written snapshots, 0 stores it plainly.
+	SnapshotStringStats savedStringStats; ///< String heap figures of the last written snapshot.
+	SnapshotStringStats loadedStringStats; ///< String heap figures of the last loaded snapshot.
+
 	/**
 	 * @brief Increases the capacity of the user array.
 	 */
@@ -35,11 +81,248 @@ private:
 	 */
 	void resizeTopics();
 
+	/**
+	 * @brief Rebuilds the nickname index from the user array.
+	 */
+	void indexNicknames();
+
+	/**
+	 * @brief Rebuilds the topic index and the topic search index from the topic array.
+	 */
+	void indexTopics();
+
+	/**
+	 * @brief Rebuilds the title index from all topics and discussions, loading lazily loaded topics.
+	 */
+	void indexTitles();
+
+	/**
+	 * @brief Builds the post search index from all discussions and comments, loading lazily loaded topics.
+	 */
+	void indexPosts();
+
+	/**
+	 * @brief Moves the remaining topics over the empty slots of removed ones.
+	 */
+	void compactTopics();
+
+	/**
+	 * @brief Looks up a topic by ID.
+	 * @param topicId Topic ID.
+	 * @return Index of the topic in the topic array, or -1 if there is no such topic.
+	 */
+	int findTopic(unsigned int topicId) const;
+
+	/**
+	 * @brief Adds points to a user, as a comment of the user gains or loses rating.
+	 * @param userId User ID.
+	 * @param delta Change of the points.
+	 */
+	void addPoints(unsigned int userId, int delta);
+
+	/**
+	 * @brief Recalculates the points of all users from the ratings of their comments and replies.
+	 *
+	 * Topics are summed in parallel into per-thread arrays that are added up at the end.
+	 *
+	 * @return Number of users whose points changed.
+	 */
+	unsigned int calculateUserPoints();
+
+	/**
+	 * @brief Returns the currently open discussion.
+	 *
+	 * A topic and a discussion must be open.
+	 *
+	 * @return Reference to the discussion.
+	 */
+	Discussion& openedDiscussion() const;
+
 	/**
 	 * @brief Frees dynamically allocated memory.
 	 */
 	void free();
 
+	/**
+	 * @brief Returns a loaded topic for changing, copying it first if a background snapshot still shares it.
+	 * @param index Index of the topic.
+	 * @return Reference to the topic.
+	 */
+	Topic& editTopic(unsigned int index);
+
+	/**
+	 * @brief Loads the network from a memory-mapped snapshot file.
+	 * @param fileName File name.
+	 */
+	void loadSnapshot(const std::string& fileName);
+
+	/**
+	 * @brief Loads the network from a file in the old field-by-field format.
+	 * @param fileName File name.
+	 */
+	void loadLegacy(const std::string& fileName);
+
+	/**
+	 * @brief Writes the whole network as a snapshot file.
+	 * @param fileName File name.
+	 * @param generation Checkpoint generation stored in the snapshot.
+	 * @return True if the snapshot was written, otherwise false.
+	 */
+	bool writeSnapshot(const std::string& fileName, std::uint64_t generation);
+
+	/**
+	 * @brief Captures a point-in-time view of the network for a snapshot.
+	 * @param writer Receives the users.
+	 * @param view Receives the topics, shared with the network.
+	 * @param generation Checkpoint generation stored in the snapshot.
+	 */
+	void captureSnapshot(SnapshotWriter& writer, std::vector<std::shared_ptr<const Topic>>& view, std::uint64_t generation);
+
+	/**
+	 * @brief Captures the network and writes the next checkpoint on a background thread.
+	 * @param fileName File name.
+	 * @return True if the background snapshot was started, otherwise false.
+	 */
+	bool startBackgroundCheckpoint(const std::string& fileName);
+
+	/**
+	 * @brief Completes a background checkpoint once its snapshot is written.
+	 * @param wait Whether to wait for the snapshot if it is still being written.
+	 */
+	void finishBackgroundCheckpoint(bool wait);
+
+	/**
+	 * @brief Writes a new snapshot and starts an empty journal for it.
+	 * @param fileName File name.
+	 * @return True if the checkpoint was written, otherwise false.
+	 */
+	bool writeCheckpoint(const std::string& fileName);
+
+	/**
+	 * @brief Replays the journal of a freshly loaded snapshot.
+	 * @param fileName Snapshot file name.
+	 */
+	void replayJournal(const std::string& fileName);
+
+	/**
+	 * @brief Applies a mutation and, if it succeeded, records it in the journal.
+	 * @param record The mutation.
+	 * @return True if the mutation was applied, otherwise false.
+	 */
+	bool commit(const JournalRecord& record);
+
+	/**
+	 * @brief Decodes a journal record and applies the mutation it describes.
+	 * @param record The mutation.
+	 * @return True if the mutation was applied, otherwise false.
+	 */
+	bool applyRecord(const JournalRecord& record);
+
+	/**
+	 * @brief Adds a new user; the first user becomes a moderator.
+	 *
+	 * A nickname that is already taken is refused.
+	 *
+	 * @param firstName User first name.
+	 * @param lastName User last name.
+	 * @param nickname User nickname.
+	 * @param password User password.
+	 * @return True if the user was added, otherwise false.
+	 */
+	bool applySignup(const std::string& firstName, const std::string& lastName, const std::string& nickname, const std::string& password);
+
+	/**
+	 * @brief Changes a personal field of a user.
+	 * @param userId User ID.
+	 * @param field The field to change.
+	 * @param value The new value.
+	 * @return True if the field was changed, otherwise false.
+	 */
+	bool applyEditUser(unsigned int userId, UserField field, const std::string& value);
+
+	/**
+	 * @brief Changes the role of a user.
+	 * @param userId User ID.
+	 * @param role The new role.
+	 * @return True if the role was changed, otherwise false.
+	 */
+	bool applySetRole(unsigned int userId, Permission role);
+
+	/**
+	 * @brief Adds a new topic.
+	 * @param topicTitle Topic title.
+	 * @param description Topic description.
+	 * @param creatorId Topic creator ID.
+	 * @return True if the topic was added, otherwise false.
+	 */
+	bool applyCreateTopic(const std::string& topicTitle, const std::string& description, unsigned int creatorId);
+
+	/**
+	 * @brief Removes a topic.
+	 * @param topicId Topic ID.
+	 * @return True if the topic was removed, otherwise false.
+	 */
+	bool applyRemoveTopic(unsigned int topicId);
+
+	/**
+	 * @brief Adds a new discussion to a topic.
+	 * @param topicId Topic ID.
+	 * @param discussionTitle Discussion title.
+	 * @param discussionContents Discussion content.
+	 * @param creatorId Discussion creator ID.
+	 * @return True if the discussion was added, otherwise false.
+	 */
+	bool applyPostDiscussion(unsigned int topicId, const std::string& discussionTitle, const std::string& discussionContents, unsigned int creatorId);
+
+	/**
+	 * @brief Removes a discussion from a topic.
+	 * @param topicId Topic ID.
+	 * @param discussionId Discussion ID.
+	 * @return True if the discussion was removed, otherwise false.
+	 */
+	bool applyRemoveDiscussion(unsigned int topicId, unsigned int discussionId);
+
+	/**
+	 * @brief Adds a comment to a discussion.
+	 * @param topicId Topic ID.
+	 * @param discussionId Discussion ID.
+	 * @param authorId Comment author ID.
+	 * @param text Comment text.
+	 * @return True if the comment was added, otherwise false.
+	 */
+	bool applyAddComment(unsigned int topicId, unsigned int discussionId, unsigned int authorId, const std::string& text);
+
+	/**
+	 * @brief Adds a reply to a comment.
+	 * @param topicId Topic ID.
+	 * @param discussionId Discussion ID.
+	 * @param commentId Comment ID.
+	 * @param authorId Reply author ID.
+	 * @param text Reply text.
+	 * @return True if the reply was added, otherwise false.
+	 */
+	bool applyAddReply(unsigned int topicId, unsigned int discussionId, unsigned int commentId, unsigned int authorId, const std::string& text);
+
+	/**
+	 * @brief Votes for a comment.
+	 * @param topicId Topic ID.
+	 * @param discussionId Discussion ID.
+	 * @param commentId Comment ID.
+	 * @param userId ID of the voting user.
+	 * @param upvote True for an upvote, false for a downvote.
+	 * @return True if the vote was counted, false if the comment does not exist or the user already voted.
+	 */
+	bool applyCommentVote(unsigned int topicId, unsigned int discussionId, unsigned int commentId, unsigned int userId, bool upvote);
+
+	/**
+	 * @brief Removes a comment from a discussion.
+	 * @param topicId Topic ID.
+	 * @param discussionId Discussion ID.
+	 * @param commentId Comment ID.
+	 * @return True if the comment was removed, otherwise false.
+	 */
+	bool applyRemoveComment(unsigned int topicId, unsigned int discussionId, unsigned int commentId);
+
 public:
 	/**
 	 * @brief Default constructor.
@@ -82,13 +365,54 @@ public:
 	/**
 	 * @brief Saves the current state of the social network to a file.
 	 */
-	void save() const;
+	void save();
 
 	/**
 	 * @brief Saves the current state of the social network to a specified file.
 	 * @param fileName File name.
 	 */
-	void saveAs(const std::string& fileName) const;
+	void saveAs(const std::string& fileName);
+
+	/**
+	 * @brief Folds the journal of the opened file into a new snapshot.
+	 */
+	void checkpoint();
+
+	/**
+	 * @brief Chooses whether snapshots are loaded lazily.
+	 * @param lazy True to load topics on first use.
+	 */
+	void setLoadMode(bool lazy);
+
+	/**
+	 * @brief Chooses whether checkpoints are written in the background.
+	 * @param background True to write checkpoints on a background thread.
+	 */
+	void setCheckpointMode(bool background);
+
+	/**
+	 * @brief Changes when journaled changes are written and synced.
+	 * @param mode Durability mode.
+	 * @param intervalMs Longest wait of a change in group mode, in milliseconds.
+	 * @param records Number of changes that triggers a group commit.
+	 */
+	void setDurability(Durability mode, unsigned int intervalMs, unsigned int records);
+
+	/**
+	 * @brief Displays the durability mode and journal latency histograms.
+	 */
+	void printJournalStats();
+
+	/**
+	 * @brief Sets how strongly texts are compressed in written snapshots.
+	 * @param level Level from 1 (fastest) to 9 (smallest), or 0 to store texts plainly.
+	 */
+	void setCompressionLevel(int level);
+
+	/**
+	 * @brief Displays the compression ratio and throughput of the last written and loaded snapshots.
+	 */
+	void printCompressionStats();
 
 	/**
 	 * @brief Creates a new topic.
@@ -98,11 +422,23 @@ public:
 	void createTopic(const std::string& topicTitle, const std::string& description);
 
 	/**
-	 * @brief Searches for a topic by part of the title and displays it if found.
-	 * @param partOfTitle Part of the topic title.
+	 * @brief Searches for topics by words of their titles and descriptions or by part of the title and displays all of them.
+	 * @param partOfTitle Words or part of the topic title.
 	 */
 	void searchTopic(const std::string& partOfTitle);
 
+	/**
+	 * @brief Searches for discussions of all topics by part of the title and displays all of them.
+	 * @param partOfTitle Part of the discussion title.
+	 */
+	void searchDiscussions(const std::string& partOfTitle);
+
+	/**
+	 * @brief Searches discussions, comments and replies by words and displays the most relevant ones.
+	 * @param query Words to search for.
+	 */
+	void searchPosts(const std::string& query);
+
 	/**
 	 * @brief Opens topic by title.
 	 * @param topicTitle Topic title.
@@ -184,7 +520,13 @@ public:
 	void removeComment(unsigned int commentId);
 
 	/**
-	 * @brief Calculates users' points.
+	 * @brief Recalculates users' points from scratch and reports how many were out of date.
+	 */
+	void rebuildUserPoints();
+
+	/**
+	 * @brief Displays every comment and reply of all topics whose text contains a given text.
+	 * @param text The text to look for.
 	 */
-	void calculateUserPoints();
+	void scanComments(const std::string& text);
 };
@@ -0,0 +1,234 @@
+﻿#include "SubstringSearch.h"
+#include <cstring>
+#if defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#define SUBSTRING_SEARCH_SSE2
+#endif
+#if defined(SUBSTRING_SEARCH_SSE2) && (defined(__GNUC__) || defined(_MSC_VER))
+#include <immintrin.h>
+#define SUBSTRING_SEARCH_AVX2
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
+#endif
+
+#if defined(__GNUC__)
+#define AVX2_TARGET __attribute__((target("avx2")))
+#else
+#define AVX2_TARGET
+#endif
+
+/**
+ * @brief A search kernel.
+ * @param text The text.
+ * @param size Size of the text.
+ * @param pattern The pattern, at least two bytes.
+ * @param patternSize Size of the pattern, not larger than the text.
+ * @return Position of the first occurrence, or std::string_view::npos if there is none.
+ */
+typedef std::size_t (*FindKernel)(const char* text, std::size_t size, const char* pattern, std::size_t patternSize);
+
+/**
+ * @brief Searches byte by byte, skipping to candidates with memchr.
+ * @param text The text.
+ * @param size Size of the text.
+ * @param pattern The pattern, at least two bytes.
+ * @param patternSize Size of the pattern, not larger than the text.
+ * @param from Position where the search starts.
+ * @return Position of the first occurrence, or std::string_view::npos if there is none.
+ */
+static std::size_t findFrom(const char* text, std::size_t size, const char* pattern, std::size_t patternSize, std::size_t from) {
+    std::size_t last = size - patternSize;
+    while (from <= last) {
+        const void* hit = std::memchr(text + from, pattern[0], last - from + 1);
+        if (hit == nullptr) {
+            break;
+        }
+        from = static_cast<const char*>(hit) - text;
+        if (std::memcmp(text + from + 1, pattern + 1, patternSize - 1) == 0) {
+            return from;
+        }
+        from++;
+    }
+    return std::string_view::npos;
+}
+
+#ifndef SUBSTRING_SEARCH_SSE2
+/**
+ * @brief Portable kernel.
+ * @param text The text.
+ * @param size Size of the text.
+ * @param pattern The pattern, at least two bytes.
+ * @param patternSize Size of the pattern, not larger than the text.
+ * @return Position of the first occurrence, or std::string_view::npos if there is none.
+ */
+static std::size_t findScalar(const char* text, std::size_t size, const char* pattern, std::size_t patternSize) {
+    return findFrom(text, size, pattern, patternSize, 0);
+}
+#endif
+
+#ifdef SUBSTRING_SEARCH_SSE2
+/**
+ * @brief Counts the trailing zero bits of a non-zero mask.
+ * @param mask The mask.
+ * @return Index of the lowest set bit.
+ */
+static unsigned int lowestBit(unsigned int mask) {
+#if defined(__GNUC__)
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#else
+    unsigned int index = 0;
+    while ((mask & 1u) == 0) {
+        mask >>= 1;
+        index++;
+    }
+    return index;
+#endif
+}
+
+/**
+ * @brief SSE2 kernel, sixteen positions per step.
+ * @param text The text.
+ * @param size Size of the text.
+ * @param pattern The pattern, at least two bytes.
+ * @param patternSize Size of the pattern, not larger than the text.
+ * @return Position of the first occurrence, or std::string_view::npos if there is none.
+ */
+static std::size_t findSse2(const char* text, std::size_t size, const char* pattern, std::size_t patternSize) {
+    const __m128i first = _mm_set1_epi8(pattern[0]);
+    const __m128i lastByte = _mm_set1_epi8(pattern[patternSize - 1]);
+    std::size_t position = 0;
+    // a step reads sixteen bytes from position and from position + patternSize - 1
+    for (; position + patternSize - 1 + 16 <= size; position += 16) {
+        __m128i blockFirst = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position));
+        __m128i blockLast = _mm_loadu_si128(reinterpret_cast<const __m128i*>(text + position + patternSize - 1));
+        unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(
+            _mm_and_si128(_mm_cmpeq_epi8(first, blockFirst), _mm_cmpeq_epi8(lastByte, blockLast))));
+        while (mask != 0) {
+            unsigned int bit = lowestBit(mask);
+            if (std::memcmp(text + position + bit + 1, pattern + 1, patternSize - 2) == 0) {
+                return position + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    return findFrom(text, size, pattern, patternSize, position);
+}
+#endif
+
+#ifdef SUBSTRING_SEARCH_AVX2
+/**
+ * @brief AVX2 kernel, thirty-two positions per step; only called when the processor supports AVX2.
+ * @param text The text.
+ * @param size Size of the text.
+ * @param pattern The pattern, at least two bytes.
+ * @param patternSize Size of the pattern, not larger than the text.
+ * @return Position of the first occurrence, or std::string_view::npos if there is none.
+ */
+AVX2_TARGET static std::size_t findAvx2(const char* text, std::size_t size, const char* pattern, std::size_t patternSize) {
+    const __m256i first = _mm256_set1_epi8(pattern[0]);
+    const __m256i lastByte = _mm256_set1_epi8(pattern[patternSize - 1]);
+    std::size_t position = 0;
+    for (; position + patternSize - 1 + 32 <= size; position += 32) {
+        __m256i blockFirst = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + position));
+        __m256i blockLast = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(text + position + patternSize - 1));
+        unsigned int mask = static_cast<unsigned int>(_mm256_movemask_epi8(
+            _mm256_and_si256(_mm256_cmpeq_epi8(first, blockFirst), _mm256_cmpeq_epi8(lastByte, blockLast))));
+        while (mask != 0) {
+            unsigned int bit = lowestBit(mask);
+            if (std::memcmp(text + position + bit + 1, pattern + 1, patternSize - 2) == 0) {
+                return position + bit;
+            }
+            mask &= mask - 1;
+        }
+    }
+    if (size - position < patternSize) {
+        return std::string_view::npos;
+    }
+    std::size_t rest = findSse2(text + position, size - position, pattern, patternSize);
+    return rest == std::string_view::npos ? rest : position + rest;
+}
+
+/**
+ * @brief Checks whether the processor and the operating system support AVX2.
+ * @return True if AVX2 instructions can be used, otherwise false.
+ */
+static bool hasAvx2() {
+#if defined(__GNUC__)
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    int info[4];
+    __cpuid(info, 0);
+    if (info[0] < 7) {
+        return false;
+    }
+    __cpuid(info, 1);
+    // OSXSAVE and AVX, and the operating system saves the YMM registers
+    if ((info[2] & (1 << 27)) == 0 || (info[2] & (1 << 28)) == 0 || (_xgetbv(0) & 6) != 6) {
+        return false;
+    }
+    __cpuidex(info, 7, 0);
+    return (info[1] & (1 << 5)) != 0;
+#endif
+}
+#endif
+
+/**
+ * @brief Chooses the widest kernel the processor supports.
+ * @return The kernel.
+ */
+static FindKernel chooseKernel() {
+#ifdef SUBSTRING_SEARCH_AVX2
+    if (hasAvx2()) {
+        return findAvx2;
+    }
+#endif
+#ifdef SUBSTRING_SEARCH_SSE2
+    return findSse2;
+#else
+    return findScalar;
+#endif
+}
+
+/**
+ * @brief Returns the kernel in use, chosen on first use.
+ * @return The kernel.
+ */
+static FindKernel kernelChoice() {
+    static const FindKernel kernel = chooseKernel();
+    return kernel;
+}
+
+/**
+ * @brief Finds the first occurrence of a pattern in a text.
+ *
+ * Patterns of one byte are left to memchr, which is vectorised by the C library.
+ *
+ * @param text The text.
+ * @param pattern The pattern; an empty one is found at the start.
+ * @return Position of the first occurrence, or std::string_view::npos if there is none.
+ */
+std::size_t SubstringSearch::find(std::string_view text, std::string_view pattern) {
+    if (pattern.empty()) {
+        return 0;
+    }
+    if (pattern.size() > text.size()) {
+        return std::string_view::npos;
+    }
+    if (pattern.size() == 1) {
+        const void* hit = std::memchr(text.data(), pattern[0], text.size());
+        return hit == nullptr ? std::string_view::npos : static_cast<std::size_t>(static_cast<const char*>(hit) - text.data());
+    }
+    return kernelChoice()(text.data(), text.size(), pattern.data(), pattern.size());
+}
+
+/**
+ * @brief Checks whether a text contains a pattern.
+ * @param text The text.
+ * @param pattern The pattern.
+ * @return True if the pattern occurs in the text, otherwise false.
+ */
+bool SubstringSearch::contains(std::string_view text, std::string_view pattern) {
+    return find(text, pattern) != std::string_view::npos;
+}
@@ -0,0 +1,31 @@
+﻿#pragma once
+#include <cstddef>
+#include <string_view>
+
+/**
+ * @class SubstringSearch
+ * @brief Exact substring search for the scans that no index can answer.
+ *
+ * Blocks of the text are compared at once with the first and the last byte of the pattern,
+ * and only positions where both match are compared in full, so most of the text is skipped
+ * sixteen or thirty-two bytes at a time. The widest kernel the processor supports is chosen
+ * on first use: AVX2, SSE2, or a portable byte-wise loop.
+ */
+class SubstringSearch {
+public:
+    /**
+     * @brief Finds the first occurrence of a pattern in a text.
+     * @param text The text.
+     * @param pattern The pattern; an empty one is found at the start.
+     * @return Position of the first occurrence, or std::string_view::npos if there is none.
+     */
+    static std::size_t find(std::string_view text, std::string_view pattern);
+
+    /**
+     * @brief Checks whether a text contains a pattern.
+     * @param text The text.
+     * @param pattern The pattern.
+     * @return True if the pattern occurs in the text, otherwise false.
+     */
+    static bool contains(std::string_view text, std::string_view pattern);
+};
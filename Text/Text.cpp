@@ -0,0 +1,71 @@
+﻿#include "Text.h"
+
+/**
+ * @brief Default constructor, creates an empty owned text.
+ */
+Text::Text() : borrowedData(nullptr), borrowedSize(0), borrowed(false) {  }
+
+/**
+ * @brief Constructor that copies the given string.
+ * @param str The string to be copied.
+ */
+Text::Text(const std::string& str) : owned(str), borrowedData(nullptr), borrowedSize(0), borrowed(false) {  }
+
+/**
+ * @brief Creates a text that borrows characters it does not own.
+ * @param data Pointer to the first character.
+ * @param size Number of characters.
+ * @return Borrowed text.
+ */
+Text Text::borrow(const char* data, std::size_t size) {
+    Text text;
+    text.borrowedData = data;
+    text.borrowedSize = size;
+    text.borrowed = true;
+    return text;
+}
+
+/**
+ * @brief Replaces the text with an owned copy of the given string.
+ * @param str The new contents.
+ * @return Reference to this text.
+ */
+Text& Text::operator=(const std::string& str) {
+    owned = str;
+    borrowedData = nullptr;
+    borrowedSize = 0;
+    borrowed = false;
+    return *this;
+}
+
+/**
+ * @brief Returns a view of the characters.
+ * @return View of the text.
+ */
+std::string_view Text::view() const {
+    if (borrowed) {
+        return std::string_view(borrowedData, borrowedSize);
+    }
+    return std::string_view(owned);
+}
+
+/**
+ * @brief Returns the number of characters.
+ * @return Size of the text.
+ */
+std::size_t Text::size() const {
+    return borrowed ? borrowedSize : owned.size();
+}
+
+/**
+ * @brief Copies borrowed characters into owned storage, so the text outlives the mapping.
+ */
+void Text::detach() {
+    if (!borrowed) {
+        return;
+    }
+    owned.assign(borrowedData, borrowedSize);
+    borrowedData = nullptr;
+    borrowedSize = 0;
+    borrowed = false;
+}
@@ -0,0 +1,62 @@
+﻿#pragma once
+#include <string>
+#include <string_view>
+
+/**
+ * @class Text
+ * @brief A string that either owns its characters or borrows them from a memory-mapped snapshot.
+ *
+ * Text loaded from a snapshot points straight into the mapping, so loading does not copy it.
+ * Any modification turns the text into an owned copy.
+ */
+class Text {
+private:
+    std::string owned; /**< Owned characters, used when the text is not borrowed. */
+    const char* borrowedData; /**< Borrowed characters inside a mapping. */
+    std::size_t borrowedSize; /**< Number of borrowed characters. */
+    bool borrowed; /**< Whether the text currently borrows its characters. */
+
+public:
+    /**
+     * @brief Default constructor, creates an empty owned text.
+     */
+    Text();
+
+    /**
+     * @brief Constructor that copies the given string.
+     * @param str The string to be copied.
+     */
+    Text(const std::string& str);
+
+    /**
+     * @brief Creates a text that borrows characters it does not own.
+     * @param data Pointer to the first character.
+     * @param size Number of characters.
+     * @return Borrowed text.
+     */
+    static Text borrow(const char* data, std::size_t size);
+
+    /**
+     * @brief Replaces the text with an owned copy of the given string.
+     * @param str The new contents.
+     * @return Reference to this text.
+     */
+    Text& operator=(const std::string& str);
+
+    /**
+     * @brief Returns a view of the characters.
+     * @return View of the text.
+     */
+    std::string_view view() const;
+
+    /**
+     * @brief Returns the number of characters.
+     * @return Size of the text.
+     */
+    std::size_t size() const;
+
+    /**
+     * @brief Copies borrowed characters into owned storage, so the text outlives the mapping.
+     */
+    void detach();
+};
@@ -0,0 +1,126 @@
+﻿#include "TextArena.h"
+#include <algorithm>
+#include <cstring>
+#include <functional>
+
+/**
+ * @brief Orders chunks by their start address.
+ * @param a A chunk.
+ * @param b Another chunk.
+ * @return True if a starts before b, otherwise false.
+ */
+static bool startsBefore(const std::pair<const char*, std::size_t>& a, const std::pair<const char*, std::size_t>& b) {
+    return std::less<const char*>()(a.first, b.first);
+}
+
+/**
+ * @brief Default constructor, creates an empty arena without allocating.
+ */
+TextArena::TextArena() : chunkUsed(0), bytesStored(0), bytesReserved(0) {  }
+
+/**
+ * @brief Move constructor, takes over the chunks; texts stored in them stay valid.
+ * @param other The arena whose chunks will be taken over; it is left empty.
+ */
+TextArena::TextArena(TextArena&& other) noexcept : chunks(std::move(other.chunks)), chunksByAddress(std::move(other.chunksByAddress)),
+    chunkUsed(other.chunkUsed), bytesStored(other.bytesStored), bytesReserved(other.bytesReserved) {
+    other.chunks.clear();
+    other.chunksByAddress.clear();
+    other.chunkUsed = other.bytesStored = other.bytesReserved = 0;
+}
+
+/**
+ * @brief Move assignment operator, frees the own chunks and takes over the other ones.
+ * @param other The arena whose chunks will be taken over; it is left empty.
+ * @return Reference to this arena.
+ */
+TextArena& TextArena::operator=(TextArena&& other) noexcept {
+    if (this != &other) {
+        chunks = std::move(other.chunks);
+        chunksByAddress = std::move(other.chunksByAddress);
+        chunkUsed = other.chunkUsed;
+        bytesStored = other.bytesStored;
+        bytesReserved = other.bytesReserved;
+        other.chunks.clear();
+        other.chunksByAddress.clear();
+        other.chunkUsed = other.bytesStored = other.bytesReserved = 0;
+    }
+    return *this;
+}
+
+/**
+ * @brief Copies a text into the arena.
+ *
+ * A text that does not fit into the rest of the last chunk starts a new chunk twice the size
+ * of the last one, or just large enough for the text if that is more.
+ *
+ * @param text The text.
+ * @return View of the stored copy.
+ */
+std::string_view TextArena::store(std::string_view text) {
+    if (text.empty()) {
+        return std::string_view();
+    }
+    if (chunks.empty() || chunks.back().size - chunkUsed < text.size()) {
+        std::size_t size = chunks.empty() ? FIRST_CHUNK_SIZE : chunks.back().size * 2;
+        if (size > MAX_CHUNK_SIZE) {
+            size = MAX_CHUNK_SIZE;
+        }
+        if (size < text.size()) {
+            size = text.size();
+        }
+        chunks.push_back(Chunk{ std::unique_ptr<char[]>(new char[size]), size });
+        std::pair<const char*, std::size_t> range(chunks.back().data.get(), size);
+        chunksByAddress.insert(std::upper_bound(chunksByAddress.begin(), chunksByAddress.end(), range, startsBefore), range);
+        chunkUsed = 0;
+        bytesReserved += size;
+    }
+    char* dest = chunks.back().data.get() + chunkUsed;
+    std::memcpy(dest, text.data(), text.size());
+    chunkUsed += text.size();
+    bytesStored += text.size();
+    return std::string_view(dest, text.size());
+}
+
+/**
+ * @brief Checks whether characters are stored in the arena.
+ *
+ * The last chunk starting at or before the characters is the only one that can hold them.
+ *
+ * @param data Pointer to the first character.
+ * @return True if the characters are inside one of the chunks, otherwise false.
+ */
+bool TextArena::owns(const char* data) const {
+    std::pair<const char*, std::size_t> key(data, 0);
+    auto next = std::upper_bound(chunksByAddress.begin(), chunksByAddress.end(), key, startsBefore);
+    if (next == chunksByAddress.begin()) {
+        return false;
+    }
+    --next;
+    return std::less<const char*>()(data, next->first + next->second);
+}
+
+/**
+ * @brief Frees all chunks, every stored text becomes invalid.
+ */
+void TextArena::clear() {
+    chunks.clear();
+    chunksByAddress.clear();
+    chunkUsed = bytesStored = bytesReserved = 0;
+}
+
+/**
+ * @brief Returns the number of bytes stored so far.
+ * @return Number of bytes.
+ */
+std::size_t TextArena::getBytesStored() const {
+    return bytesStored;
+}
+
+/**
+ * @brief Returns the size of all chunks together.
+ * @return Number of bytes.
+ */
+std::size_t TextArena::getBytesReserved() const {
+    return bytesReserved;
+}
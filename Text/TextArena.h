@@ -0,0 +1,87 @@
+﻿#pragma once
+#include <cstddef>
+#include <memory>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+/**
+ * @class TextArena
+ * @brief Monotonic storage for the texts of a discussion.
+ *
+ * Texts are copied back to back into chunks that double in size, so a thousand comments
+ * take a handful of allocations instead of one each, and freeing the arena frees them all.
+ * Stored texts never move; they stay valid until the arena is cleared or destroyed.
+ */
+class TextArena {
+private:
+    static const std::size_t FIRST_CHUNK_SIZE = 256; /**< Size of the first chunk, small discussions stay small. */
+    static const std::size_t MAX_CHUNK_SIZE = 1u << 16; /**< Chunks stop doubling at this size. */
+
+    /**
+     * @brief A block of memory holding texts.
+     */
+    struct Chunk {
+        std::unique_ptr<char[]> data; /**< The characters. */
+        std::size_t size; /**< Size of the block. */
+    };
+
+    std::vector<Chunk> chunks; /**< All chunks, the last one is being filled. */
+    std::vector<std::pair<const char*, std::size_t>> chunksByAddress; /**< Start and size of every chunk in ascending order, for owns. */
+    std::size_t chunkUsed; /**< Number of bytes used in the last chunk. */
+    std::size_t bytesStored; /**< Number of bytes stored in all chunks. */
+    std::size_t bytesReserved; /**< Size of all chunks together. */
+
+public:
+    /**
+     * @brief Default constructor, creates an empty arena without allocating.
+     */
+    TextArena();
+
+    TextArena(const TextArena& other) = delete;
+    TextArena& operator=(const TextArena& other) = delete;
+
+    /**
+     * @brief Move constructor, takes over the chunks; texts stored in them stay valid.
+     * @param other The arena whose chunks will be taken over; it is left empty.
+     */
+    TextArena(TextArena&& other) noexcept;
+
+    /**
+     * @brief Move assignment operator, frees the own chunks and takes over the other ones.
+     * @param other The arena whose chunks will be taken over; it is left empty.
+     * @return Reference to this arena.
+     */
+    TextArena& operator=(TextArena&& other) noexcept;
+
+    /**
+     * @brief Copies a text into the arena.
+     * @param text The text.
+     * @return View of the stored copy.
+     */
+    std::string_view store(std::string_view text);
+
+    /**
+     * @brief Checks whether characters are stored in the arena.
+     * @param data Pointer to the first character.
+     * @return True if the characters are inside one of the chunks, otherwise false.
+     */
+    bool owns(const char* data) const;
+
+    /**
+     * @brief Frees all chunks, every stored text becomes invalid.
+     */
+    void clear();
+
+    /**
+     * @brief Returns the number of bytes stored so far.
+     * @return Number of bytes.
+     */
+    std::size_t getBytesStored() const;
+
+    /**
+     * @brief Returns the size of all chunks together.
+     * @return Number of bytes.
+     */
+    std::size_t getBytesReserved() const;
+};
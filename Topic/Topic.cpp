@@ -11,33 +11,115 @@ unsigned int Topic::topicID = 0;
  * @param other The topic from which data will be copied.
  */
 void Topic::copyFrom(const Topic& other) {
-    setTopicTitle(other.title);
-    setTopicDescription(other.topicDescription);
+    title = other.title;
+    topicDescription = other.topicDescription;
     setCreatorId(other.creatorId);
     id = other.id;
 
     discussionCapacity = other.discussionCapacity;
     discussionNum = other.discussionNum;
+    removedDiscussionNum = other.removedDiscussionNum;
+    removedDiscussions = other.removedDiscussions;
     discussions = new Discussion[discussionCapacity];
     for (size_t i = 0; i < discussionNum && i < discussionCapacity; i++) {
         discussions[i] = other.discussions[i];
     }
     discussionID = other.discussionID;
+    discussionSlots = other.discussionSlots;
+    source = other.source;
+    firstDiscussion = other.firstDiscussion;
+}
+
+/**
+ * @brief Takes over the data of another topic, leaving it empty.
+ *
+ * @param other The topic whose data will be taken over.
+ */
+void Topic::moveFrom(Topic& other) noexcept {
+    title = std::move(other.title);
+    topicDescription = std::move(other.topicDescription);
+    creatorId = other.creatorId;
+    id = other.id;
+
+    discussions = other.discussions;
+    discussionCapacity = other.discussionCapacity;
+    discussionNum = other.discussionNum;
+    removedDiscussionNum = other.removedDiscussionNum;
+    removedDiscussions = std::move(other.removedDiscussions);
+    discussionID = other.discussionID;
+    discussionSlots = std::move(other.discussionSlots);
+    source = other.source;
+    firstDiscussion = other.firstDiscussion;
+    other.discussions = nullptr;
+    other.discussionCapacity = 0;
+    other.discussionNum = 0;
+    other.removedDiscussionNum = 0;
+    other.removedDiscussions.clear();
+    other.source = nullptr;
 }
 
 /**
  * @brief Increases the capacity of the discussion array.
+ *
+ * Discussions are moved, so only their comment array pointers change hands, not the comments.
  */
 void Topic::resizeDiscussions() {
     discussionCapacity *= 2;
     Discussion* newArr = new Discussion[discussionCapacity];
     for (size_t i = 0; i < discussionNum; i++) {
-        newArr[i] = discussions[i];
+        newArr[i] = std::move(discussions[i]);
     }
     delete[] discussions;
     discussions = newArr;
 }
 
+/**
+ * @brief Rebuilds the discussion index from the discussion array.
+ *
+ * Discussions used to be numbered by their position, so older files may hold the same ID
+ * twice after a removal; all but the first of them get fresh IDs.
+ */
+void Topic::indexDiscussions() {
+    discussionSlots.clear();
+    discussionSlots.reserve(discussionNum);
+    for (unsigned int i = 0; i < discussionNum; i++) {
+        if (discussions[i].getDiscussionId() >= discussionID) {
+            discussionID = discussions[i].getDiscussionId() + 1;
+        }
+    }
+    for (unsigned int i = 0; i < discussionNum; i++) {
+        if (!discussionSlots.insert(discussions[i].getDiscussionId(), i)) {
+            discussions[i].setDiscussionId(discussionID++);
+            discussionSlots.insert(discussions[i].getDiscussionId(), i);
+        }
+    }
+}
+
+/**
+ * @brief Moves the discussions that were not removed over the slots of removed ones.
+ *
+ * Discussions keep their order and IDs; the index entries of the moved ones are updated.
+ */
+void Topic::compactDiscussions() {
+    unsigned int kept = 0;
+    for (unsigned int i = 0; i < discussionNum; i++) {
+        if (removedDiscussions[i]) {
+            continue;
+        }
+        if (kept != i) {
+            discussions[kept] = std::move(discussions[i]);
+            discussionSlots.update(discussions[kept].getDiscussionId(), kept);
+        }
+        kept++;
+    }
+    for (unsigned int i = kept; i < discussionNum; i++) {
+        discussions[i] = Discussion();
+    }
+    discussionNum = kept;
+    removedDiscussionNum = 0;
+    removedDiscussions.assign(discussionNum, false);
+}
+
 /**
  * @brief Constructor for initializing a topic with a given title, description, and creator ID.
  *
@@ -53,13 +135,17 @@ Topic::Topic(const std::string& title, const std::string& description, unsigned
 
     discussions = new Discussion[discussionCapacity];
     discussionNum = 0;
+    removedDiscussionNum = 0;
     discussionID = 0;
+    source = nullptr;
+    firstDiscussion = 0;
 }
 
 /**
  * @brief Default constructor for the Topic class.
  */
-Topic::Topic() : title(""), topicDescription(""), creatorId(0), id(0), discussionCapacity(2), discussionNum(0), discussionID(0) {
+Topic::Topic() : title(""), topicDescription(""), creatorId(0), id(0), discussionCapacity(2), discussionNum(0), removedDiscussionNum(0), discussionID(0),
+    source(nullptr), firstDiscussion(0) {
     discussions = new Discussion[discussionCapacity];
 }
 
@@ -72,6 +158,15 @@ Topic::Topic(const Topic& other) {
     copyFrom(other);
 }
 
+/**
+ * @brief Move constructor for the Topic class, takes over the discussion array.
+ *
+ * @param other The topic to be moved; it is left empty and may only be assigned to or destroyed.
+ */
+Topic::Topic(Topic&& other) noexcept {
+    moveFrom(other);
+}
+
 /**
  * @brief Assignment operator for the Topic class.
  *
@@ -86,6 +181,20 @@ Topic& Topic::operator=(const Topic& other) {
     return *this;
 }
 
+/**
+ * @brief Move assignment operator for the Topic class.
+ *
+ * @param other The topic to be moved; it is left empty and may only be assigned to or destroyed.
+ * @return Reference to the assigned topic.
+ */
+Topic& Topic::operator=(Topic&& other) noexcept {
+    if (this != &other) {
+        delete[] discussions;
+        moveFrom(other);
+    }
+    return *this;
+}
+
 /**
  * @brief Destructor for the Topic class.
  */
@@ -99,7 +208,6 @@ Topic::~Topic() {
  * @param newTitle The new topic title.
  */
 void Topic::setTopicTitle(const std::string& newTitle) {
-    title.resize(newTitle.size());
     title = newTitle;
 }
 
@@ -109,7 +217,6 @@ void Topic::setTopicTitle(const std::string& newTitle) {
  * @param newDescription The new topic description.
  */
 void Topic::setTopicDescription(const std::string& newDescription) {
-    topicDescription.resize(newDescription.size());
     topicDescription = newDescription;
 }
 
@@ -123,9 +230,19 @@ void Topic::setCreatorId(unsigned int id) {
 }
 
 /**
- * @brief Increases the number of discussions in the topic by one.
+ * @brief Adds a new discussion to the topic under the next discussion ID.
+ *
+ * The topic must be loaded, see isLoaded.
+ *
+ * @param discussionTitle Discussion title.
+ * @param discussionContents Discussion content.
+ * @param creatorId Discussion creator ID.
  */
-void Topic::discussionNumIncrement() {
+void Topic::addDiscussion(const std::string& discussionTitle, const std::string& discussionContents, unsigned int creatorId) {
+    discussions[discussionNum] = Discussion(discussionTitle, discussionContents, creatorId, discussionID);
+    discussionSlots.insert(discussionID, discussionNum);
+    removedDiscussions.push_back(false);
+    discussionID++;
     discussionNum++;
     if (discussionNum >= discussionCapacity) {
         resizeDiscussions();
@@ -133,28 +250,46 @@ void Topic::discussionNumIncrement() {
 }
 
 /**
- * @brief Decreases the number of discussions in the topic by one.
+ * @brief Removes a discussion from the topic.
+ *
+ * The discussion is freed and its slot marked as removed, so the discussions after it stay
+ * where they are. The slots are left empty and reclaimed once removed discussions fill half of the array.
+ * The topic must be loaded, see isLoaded.
+ *
+ * @param discussionId Discussion ID.
+ * @return True if the discussion was removed, false if there is no such discussion.
  */
-void Topic::discussionNumDecrement() {
-    discussionNum--;
+bool Topic::removeDiscussion(unsigned int discussionId) {
+    int slot = findDiscussion(discussionId);
+    if (slot < 0) {
+        return false;
+    }
+    discussionSlots.erase(discussionId);
+    discussions[slot] = Discussion();
+    removedDiscussions[slot] = true;
+    removedDiscussionNum++;
+    if (removedDiscussionNum * 2 > discussionNum) {
+        compactDiscussions();
+    }
+    return true;
 }
 
 /**
  * @brief Returns the topic title.
  *
- * @return Topic title.
+ * @return View of the topic title, valid until the title is changed.
  */
-std::string Topic::getTopicTitle() const {
-    return title;
+std::string_view Topic::getTopicTitle() const {
+    return title.view();
 }
 
 /**
  * @brief Returns the topic description.
  *
- * @return Topic description.
+ * @return View of the topic description, valid until the description is changed.
  */
-std::string Topic::getTopicDescription() const {
-    return topicDescription;
+std::string_view Topic::getTopicDescription() const {
+    return topicDescription.view();
 }
 
 /**
@@ -181,7 +316,7 @@ unsigned int Topic::getTopicId() const {
  * @return Number of discussions in the topic.
  */
 unsigned int Topic::getDiscussionNum() const {
-    return discussionNum;
+    return discussionNum - removedDiscussionNum;
 }
 
 /**
@@ -196,6 +331,8 @@ unsigned int Topic::getDiscussionID() const {
 /**
  * @brief Returns a pointer to the array of discussions in the topic.
  *
+ * Removed discussions leave empty slots, see forEachDiscussion. The topic must be loaded, see isLoaded.
+ *
  * @return Pointer to the array of discussions in the topic.
  */
 Discussion* Topic::getTopicDiscussions() const {
@@ -203,54 +340,165 @@ Discussion* Topic::getTopicDiscussions() const {
 }
 
 /**
- * @brief Saves the topic data to a file.
+ * @brief Looks up a discussion by ID.
  *
- * @param of Output file stream.
+ * The topic must be loaded, see isLoaded.
+ *
+ * @param discussionId Discussion ID.
+ * @return Index of the discussion in the discussions array, or -1 if there is no such discussion.
  */
-void Topic::writeToFile(std::ofstream& of) {
-    unsigned int size = title.size();
-    of.write(reinterpret_cast<const char*>(&size), sizeof(size));
-    of.write((const char*)&title[0], size);
-
-    size = topicDescription.size();
-    of.write(reinterpret_cast<const char*>(&size), sizeof(size));
-    of.write((const char*)&topicDescription[0], size);
-
-    of.write(reinterpret_cast<const char*>(&creatorId), sizeof(creatorId));
-    of.write(reinterpret_cast<const char*>(&id), sizeof(id));
+int Topic::findDiscussion(unsigned int discussionId) const {
+    return discussionSlots.find(discussionId);
+}
 
-    // Saves discussion data
-    of.write(reinterpret_cast<const char*>(&discussionNum), sizeof(discussionNum));
-    of.write(reinterpret_cast<const char*>(&discussionID), sizeof(discussionID));
+/**
+ * @brief Reads topic data from a file, discussions included.
+ *
+ * @param reader Binary reader.
+ */
+void Topic::readFromFile(BinaryReader& reader) {
+    schema(reader, *this);
+    topicID = id + 1;
+}
 
-    // Saves information about discussions...
+/**
+ * @brief Fills a reserved topic record of a snapshot, discussions included.
+ *
+ * A topic that was never opened still has its discussions in the loaded snapshot; if they
+ * cannot be read from there the topic is not written, so the snapshot is not saved half empty.
+ *
+ * @param writer Snapshot writer.
+ * @param index Index of the reserved topic record.
+ * @return True if the topic was written, false if its discussions could not be read from the loaded snapshot.
+ */
+bool Topic::writeToSnapshot(SnapshotWriter& writer, std::uint32_t index) const {
+    SnapshotTopicRecord record{};
+    record.title = writer.addString(title.view());
+    record.description = writer.addString(topicDescription.view());
+    record.creatorId = creatorId;
+    record.id = id;
+    record.discussionID = discussionID;
+    record.discussionNum = getDiscussionNum();
+    record.firstDiscussion = writer.reserveDiscussions(record.discussionNum);
+    if (source != nullptr) {
+        // a topic that was never opened is passed through one discussion at a time
+        const SnapshotDiscussionRecord* discussionRecords = source->getDiscussions(firstDiscussion, discussionNum);
+        if (discussionRecords == nullptr) {
+            return false;
+        }
+        for (std::uint32_t i = 0; i < discussionNum; i++) {
+            Discussion discussion;
+            if (!discussion.readFromSnapshot(*source, discussionRecords[i])) {
+                return false;
+            }
+            discussion.writeToSnapshot(writer, record.firstDiscussion + i);
+        }
+    }
+    else {
+        std::uint32_t recordIndex = record.firstDiscussion;
+        for (std::uint32_t i = 0; i < discussionNum; i++) {
+            if (!removedDiscussions[i]) {
+                discussions[i].writeToSnapshot(writer, recordIndex++);
+            }
+        }
+    }
+    writer.topicAt(index) = record;
+    return true;
 }
 
 /**
- * @brief Reads topic data from a file.
+ * @brief Reads the topic and its discussions from a snapshot record.
+ *
+ * Topics are independent of each other and may be read on several threads at once,
+ * so the identifier counter is left to setNextTopicId.
+ * In lazy mode the topic keeps the reader and the position of its discussion records;
+ * the reader must stay open until the discussions are loaded or the topic is destroyed.
  *
- * @param iff Input file stream.
+ * @param reader Snapshot reader.
+ * @param record The topic record.
+ * @param lazy Whether only the topic header is read, leaving the discussions for loadDiscussions.
+ * @return True if the record is valid, otherwise false.
  */
-void Topic::readFromFile(std::ifstream& iff) {
-    unsigned int size = 0;
-    iff.read(reinterpret_cast<char*>(&size), sizeof(size));
-    title.resize(size);
-    iff.read(&title[0], size);
+bool Topic::readFromSnapshot(const SnapshotReader& reader, const SnapshotTopicRecord& record, bool lazy) {
+    std::string_view titleView, descriptionView;
+    const SnapshotDiscussionRecord* discussionRecords = reader.getDiscussions(record.firstDiscussion, record.discussionNum);
+    if (!reader.getString(record.title, titleView) || !reader.getString(record.description, descriptionView) || discussionRecords == nullptr) {
+        return false;
+    }
+    title = Text::borrow(titleView.data(), titleView.size());
+    topicDescription = Text::borrow(descriptionView.data(), descriptionView.size());
+    creatorId = record.creatorId;
+    id = record.id;
+    discussionID = record.discussionID;
+
+    discussionNum = record.discussionNum;
+    removedDiscussionNum = 0;
+    removedDiscussions.clear();
+    source = &reader;
+    firstDiscussion = record.firstDiscussion;
+    return lazy || loadDiscussions();
+}
 
-    iff.read(reinterpret_cast<char*>(&size), sizeof(size));
-    topicDescription.resize(size);
-    iff.read((char*)&topicDescription[0], size);
+/**
+ * @brief Sets the identifier given to the next new topic.
+ *
+ * @param nextId Identifier of the next topic.
+ */
+void Topic::setNextTopicId(unsigned int nextId) {
+    topicID = nextId;
+}
 
-    iff.read(reinterpret_cast<char*>(&creatorId), sizeof(creatorId));
-    iff.read(reinterpret_cast<char*>(&id), sizeof(id));
+/**
+ * @brief Checks whether the discussions of the topic are in memory.
+ *
+ * @return True if the discussions are loaded, otherwise false.
+ */
+bool Topic::isLoaded() const {
+    return source == nullptr;
+}
 
-    iff.read(reinterpret_cast<char*>(&discussionNum), sizeof(discussionNum));
-    iff.read(reinterpret_cast<char*>(&discussionID), sizeof(discussionID));
+/**
+ * @brief Reads the discussions of a lazily loaded topic from its snapshot.
+ *
+ * A topic whose data turns out to be damaged is left without discussions.
+ *
+ * @return True if the discussions were loaded, false if the snapshot data is damaged.
+ */
+bool Topic::loadDiscussions() {
+    if (source == nullptr) {
+        return true;
+    }
+    const SnapshotReader& reader = *source;
+    source = nullptr;
 
-    topicID = id + 1;
+    // the array is allocated once at its final size instead of being doubled
+    delete[] discussions;
+    discussionCapacity = discussionNum < 2 ? 2 : discussionNum + 1;
+    discussions = new Discussion[discussionCapacity];
+    removedDiscussions.assign(discussionNum, false);
+    const SnapshotDiscussionRecord* discussionRecords = reader.getDiscussions(firstDiscussion, discussionNum);
+    for (unsigned int i = 0; i < discussionNum; i++) {
+        if (!discussions[i].readFromSnapshot(reader, discussionRecords[i])) {
+            discussionNum = 0;
+            removedDiscussions.clear();
+            discussionSlots.clear();
+            return false;
+        }
+    }
+    indexDiscussions();
+    return true;
+}
 
-    while (discussionCapacity <= discussionNum) {
-        resizeDiscussions();
+/**
+ * @brief Copies text borrowed from a snapshot into owned storage, discussions included.
+ *
+ * A lazily loaded topic is loaded first, so it no longer needs the snapshot.
+ */
+void Topic::detachText() {
+    loadDiscussions();
+    title.detach();
+    topicDescription.detach();
+    for (unsigned int i = 0; i < discussionNum; i++) {
+        discussions[i].detachText();
     }
-    // Read information about discussions...
 }
@@ -6,15 +6,21 @@
  */
 class Topic {
 private:
-    std::string title; /**< Topic title. */
-    std::string topicDescription; /**< Topic description. */
+    Text title; /**< Topic title. */
+    Text topicDescription; /**< Topic description. */
     unsigned int creatorId; /**< Topic creator ID. */
     unsigned int id; /**< Unique topic identifier. */
 
     Discussion* discussions; /**< Array of discussions related to the topic. */
     unsigned int discussionCapacity; /**< Discussion array capacity. */
-    unsigned int discussionNum; /**< Number of discussions in the topic. */
+    unsigned int discussionNum; /**< Number of used slots of the discussion array, removed discussions included. */
+    unsigned int removedDiscussionNum; /**< Number of removed discussions whose slots are still in the array. */
+    std::vector<bool> removedDiscussions; /**< Whether the discussion of every used slot was removed, filled when the discussions are loaded. */
     unsigned int discussionID; /**< Unique identifier for each discussion. */
+    IdIndex discussionSlots; /**< Slot of every discussion in the array by discussion ID, built when the discussions are loaded. */
+
+    const SnapshotReader* source; /**< Snapshot still holding the discussions of a lazily loaded topic, nullptr once they are loaded. */
+    std::uint32_t firstDiscussion; /**< Index of the first discussion record of the topic in the source snapshot. */
 
     static unsigned int topicID; /**< Static variable for a unique identifier for each topic. */
 
@@ -25,11 +31,28 @@ private:
      */
     void copyFrom(const Topic& other);
 
+    /**
+     * @brief Takes over the data of another topic, leaving it empty.
+     *
+     * @param other The topic whose data will be taken over.
+     */
+    void moveFrom(Topic& other) noexcept;
+
     /**
      * @brief Increases the capacity of the discussion array.
      */
     void resizeDiscussions();
 
+    /**
+     * @brief Rebuilds the discussion index from the discussion array.
+     */
+    void indexDiscussions();
+
+    /**
+     * @brief Moves the discussions that were not removed over the slots of removed ones.
+     */
+    void compactDiscussions();
+
 public:
     /**
      * @brief Constructor for initializing a topic with a given title, description, and creator ID.
@@ -52,6 +75,13 @@ public:
      */
     Topic(const Topic& other);
 
+    /**
+     * @brief Move constructor for the Topic class, takes over the discussion array.
+     *
+     * @param other The topic to be moved; it is left empty and may only be assigned to or destroyed.
+     */
+    Topic(Topic&& other) noexcept;
+
     /**
      * @brief Assignment operator for the Topic class.
      *
@@ -60,6 +90,14 @@ public:
      */
     Topic& operator=(const Topic& other);
 
+    /**
+     * @brief Move assignment operator for the Topic class.
+     *
+     * @param other The topic to be moved; it is left empty and may only be assigned to or destroyed.
+     * @return Reference to the assigned topic.
+     */
+    Topic& operator=(Topic&& other) noexcept;
+
     /**
      * @brief Destructor for the Topic class.
      */
@@ -87,28 +125,40 @@ public:
     void setCreatorId(unsigned int id);
 
     /**
-     * @brief Increases the number of discussions in the topic by one.
+     * @brief Adds a new discussion to the topic under the next discussion ID.
+     *
+     * The topic must be loaded, see isLoaded.
+     *
+     * @param discussionTitle Discussion title.
+     * @param discussionContents Discussion content.
+     * @param creatorId Discussion creator ID.
      */
-    void discussionNumIncrement();
+    void addDiscussion(const std::string& discussionTitle, const std::string& discussionContents, unsigned int creatorId);
 
     /**
-     * @brief Decreases the number of discussions in the topic by one.
+     * @brief Removes a discussion from the topic.
+     *
+     * The slot is left empty and reclaimed once removed discussions fill half of the array.
+     * The topic must be loaded, see isLoaded.
+     *
+     * @param discussionId Discussion ID.
+     * @return True if the discussion was removed, false if there is no such discussion.
      */
-    void discussionNumDecrement();
+    bool removeDiscussion(unsigned int discussionId);
 
     /**
      * @brief Returns the topic title.
      *
-     * @return Topic title.
+     * @return View of the topic title, valid until the title is changed.
      */
-    std::string getTopicTitle() const;
+    std::string_view getTopicTitle() const;
 
     /**
      * @brief Returns the topic description.
      *
-     * @return Topic description.
+     * @return View of the topic description, valid until the description is changed.
      */
-    std::string getTopicDescription() const;
+    std::string_view getTopicDescription() const;
 
     /**
      * @brief Returns the ID of the topic creator.
@@ -141,23 +191,172 @@ public:
     /**
      * @brief Returns a pointer to the array of discussions in the topic.
      *
+     * Removed discussions leave empty slots, see forEachDiscussion. The topic must be loaded, see isLoaded.
+     *
      * @return Pointer to the array of discussions in the topic.
      */
     Discussion* getTopicDiscussions() const;
 
     /**
-     * @brief Saves the topic data to a file.
+     * @brief Looks up a discussion by ID.
+     *
+     * The topic must be loaded, see isLoaded.
+     *
+     * @param discussionId Discussion ID.
+     * @return Index of the discussion in the discussions array, or -1 if there is no such discussion.
+     */
+    int findDiscussion(unsigned int discussionId) const;
+
+    /**
+     * @brief Calls a function with every discussion of the topic in the order they were added, skipping removed ones.
+     *
+     * The topic must be loaded, see isLoaded.
+     *
+     * @param visit Function taking the discussion.
+     */
+    template <typename Visit>
+    void forEachDiscussion(Visit&& visit) const {
+        for (unsigned int i = 0; i < discussionNum; i++) {
+            if (!removedDiscussions[i]) {
+                visit(static_cast<const Discussion&>(discussions[i]));
+            }
+        }
+    }
+
+    /**
+     * @brief Lists the fields of a topic stored in old-format files, discussions included.
+     *
+     * Instantiated with BinaryReader to load a topic; files are only written as snapshots.
+     *
+     * @param archive Binary reader.
+     * @param self The topic.
+     */
+    template <typename Archive, typename Self>
+    static void schema(Archive& archive, Self& self) {
+        unsigned int discussionNum = 0;
+        archive(self.title, self.topicDescription, self.creatorId, self.id, discussionNum, self.discussionID);
+        if (!archive.good()) {
+            return;
+        }
+        // the array is reallocated at its final size; resizing would copy elements it does not hold yet
+        delete[] self.discussions;
+        self.discussionNum = discussionNum;
+        self.discussionCapacity = discussionNum < 2 ? 2 : discussionNum + 1;
+        self.discussions = new Discussion[self.discussionCapacity];
+        self.removedDiscussionNum = 0;
+        self.removedDiscussions.assign(discussionNum, false);
+        archive.elements(self.discussions, discussionNum);
+        self.indexDiscussions();
+    }
+
+    /**
+     * @brief Reads topic data from a file, discussions included.
+     *
+     * @param reader Binary reader.
+     */
+    void readFromFile(BinaryReader& reader);
+
+    /**
+     * @brief Fills a reserved topic record of a snapshot, discussions included.
+     *
+     * @param writer Snapshot writer.
+     * @param index Index of the reserved topic record.
+     * @return True if the topic was written, false if its discussions could not be read from the loaded snapshot.
+     */
+    bool writeToSnapshot(SnapshotWriter& writer, std::uint32_t index) const;
+
+    /**
+     * @brief Reads the topic and its discussions from a snapshot record.
+     *
+     * Topics are independent of each other and may be read on several threads at once,
+     * so the identifier counter is left to setNextTopicId.
+     *
+     * @param reader Snapshot reader.
+     * @param record The topic record.
+     * @param lazy Whether only the topic header is read, leaving the discussions for loadDiscussions.
+     * @return True if the record is valid, otherwise false.
+     */
+    bool readFromSnapshot(const SnapshotReader& reader, const SnapshotTopicRecord& record, bool lazy = false);
+
+    /**
+     * @brief Sets the identifier given to the next new topic.
+     *
+     * @param nextId Identifier of the next topic.
+     */
+    static void setNextTopicId(unsigned int nextId);
+
+    /**
+     * @brief Checks whether the discussions of the topic are in memory.
+     *
+     * @return True if the discussions are loaded, otherwise false.
+     */
+    bool isLoaded() const;
+
+    /**
+     * @brief Reads the discussions of a lazily loaded topic from its snapshot.
+     *
+     * @return True if the discussions were loaded, false if the snapshot data is damaged.
+     */
+    bool loadDiscussions();
+
+    /**
+     * @brief Calls a function with the author and rating of every comment of the topic, replies included.
+     *
+     * A topic that was never opened is read straight from its snapshot records, without loading it.
+     *
+     * @param visit Function taking the author ID and the rating.
+     */
+    template <typename Visit>
+    void forEachRating(Visit&& visit) const {
+        if (source == nullptr) {
+            for (unsigned int i = 0; i < discussionNum; i++) {
+                discussions[i].forEachRating(visit);
+            }
+            return;
+        }
+        const SnapshotDiscussionRecord* discussionRecords = source->getDiscussions(firstDiscussion, discussionNum);
+        for (unsigned int i = 0; discussionRecords != nullptr && i < discussionNum; i++) {
+            forEachRecordRating(*source, discussionRecords[i].firstComment, discussionRecords[i].commentNum, visit);
+        }
+    }
+
+    /**
+     * @brief Calls a function with the author and rating of a run of snapshot comment records and of their replies.
+     *
+     * Reply runs are kept in a work list instead of being visited by recursion, and no more records
+     * are visited than the snapshot holds, so damaged reply links cannot overflow the stack or loop forever.
      *
-     * @param of Output file stream.
+     * @param reader Snapshot reader.
+     * @param first Index of the first comment record.
+     * @param count Number of comment records.
+     * @param visit Function taking the author ID and the rating.
      */
-    void writeToFile(std::ofstream& of);
+    template <typename Visit>
+    static void forEachRecordRating(const SnapshotReader& reader, std::uint32_t first, std::uint32_t count, Visit& visit) {
+        std::vector<std::pair<std::uint32_t, std::uint32_t>> runs(1, std::make_pair(first, count));
+        std::uint64_t remaining = reader.getHeader().commentCount;
+        while (!runs.empty()) {
+            std::pair<std::uint32_t, std::uint32_t> run = runs.back();
+            runs.pop_back();
+            const SnapshotCommentRecord* records = reader.getComments(run.first, run.second);
+            for (std::uint32_t i = 0; records != nullptr && i < run.second; i++) {
+                if (remaining-- == 0) {
+                    return;
+                }
+                visit(records[i].authorId, records[i].rating);
+                if (records[i].replyNum > 0) {
+                    runs.emplace_back(records[i].firstReply, records[i].replyNum);
+                }
+            }
+        }
+    }
 
     /**
-     * @brief Reads topic data from a file.
+     * @brief Copies text borrowed from a snapshot into owned storage, discussions included.
      *
-     * @param iff Input file stream.
+     * A lazily loaded topic is loaded first, so it no longer needs the snapshot.
      */
-    void readFromFile(std::ifstream& iff);
+    void detachText();
 
     // Discussion commands, just like in Discussion.h
     // Implemented in System.h
@@ -77,39 +77,48 @@ void User::changePoints(const int changeOfPoints) {
 	points += changeOfPoints;
 }
 
+/**
+ * @brief Sets the user's points.
+ *
+ * @param newPoints The new points.
+ */
+void User::setPoints(int newPoints) {
+	points = newPoints;
+}
+
 /**
  * @brief Returns the user first name.
  *
- * @return First name.
+ * @return Reference to the first name.
  */
-const std::string User::getFirstName() const {
+const std::string& User::getFirstName() const {
 	return firstName;
 }
 
 /**
  * @brief Returns the user last name.
  *
- * @return Last name.
+ * @return Reference to the last name.
  */
-const std::string User::getLastName() const {
+const std::string& User::getLastName() const {
 	return lastName;
 }
 
 /**
  * @brief Returns the user nickname.
  *
- * @return Nickname.
+ * @return Reference to the nickname.
  */
-const std::string User::getNickname() const {
+const std::string& User::getNickname() const {
 	return nickname;
 }
 
 /**
  * @brief Returns the user password.
  *
- * @return Password.
+ * @return Reference to the password.
  */
-const std::string User::getPassword() const {
+const std::string& User::getPassword() const {
 	return password;
 }
 
@@ -150,60 +159,54 @@ User* User::clone() const {
 }
 
 /**
- * @brief Saves user data to a file.
+ * @brief Reads user data from a file; the role in front of it has already been read.
  *
- * @param of Output file stream.
+ * @param reader Binary reader.
  */
-void User::writeToFile(std::ofstream& of) const {
-	of.write(reinterpret_cast<const char*>(&role), sizeof(Permission));
-
-	unsigned int size = firstName.size();
-	of.write(reinterpret_cast<const char*>(&size), sizeof(size));
-	of.write((const char*)&firstName[0], size);
-
-	size = lastName.size();
-	of.write(reinterpret_cast<const char*>(&size), sizeof(size));
-	of.write((const char*)&lastName[0], size);
-
-	size = nickname.size();
-	of.write(reinterpret_cast<const char*>(&size), sizeof(size));
-	of.write((const char*)&nickname[0], size);
-
-	size = password.size();
-	of.write(reinterpret_cast<const char*>(&size), sizeof(size));
-	of.write((const char*)&password[0], size);
+void User::readFromFile(BinaryReader& reader) {
+	schema(reader, *this);
 
-	of.write(reinterpret_cast<const char*>(&id), sizeof(id));
-	of.write(reinterpret_cast<const char*>(&points), sizeof(points));
-	of.write(reinterpret_cast<const char*>(&role), sizeof(Permission));
+	ID = id + 1; // maybe not good
 }
 
 /**
- * @brief Reads user data from a file.
+ * @brief Adds the user record to a snapshot.
  *
- * @param iff Input file stream.
+ * @param writer Snapshot writer.
  */
-void User::readFromFile(std::ifstream& iff) {
-	unsigned int size = 0;
-	iff.read(reinterpret_cast<char*>(&size), sizeof(size));
-	firstName.resize(size);
-	iff.read((char*)&firstName[0], size);
-
-	iff.read(reinterpret_cast<char*>(&size), sizeof(size));
-	lastName.resize(size);
-	iff.read((char*)&lastName[0], size);
-
-	iff.read(reinterpret_cast<char*>(&size), sizeof(size));
-	nickname.resize(size);
-	iff.read((char*)&nickname[0], size);
-
-	iff.read(reinterpret_cast<char*>(&size), sizeof(size));
-	password.resize(size);
-	iff.read((char*)&password[0], size);
+void User::writeToSnapshot(SnapshotWriter& writer) const {
+	SnapshotUserRecord record{};
+	record.firstName = writer.addString(firstName);
+	record.lastName = writer.addString(lastName);
+	record.nickname = writer.addString(nickname);
+	record.password = writer.addString(password);
+	record.id = id;
+	record.points = points;
+	record.role = static_cast<std::int32_t>(role);
+	writer.addUser(record);
+}
 
-	iff.read(reinterpret_cast<char*>(&id), sizeof(id));
-	iff.read(reinterpret_cast<char*>(&points), sizeof(points));
-	iff.read(reinterpret_cast<char*>(&role), sizeof(Permission));
+/**
+ * @brief Reads user data from a snapshot record.
+ *
+ * @param reader Snapshot reader.
+ * @param record The user record.
+ * @return True if the record is valid, otherwise false.
+ */
+bool User::readFromSnapshot(const SnapshotReader& reader, const SnapshotUserRecord& record) {
+	std::string_view first, last, nick, pass;
+	if (!reader.getString(record.firstName, first) || !reader.getString(record.lastName, last) ||
+		!reader.getString(record.nickname, nick) || !reader.getString(record.password, pass)) {
+		return false;
+	}
+	firstName = first;
+	lastName = last;
+	nickname = nick;
+	password = pass;
+	id = record.id;
+	points = record.points;
+	role = static_cast<Permission>(record.role);
 
-	ID = id + 1; // maybe not good
+	ID = id + 1;
+	return true;
 }
@@ -3,6 +3,8 @@
 #include <string>
 #include <cstring>
 #include <fstream>
+#include "Snapshot.h"
+#include "BinaryReader.h"
 
 /**
  * @enum Permission
@@ -93,33 +95,40 @@ public:
      */
     void changePoints(const int changeOfPoints);
 
+    /**
+     * @brief Sets the user's points.
+     *
+     * @param newPoints The new points.
+     */
+    void setPoints(int newPoints);
+
     /**
      * @brief Returns the user first name.
      *
-     * @return First name.
+     * @return Reference to the first name.
      */
-    const std::string getFirstName() const;
+    const std::string& getFirstName() const;
 
     /**
      * @brief Returns the user last name.
      *
-     * @return Last name.
+     * @return Reference to the last name.
      */
-    const std::string getLastName() const;
+    const std::string& getLastName() const;
 
     /**
      * @brief Returns the user nickname.
      *
-     * @return Nickname.
+     * @return Reference to the nickname.
      */
-    const std::string getNickname() const;
+    const std::string& getNickname() const;
 
     /**
      * @brief Returns the user password.
      *
-     * @return Password.
+     * @return Reference to the password.
      */
-    const std::string getPassword() const;
+    const std::string& getPassword() const;
 
     /**
      * @brief Returns the user permission role.
@@ -150,16 +159,38 @@ public:
     virtual User* clone() const;
 
     /**
-     * @brief Saves user data to a file.
+     * @brief Lists the fields of a user stored in old-format files; moderators store the same fields.
+     *
+     * Instantiated with BinaryReader to load a user; files are only written as snapshots.
+     *
+     * @param archive Binary reader.
+     * @param self The user.
+     */
+    template <typename Archive, typename Self>
+    static void schema(Archive& archive, Self& self) {
+        archive(self.firstName, self.lastName, self.nickname, self.password, self.id, self.points, self.role);
+    }
+
+    /**
+     * @brief Reads user data from a file; the role in front of it has already been read.
+     *
+     * @param reader Binary reader.
+     */
+    void readFromFile(BinaryReader& reader);
+
+    /**
+     * @brief Adds the user record to a snapshot.
      *
-     * @param of Output file stream.
+     * @param writer Snapshot writer.
      */
-    virtual void writeToFile(std::ofstream& of) const;
+    virtual void writeToSnapshot(SnapshotWriter& writer) const;
 
     /**
-     * @brief Reads user data from a file.
+     * @brief Reads user data from a snapshot record.
      *
-     * @param iff Input file stream.
+     * @param reader Snapshot reader.
+     * @param record The user record.
+     * @return True if the record is valid, otherwise false.
      */
-    virtual void readFromFile(std::ifstream& iff);
+    virtual bool readFromSnapshot(const SnapshotReader& reader, const SnapshotUserRecord& record);
 };